@@ -0,0 +1,150 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// bench.cc
+// Object Clustering
+// Benchmarks for every stage of the pipeline and for the whole of it, on the
+// image pairs of a directory. The results are printed and can be saved as
+// JSON, and compared with the ones of a previous run: the exit code is 2 if
+// a median got slower by more than the tolerance.
+// Usage: bench [--images dir] [--output results.json]
+//              [--baseline old.json] [--tolerance 0.1] [--filter name]
+//              [--min-samples N] [--min-seconds S] [--rows 10000,100000]
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "pipeline_benchmark.h"
+
+namespace oc = object_clustering;
+
+namespace {
+// The command line:
+struct Options {
+  std::string image_directory = "images";
+  std::string output_name;  // the results are not saved if empty
+  std::string baseline_name;  // nothing to compare with if empty
+  double tolerance = oc::kBenchmarkRegressionTolerance;
+  std::string filter;  // every benchmark if empty
+  int min_samples = oc::kBenchmarkMinSamples;
+  double min_seconds = oc::kBenchmarkMinSeconds;
+  // the sizes of the synthetic sets, oc::kSyntheticFeatureRows if empty:
+  std::vector<int> synthetic_rows;
+};
+
+void PrintUsage() {
+  printf("Usage: bench [options] \n");
+  printf("Options: \n");
+  printf("  --images dir         the N-1.png/N-2.png pairs (default images) \n");
+  printf("  --output file        save the results as JSON, one per line \n");
+  printf("  --baseline file      compare with the results of a previous run \n");
+  printf("  --tolerance X        slower medians which are regressions \n");
+  printf("                       (default 0.1, that is 10%%) \n");
+  printf("  --filter name        run the benchmarks whose names contain name \n");
+  printf("  --min-samples N      samples per benchmark (default 10) \n");
+  printf("  --min-seconds S      seconds per benchmark (default 1) \n");
+  printf("  --rows N,M,...       rows of the synthetic clustering sets \n");
+  printf("                       (default 10000) \n");
+}
+// Reads a comma separated list of positive numbers into rows; returns false
+// if there is anything else.
+// rows should not be NULL.
+bool ParseRows(const std::string &list, std::vector<int> *rows) {
+  rows->clear();
+  size_t begin = 0;
+  while (begin <= list.size()) {
+    size_t end = list.find(',', begin);
+    if (end == std::string::npos) end = list.size();
+    std::string number = list.substr(begin, end - begin);
+    char *parsed_end = nullptr;
+    long num_of_rows = strtol(number.c_str(), &parsed_end, 10);
+    if (number.empty() || (*parsed_end != '\0') || (num_of_rows <= 0) ||
+        (num_of_rows > INT_MAX)) {
+      return false;
+    }
+    rows->push_back(static_cast<int>(num_of_rows));
+    begin = end + 1;
+  }
+  return true;
+}
+// Returns false on an unknown or incomplete option.
+// options should not be NULL.
+bool ParseOptions(int argc, char **argv, Options *options) {
+  for (int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+    if ((strcmp(argv[i], "--images") == 0) && has_value) {
+      options->image_directory = argv[++i];
+    } else if ((strcmp(argv[i], "--output") == 0) && has_value) {
+      options->output_name = argv[++i];
+    } else if ((strcmp(argv[i], "--baseline") == 0) && has_value) {
+      options->baseline_name = argv[++i];
+    } else if ((strcmp(argv[i], "--tolerance") == 0) && has_value) {
+      options->tolerance = atof(argv[++i]);
+      if (options->tolerance < 0) return false;
+    } else if ((strcmp(argv[i], "--filter") == 0) && has_value) {
+      options->filter = argv[++i];
+    } else if ((strcmp(argv[i], "--min-samples") == 0) && has_value) {
+      options->min_samples = atoi(argv[++i]);
+      if (options->min_samples <= 0) return false;
+    } else if ((strcmp(argv[i], "--min-seconds") == 0) && has_value) {
+      options->min_seconds = atof(argv[++i]);
+      if (options->min_seconds < 0) return false;
+    } else if ((strcmp(argv[i], "--rows") == 0) && has_value) {
+      if (!ParseRows(argv[++i], &options->synthetic_rows)) return false;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  try {
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+      PrintUsage();
+      std::exit(1);
+    }
+    // 1. Read the baseline first, so that a wrong name fails fast:
+    std::vector<oc::BenchmarkResult> baseline;
+    if (!options.baseline_name.empty() &&
+        !oc::BenchmarkRunner::ReadResults(options.baseline_name, &baseline)) {
+      fprintf(stderr, "Could not read the results from %s \n",
+              options.baseline_name.c_str());
+      std::exit(1);
+    }
+    // 2. Run the benchmarks:
+    oc::PipelineBenchmark benchmark(options.image_directory);
+    printf("%d image pairs, %d objects \n", benchmark.num_of_pairs(),
+           benchmark.num_of_objects());
+    if (!options.synthetic_rows.empty()) {
+      benchmark.set_synthetic_rows(options.synthetic_rows);
+    }
+    oc::BenchmarkRunner runner;
+    runner.set_min_samples(options.min_samples);
+    runner.set_min_seconds(options.min_seconds);
+    benchmark.RunAll(&runner, options.filter);
+    // 3. Save and compare them:
+    if (!options.output_name.empty() &&
+        !runner.WriteResults(options.output_name)) {
+      fprintf(stderr, "Could not write the results to %s \n",
+              options.output_name.c_str());
+      std::exit(1);
+    }
+    if (!baseline.empty()) {
+      int num_of_regressions = runner.CompareWith(baseline, options.tolerance);
+      printf("%d regressions \n", num_of_regressions);
+      if (num_of_regressions > 0) return 2;
+    }
+    return 0;
+  } catch (const std::exception &error) {
+    fprintf(stderr, "%s \n", error.what());
+    std::exit(1);
+  }
+}
@@ -0,0 +1,231 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// benchmark.h
+// Object clustering
+// A small benchmark runner: times a piece of code many times and reports its
+// throughput, the percentiles of its latency and their spread, and writes or
+// reads the results as JSON, so that two runs can be compared.
+#ifndef OBJECT_CLUSTERING_BENCHMARK_H_
+#define OBJECT_CLUSTERING_BENCHMARK_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace object_clustering {
+// The default limits of a benchmark: it runs for at least this many samples
+// and at least this long, after the warm-up samples, which are not counted:
+const int kBenchmarkMinSamples = 10;
+const double kBenchmarkMinSeconds = 1.0;
+const int kBenchmarkWarmUpSamples = 2;
+// A slower median than the baseline one by more than this fraction is a
+// regression:
+const double kBenchmarkRegressionTolerance = 0.1;
+// What a benchmark measured; the times are in milliseconds per sample, and a
+// sample processes items_per_sample items (frames, objects, ...).
+struct BenchmarkResult {
+  std::string name;
+  int num_of_samples = 0;
+  double items_per_sample = 1;
+  double mean_ms = 0;
+  double stddev_ms = 0;
+  double min_ms = 0;
+  double p50_ms = 0;
+  double p90_ms = 0;
+  double p99_ms = 0;
+  double max_ms = 0;
+  double items_per_second = 0;
+};
+// Runs every benchmark given to it, prints a line for each, and keeps their
+// results. A sample is one call of body(sample); prepare(sample), if given,
+// runs right before it and is not timed, so it can copy the input body works
+// in place on.
+// Usage:
+// object_clustering::BenchmarkRunner runner;
+// runner.Run("extract_features", num_of_objects, [&](int sample) {
+//   ExtractFeatures(objects, &features);
+// });
+// runner.WriteResults("results.json");
+class BenchmarkRunner {
+ public:
+  BenchmarkRunner() = default;
+
+  BenchmarkRunner(const BenchmarkRunner &runner) = default;
+
+  BenchmarkRunner& operator=(const BenchmarkRunner &runner) = default;
+
+  virtual ~BenchmarkRunner() = default;
+  // Times body until both min_samples() and min_seconds() are reached, and
+  // returns the result, which is kept as well.
+  // items_per_sample should be > 0.
+  BenchmarkResult Run(
+      const std::string &name,
+      const double &items_per_sample,
+      const std::function<void(int)> &body,
+      const std::function<void(int)> &prepare = nullptr) {
+    assert(items_per_sample > 0);
+    typedef std::chrono::steady_clock Clock;
+    for (int sample = 0; sample < kBenchmarkWarmUpSamples; sample++) {
+      if (prepare) prepare(sample);
+      body(sample);
+    }
+    std::vector<double> samples_ms;
+    double total_seconds = 0;
+    while ((static_cast<int>(samples_ms.size()) < min_samples_) ||
+           (total_seconds < min_seconds_)) {
+      int sample = static_cast<int>(samples_ms.size());
+      if (prepare) prepare(sample);
+      auto start = Clock::now();
+      body(sample);
+      std::chrono::duration<double> elapsed = Clock::now() - start;
+      samples_ms.push_back(elapsed.count() * 1000);
+      total_seconds += elapsed.count();
+    }
+    results_.push_back(ComputeResult(name, items_per_sample, samples_ms));
+    const BenchmarkResult &result = results_.back();
+    printf("%-28s %6d samples  p50 %9.3f ms  p90 %9.3f ms  p99 %9.3f ms  "
+           "cv %5.1f%%  %10.1f items/s \n",
+           result.name.c_str(), result.num_of_samples, result.p50_ms,
+           result.p90_ms, result.p99_ms,
+           result.mean_ms > 0 ? 100 * result.stddev_ms / result.mean_ms : 0,
+           result.items_per_second);
+    return result;
+  }
+  // Writes the results, one JSON object per line, as ResultWriter writes its
+  // records. Returns false if the file cannot be written.
+  bool WriteResults(const std::string &filename) const {
+    FILE *file = fopen(filename.c_str(), "w");
+    if (file == nullptr) return false;
+    for (const auto &result : results_) {
+      fprintf(file,
+              "{\"name\": \"%s\", \"num_of_samples\": %d, "
+              "\"items_per_sample\": %.6f, \"mean_ms\": %.6f, "
+              "\"stddev_ms\": %.6f, \"min_ms\": %.6f, \"p50_ms\": %.6f, "
+              "\"p90_ms\": %.6f, \"p99_ms\": %.6f, \"max_ms\": %.6f, "
+              "\"items_per_second\": %.6f}\n",
+              result.name.c_str(), result.num_of_samples,
+              result.items_per_sample, result.mean_ms, result.stddev_ms,
+              result.min_ms, result.p50_ms, result.p90_ms, result.p99_ms,
+              result.max_ms, result.items_per_second);
+    }
+    return fclose(file) == 0;
+  }
+  // Reads the results written by WriteResults(..). Returns false if the file
+  // cannot be read or a line is not such a result.
+  // results should not be NULL.
+  static bool ReadResults(const std::string &filename,
+                          std::vector<BenchmarkResult> *results) {
+    assert(results != nullptr);
+    results->clear();
+    FILE *file = fopen(filename.c_str(), "r");
+    if (file == nullptr) return false;
+    char line[1024];
+    bool succeeded = true;
+    while (succeeded && (fgets(line, sizeof(line), file) != nullptr)) {
+      BenchmarkResult result;
+      char name[256];
+      succeeded = sscanf(line,
+                         "{\"name\": \"%255[^\"]\", \"num_of_samples\": %d, "
+                         "\"items_per_sample\": %lf, \"mean_ms\": %lf, "
+                         "\"stddev_ms\": %lf, \"min_ms\": %lf, "
+                         "\"p50_ms\": %lf, \"p90_ms\": %lf, \"p99_ms\": %lf, "
+                         "\"max_ms\": %lf, \"items_per_second\": %lf}",
+                         name, &result.num_of_samples,
+                         &result.items_per_sample, &result.mean_ms,
+                         &result.stddev_ms, &result.min_ms, &result.p50_ms,
+                         &result.p90_ms, &result.p99_ms, &result.max_ms,
+                         &result.items_per_second) == 11;
+      result.name = name;
+      results->push_back(result);
+    }
+    fclose(file);
+    return succeeded;
+  }
+  // Prints, for every result which baseline has as well, how its median
+  // changed. Returns the number of regressions: the medians slower than the
+  // baseline one by more than tolerance.
+  int CompareWith(const std::vector<BenchmarkResult> &baseline,
+                  const double &tolerance) const {
+    int num_of_regressions = 0;
+    for (const auto &result : results_) {
+      auto old_result = std::find_if(
+          baseline.begin(), baseline.end(),
+          [&](const BenchmarkResult &old) { return old.name == result.name; });
+      if ((old_result == baseline.end()) || (old_result->p50_ms <= 0)) {
+        continue;
+      }
+      double change = result.p50_ms / old_result->p50_ms - 1;
+      bool regression = change > tolerance;
+      num_of_regressions += regression;
+      printf("%-28s p50 %9.3f -> %9.3f ms  %+6.1f%%%s \n",
+             result.name.c_str(), old_result->p50_ms, result.p50_ms,
+             100 * change, regression ? " REGRESSION" : "");
+    }
+    return num_of_regressions;
+  }
+
+  const std::vector<BenchmarkResult>& results() const { return results_; }
+
+  int min_samples() const { return min_samples_; }
+  // min_samples should be > 0:
+  void set_min_samples(int min_samples) {
+    assert(min_samples > 0);
+    min_samples_ = min_samples;
+  }
+
+  double min_seconds() const { return min_seconds_; }
+  // min_seconds should be >= 0:
+  void set_min_seconds(double min_seconds) {
+    assert(min_seconds >= 0);
+    min_seconds_ = min_seconds;
+  }
+
+ private:
+  // The statistics of the samples, which should not be empty. The
+  // percentiles are the nearest-rank ones.
+  static BenchmarkResult ComputeResult(const std::string &name,
+                                       const double &items_per_sample,
+                                       std::vector<double> samples_ms) {
+    assert(!samples_ms.empty());
+    BenchmarkResult result;
+    result.name = name;
+    result.num_of_samples = static_cast<int>(samples_ms.size());
+    result.items_per_sample = items_per_sample;
+    std::sort(samples_ms.begin(), samples_ms.end());
+    double total_ms = 0;
+    for (double sample_ms : samples_ms) {
+      total_ms += sample_ms;
+    }
+    result.mean_ms = total_ms / samples_ms.size();
+    double variance = 0;
+    for (double sample_ms : samples_ms) {
+      variance += (sample_ms - result.mean_ms) * (sample_ms - result.mean_ms);
+    }
+    result.stddev_ms = std::sqrt(variance / samples_ms.size());
+    auto percentile = [&](const double &p) {
+      int rank = static_cast<int>(std::ceil(p / 100 * samples_ms.size()));
+      return samples_ms[std::max(rank, 1) - 1];
+    };
+    result.min_ms = samples_ms.front();
+    result.p50_ms = percentile(50);
+    result.p90_ms = percentile(90);
+    result.p99_ms = percentile(99);
+    result.max_ms = samples_ms.back();
+    if (total_ms > 0) {
+      result.items_per_second = items_per_sample * samples_ms.size() /
+                                (total_ms / 1000);
+    }
+    return result;
+  }
+
+  int min_samples_ = kBenchmarkMinSamples;
+  double min_seconds_ = kBenchmarkMinSeconds;
+  std::vector<BenchmarkResult> results_;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_BENCHMARK_H_
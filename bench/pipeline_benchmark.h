@@ -0,0 +1,371 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// pipeline_benchmark.h
+// Object clustering
+// A friend-benchmark class for the stages of the pipeline: the background
+// subtraction, the preprocessing, the threshold sweep, the detection, the
+// detection on the frames of a container, the features, their normalization, one K-Means run and the Elbow search by
+// cv::kmeans(..), the native and the mini-batch K-Means, and the whole
+// pipeline on the image pairs.
+#ifndef OBJECT_CLUSTERING_PIPELINE_BENCHMARK_H_
+#define OBJECT_CLUSTERING_PIPELINE_BENCHMARK_H_
+
+#include <cassert>
+#include <cstdio>
+
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "background_model.h"
+#include "benchmark.h"
+#include "cluster_model.h"
+#include "detector_workspace.h"
+#include "feature_descriptor.h"
+#include "feature_matrix.h"
+#include "frame_container.h"
+#include "image.h"
+#include "k_means_clustering_algorithm.h"
+#include "mini_batch_k_means_clustering_algorithm.h"
+#include "native_k_means_clustering_algorithm.h"
+#include "object.h"
+#include "object_detector.h"
+
+namespace object_clustering {
+// The synthetic training sets of the clustering benchmarks, which are bigger
+// than the objects of the image pairs: rows around this many centers, drawn
+// from this seed, by default of each of these sizes. The bigger sizes take
+// many samples of whole Elbow searches, so they are only run when asked for,
+// see set_synthetic_rows(..):
+const int kSyntheticFeatureClusters = 6;
+const unsigned kSyntheticFeatureSeed = 20141024;
+const int kSyntheticFeatureRows[] = {10000};
+// The pairs are the images N-1.png (the background) and N-2.png (the objects)
+// of a directory, for N = 1, 2, ... up to the first missing one. A sample of
+// the per-frame benchmarks is one pair, the pairs taken in turn, so the
+// percentiles cover all of them.
+// Usage:
+// object_clustering::BenchmarkRunner runner;
+// object_clustering::PipelineBenchmark benchmark("images");
+// benchmark.set_synthetic_rows({10000, 100000});  // not kSyntheticFeatureRows
+// benchmark.RunAll(&runner);
+class PipelineBenchmark {
+ public:
+  // Loads the pairs of image_directory and what the stages start from: the
+  // background models, the gray images, the objects and their features.
+  // Throws std::runtime_error if there is no pair.
+  explicit PipelineBenchmark(const std::string &image_directory) {
+    for (int i = 1; ; i++) {
+      std::string prefix = image_directory + "/" + std::to_string(i);
+      try {
+        backgrounds_.push_back(Image(prefix + "-1.png"));
+      } catch (const std::exception &error) {
+        break;
+      }
+      images_.push_back(Image(prefix + "-2.png"));
+    }
+    if (images_.empty()) {
+      throw std::runtime_error("no image pairs in " + image_directory);
+    }
+    for (size_t i = 0; i < images_.size(); i++) {
+      models_.push_back(BackgroundModel(backgrounds_[i]));
+      grays_.push_back(
+          detector_.ExtractForegroundAndPreprocess(images_[i], models_[i]));
+      for (auto &object : detector_.DetectObjectsFromImage(images_[i],
+                                                           models_[i])) {
+        objects_.push_back(object);
+      }
+    }
+    features_.Create(static_cast<int>(objects_.size()), kNumberOfFeatures);
+    ExtractFeatures(objects_, &features_);
+  }
+
+  PipelineBenchmark(const PipelineBenchmark &benchmark) = delete;
+
+  PipelineBenchmark& operator=(const PipelineBenchmark &benchmark) = delete;
+
+  virtual ~PipelineBenchmark() = default;
+  // Runs the benchmarks whose names contain filter (all of them if it is
+  // empty) on runner, which should not be NULL.
+  void RunAll(BenchmarkRunner *runner, const std::string &filter = "") {
+    assert(runner != nullptr);
+    runner_ = runner;
+    filter_ = filter;
+    BenchmarkDetection();
+    BenchmarkFrameContainer();
+    BenchmarkFeatures();
+    BenchmarkClustering();
+    BenchmarkSyntheticClustering();
+    BenchmarkEndToEnd();
+  }
+
+  int num_of_pairs() const { return static_cast<int>(images_.size()); }
+
+  int num_of_objects() const { return static_cast<int>(objects_.size()); }
+
+  const std::vector<int>& synthetic_rows() const { return synthetic_rows_; }
+  // The sizes of the synthetic sets; every one of them should be > 0:
+  void set_synthetic_rows(const std::vector<int> &synthetic_rows) {
+    for (int num_of_rows : synthetic_rows) {
+      assert(num_of_rows > 0);
+    }
+    synthetic_rows_ = synthetic_rows;
+  }
+
+ private:
+  // Whether filter_ selects the benchmark of this name:
+  bool Selected(const std::string &name) const {
+    return name.find(filter_) != std::string::npos;
+  }
+  // Runs the benchmark on runner_ if filter_ selects it:
+  void Run(const std::string &name,
+           const double &items_per_sample,
+           const std::function<void(int)> &body,
+           const std::function<void(int)> &prepare = nullptr) {
+    if (!Selected(name)) return;
+    runner_->Run(name, items_per_sample, body, prepare);
+  }
+  // The stages of ObjectDetector::DetectObjectsFromImage(..), one frame per
+  // sample:
+  void BenchmarkDetection() {
+    int num_of_pairs = static_cast<int>(images_.size());
+    DetectorWorkspace workspace;
+    cv::Mat mask;
+    Run("train_background_model", 1, [&](int sample) {
+      BackgroundModel model(backgrounds_[sample % num_of_pairs]);
+    });
+    // trains the background model every time, as the one-pair program does:
+    Run("compute_foreground_mask", 1, [&](int sample) {
+      int pair = sample % num_of_pairs;
+      mask = detector_.ComputeForegroundMask(images_[pair],
+                                             backgrounds_[pair]);
+    });
+    Run("subtract_background", 1, [&](int sample) {
+      int pair = sample % num_of_pairs;
+      models_[pair].ComputeRawForegroundMask(images_[pair].matrix(), &mask);
+    });
+    Run("preprocess", 1, [&](int sample) {
+      int pair = sample % num_of_pairs;
+      detector_.ExtractForegroundAndPreprocess(images_[pair], models_[pair],
+                                               &workspace);
+    });
+    cv::vector<cv::Rect> rects;
+    cv::Mat threshold_output;
+    for (auto backend : {kContoursBackend, kConnectedComponentsBackend}) {
+      ObjectDetector detector;
+      detector.set_detection_backend(backend);
+      Run(backend == kContoursBackend ? "threshold_sweep_contours" :
+                                        "threshold_sweep_blobs",
+          1, [&](int sample) {
+        rects.clear();
+        detector.DetectBoundingRectsAndEdges(grays_[sample % num_of_pairs],
+                                             &threshold_output, &rects, 0,
+                                             &workspace);
+      });
+    }
+    std::vector<Object> objects;
+    for (auto resolution : {kFullResolutionDetection, kPyramidDetection}) {
+      ObjectDetector detector;
+      detector.set_detection_resolution(resolution);
+      Run(resolution == kFullResolutionDetection ? "detect_objects" :
+                                                   "detect_objects_pyramid",
+          1, [&](int sample) {
+        int pair = sample % num_of_pairs;
+        detector.DetectObjectsFromImage(images_[pair], models_[pair],
+                                        &workspace, &objects);
+      });
+    }
+  }
+  // The detection on the images of the pairs packed into a frame container,
+  // one frame per sample: as ContainerFrameSource gives them, copied out of
+  // the mapping, and as views into the mapping, which outlives them here.
+  // The container is only written if one of them is selected, and removed
+  // after.
+  void BenchmarkFrameContainer() {
+    const std::string copy_name = "detect_objects_container_copy";
+    const std::string view_name = "detect_objects_container_view";
+    if (!Selected(copy_name) && !Selected(view_name)) return;
+    const std::string filename = "pipeline_benchmark.frames";
+    FrameContainerWriter writer(filename);
+    for (const auto &image : images_) {
+      writer.Append(image.matrix());
+    }
+    if (!writer.Close()) {
+      std::remove(filename.c_str());
+      throw std::runtime_error("cannot write " + filename);
+    }
+    int num_of_pairs = static_cast<int>(images_.size());
+    DetectorWorkspace workspace;
+    {
+      std::unique_ptr<ContainerFrameSource> source;
+      cv::Mat frame;
+      std::vector<Object> objects;
+      // the source is opened again, untimed, before the first pair:
+      Run(copy_name, 1, [&](int sample) {
+        source->NextFrame(&frame);
+        detector_.DetectObjectsFromImage(Image(frame),
+                                         models_[sample % num_of_pairs],
+                                         &workspace, &objects);
+      }, [&](int sample) {
+        if (sample % num_of_pairs == 0) {
+          source.reset(new ContainerFrameSource(filename));
+        }
+      });
+    }
+    {
+      MappedFrameContainer container(filename);
+      // the objects are views into the mapping, so they go first:
+      std::vector<Object> objects;
+      Run(view_name, 1, [&](int sample) {
+        int pair = sample % num_of_pairs;
+        detector_.DetectObjectsFromImage(container.frame(pair),
+                                         models_[pair], &workspace,
+                                         &objects);
+      });
+    }
+    std::remove(filename.c_str());
+  }
+  // The features of all the objects of the pairs at once:
+  void BenchmarkFeatures() {
+    if (objects_.empty()) return;
+    FeatureMatrix features(features_.rows(), kNumberOfFeatures);
+    Run("extract_features", features_.rows(), [&](int) {
+      ExtractFeatures(objects_, &features);
+    });
+    KMeansClusteringAlgorithm k;
+    Run("normalize_features", features_.rows(),
+        [&](int) { k.NormalizeFeatures(&features); },
+        [&](int) { features = features_; });
+  }
+  // The Elbow search, by cv::kmeans(..), by the native and by the mini-batch
+  // K-Means, over the features of the objects:
+  void BenchmarkClustering() {
+    if (objects_.empty()) return;
+    KMeansClusteringAlgorithm opencv_k;
+    NativeKMeansClusteringAlgorithm native_k;
+    MiniBatchKMeansClusteringAlgorithm mini_batch_k;
+    ClusterModel model;
+    Run("elbow_opencv", features_.rows(), [&](int) {
+      opencv_k.TrainModel(features_, &model);
+    });
+    Run("elbow_native", features_.rows(), [&](int) {
+      native_k.TrainModel(features_, &model);
+    });
+    Run("elbow_minibatch", features_.rows(), [&](int) {
+      mini_batch_k.TrainModel(features_, &model);
+    });
+  }
+  // Over a synthetic set of each of synthetic_rows_ sizes: one cold K-Means
+  // run for kSyntheticFeatureClusters clusters, as the Elbow search makes for
+  // every K, and the whole Elbow search, by cv::kmeans(..), by the native and
+  // by the mini-batch K-Means. A set is only made if one of its benchmarks is
+  // selected, one of 1M rows taking about 100 MB.
+  void BenchmarkSyntheticClustering() {
+    KMeansClusteringAlgorithm opencv_k;
+    NativeKMeansClusteringAlgorithm native_k;
+    MiniBatchKMeansClusteringAlgorithm mini_batch_k;
+    // RunKMeans(..) is reached through the base class, whose friend this is:
+    const KMeansClusteringAlgorithm *algorithms[] = {&opencv_k, &native_k,
+                                                     &mini_batch_k};
+    const char *algorithm_names[] = {"opencv", "native", "minibatch"};
+    for (int num_of_rows : synthetic_rows_) {
+      std::string size = std::to_string(num_of_rows);
+      std::vector<std::string> run_names;
+      std::vector<std::string> elbow_names;
+      bool selected = false;
+      for (const char *algorithm_name : algorithm_names) {
+        run_names.push_back("kmeans_" + std::string(algorithm_name) + "_" +
+                            size);
+        elbow_names.push_back("elbow_" + std::string(algorithm_name) +
+                              "_synthetic_" + size);
+        selected = selected || Selected(run_names.back()) ||
+                   Selected(elbow_names.back());
+      }
+      if (!selected) continue;
+      FeatureMatrix features;
+      MakeSyntheticFeatures(num_of_rows, &features);
+      FeatureMatrix no_previous_centers;
+      std::vector<int> labels;
+      FeatureMatrix centers;
+      ClusterModel model;
+      for (size_t a = 0; a < run_names.size(); a++) {
+        Run(run_names[a], num_of_rows, [&](int) {
+          algorithms[a]->RunKMeans(features, kSyntheticFeatureClusters,
+                                   no_previous_centers, &labels, &centers);
+        });
+      }
+      for (size_t a = 0; a < elbow_names.size(); a++) {
+        Run(elbow_names[a], num_of_rows, [&](int) {
+          algorithms[a]->TrainModel(features, &model);
+        });
+      }
+    }
+  }
+  // The whole pipeline, one pair per sample: as the one-pair program runs
+  // it, and as the streaming mode with a model runs it on every frame.
+  void BenchmarkEndToEnd() {
+    int num_of_pairs = static_cast<int>(images_.size());
+    KMeansClusteringAlgorithm k;
+    Run("end_to_end", 1, [&](int sample) {
+      int pair = sample % num_of_pairs;
+      auto objects = detector_.DetectObjectsFromImage(images_[pair],
+                                                      backgrounds_[pair]);
+      if (!objects.empty()) k.AssignGroupsToObjects(&objects);
+    });
+    if (objects_.empty()) return;
+    ClusterModel model;
+    k.TrainModel(features_, &model);
+    DetectorWorkspace workspace;
+    std::vector<Object> objects;
+    Run("end_to_end_stream", 1, [&](int sample) {
+      int pair = sample % num_of_pairs;
+      detector_.DetectObjectsFromImage(images_[pair], models_[pair],
+                                       &workspace, &objects);
+      model.AssignGroupsToObjects(&objects, nullptr);
+    });
+  }
+  // Fills features with num_of_rows rows, normally distributed around
+  // kSyntheticFeatureClusters random centers.
+  // num_of_rows should be > 0; features should not be NULL.
+  static void MakeSyntheticFeatures(const int &num_of_rows,
+                                    FeatureMatrix *features) {
+    assert(num_of_rows > 0);
+    assert(features != nullptr);
+    std::mt19937 generator(kSyntheticFeatureSeed);
+    std::uniform_real_distribution<float> center_value(0, 100);
+    std::normal_distribution<float> noise(0, 5);
+    FeatureMatrix centers(kSyntheticFeatureClusters, kNumberOfFeatures);
+    for (int i = 0; i < centers.rows(); i++) {
+      for (int j = 0; j < kNumberOfFeatures; j++) {
+        centers.at(i, j) = center_value(generator);
+      }
+    }
+    features->Create(num_of_rows, kNumberOfFeatures);
+    for (int i = 0; i < features->rows(); i++) {
+      for (int j = 0; j < kNumberOfFeatures; j++) {
+        features->at(i, j) = centers.at(i % centers.rows(), j) +
+                             noise(generator);
+      }
+    }
+  }
+
+  ObjectDetector detector_;
+  std::vector<Image> images_;
+  std::vector<Image> backgrounds_;
+  std::vector<BackgroundModel> models_;
+  std::vector<cv::Mat> grays_;  // preprocessed, by detector_
+  std::vector<Object> objects_;  // of every pair
+  FeatureMatrix features_;  // of objects_, unnormalized
+  std::vector<int> synthetic_rows_ = std::vector<int>(
+      std::begin(kSyntheticFeatureRows), std::end(kSyntheticFeatureRows));
+  BenchmarkRunner *runner_ = nullptr;  // set by RunAll(..)
+  std::string filter_;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_PIPELINE_BENCHMARK_H_
@@ -26,9 +26,14 @@ class AbstractClusterAlgorithm {
 
   virtual ~AbstractClusterAlgorithm() = default;
   // any clustering algorithm should be able to label a vector of objects;
-  // basically, this method should set_group() of the objects
+  // basically, this method should set_group() of the objects and return the
+  // number of groups (0 for no objects)
   virtual int AssignGroupsToObjects(std::vector<Object> *objects) const =
   0;
+  // true if an object gets the same group whatever the other objects of the
+  // call, so that the groups of objects labeled by different calls mean the
+  // same; most algorithms number the groups anew on every call:
+  virtual bool keeps_groups() const { return false; }
   // an algorithm is identified by its name:
   std::string get_name() const { return name_; }
 
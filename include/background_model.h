@@ -0,0 +1,126 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// background_model.h
+// Object Clustering
+// Declares a background subtraction model which is trained once from images
+// of the clear background and then compared against many frames.
+
+#ifndef OBJECT_CLUSTERING_BACKGROUND_MODEL_H_
+#define OBJECT_CLUSTERING_BACKGROUND_MODEL_H_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/video/background_segm.hpp"
+
+#include "image.h"
+
+namespace object_clustering {
+// Parameters of the background subtractor:
+const int kBackgroundHistory = 2;  // frames
+const float kBackgroundVarThreshold = 50;
+const float kBackgroundVarInit = 100;
+const float kShadowThreshold = 0.05;
+// The coarse frames are halved this many times, see DownscaleFrame(..):
+const int kCoarseLevels = 2;
+// Downscales frame kCoarseLevels times by cv::pyrDown(..), so a pixel of
+// coarse_frame covers (1 << kCoarseLevels) pixels of frame in each direction.
+// coarse_frame should not be NULL.
+void DownscaleFrame(const cv::Mat &frame, cv::Mat *coarse_frame);
+// Same as above, but levels[i] gets frame halved i + 1 times, so the coarse
+// frame is levels[kCoarseLevels - 1]. Matrices of the right size are written
+// in place, so reusing levels for frames of one size allocates nothing.
+// levels should hold kCoarseLevels matrices.
+void DownscaleFrameLevels(const cv::Mat &frame, cv::Mat *levels);
+// Wraps an OpenCV BackgroundSubtractorMOG2 trained from the background. The
+// trained state is never changed afterwards: every frame is only compared
+// against it, as the subtractor would compare it at learning rate 0, so the
+// result for a frame does not depend on the frames compared before, and one
+// model can be shared by many threads. Copies of a model share the trained
+// state.
+// A second, coarse model is trained from the downscaled backgrounds the first
+// time it is needed.
+// Usage:
+// object_clustering::Image background = ...;
+// object_clustering::BackgroundModel model(background);
+// cv::Mat mask;
+// model.ComputeRawForegroundMask(image.matrix(), &mask);
+class BackgroundModel {
+ public:
+  // A model without a background is not a model:
+  BackgroundModel() = delete;
+  // The model is trained from a single image of the background:
+  explicit BackgroundModel(const Image &background);
+  // The model is trained from several images of the same background, for
+  // example with different lighting. backgrounds should not be empty and all
+  // of them should be of the same size and type.
+  explicit BackgroundModel(const std::vector<Image> &backgrounds);
+
+  BackgroundModel(const BackgroundModel &model) = default;
+
+  BackgroundModel& operator=(const BackgroundModel &model) = default;
+
+  virtual ~BackgroundModel() = default;
+  // Computes the mask of the foreground of the image: 255 for the foreground,
+  // kShadowIntensity for the shadow and 0 for the background. This is what a
+  // subtractor fed with the background images and then with image, at
+  // learning rate 0, gives. raw_mask is written in place if it is of the
+  // right size already.
+  // image should be of the size and type of the background; raw_mask should
+  // not be NULL.
+  void ComputeRawForegroundMask(const cv::Mat &image, cv::Mat *raw_mask) const;
+  // Same as above, but only for a region of the frame: image should be the
+  // region of the frame, and region should say where it is. raw_mask is the
+  // same as the region of the mask of the whole frame, since every pixel is
+  // compared only against its own background distribution.
+  // region should be inside the frame; raw_mask should not be NULL.
+  void ComputeRawForegroundMask(const cv::Mat &image,
+                                const cv::Rect &region,
+                                cv::Mat *raw_mask) const;
+  // Same as the first one, but for a frame downscaled by DownscaleFrame(..),
+  // compared against the downscaled backgrounds.
+  // coarse_image should be of coarse_frame_size(); raw_mask should not be
+  // NULL.
+  void ComputeCoarseRawForegroundMask(const cv::Mat &coarse_image,
+                                      cv::Mat *raw_mask) const;
+
+  cv::Size frame_size() const { return trained_->frame_size(); }
+
+  cv::Size coarse_frame_size() const;
+
+ private:
+  // Gives access to the state of the OpenCV subtractor, in order to compare
+  // the frames against it without changing it:
+  class Subtractor : public cv::BackgroundSubtractorMOG2 {
+   public:
+    Subtractor();
+    // Computes the mask operator()(frame, mask, 0) would give for the pixels
+    // of region, without changing the state. image should be the region of
+    // the frame, of the type of the trained frames; region should be inside
+    // the frame; raw_mask should not be NULL.
+    void Classify(const cv::Mat &image,
+                  const cv::Rect &region,
+                  cv::Mat *raw_mask) const;
+
+    cv::Size frame_size() const { return frameSize; }
+
+  };
+  // The coarse model, trained on the first use by any of the copies:
+  struct CoarseModel {
+    std::vector<cv::Mat> backgrounds;
+    std::once_flag trained;
+    std::shared_ptr<const Subtractor> subtractor;
+  };
+  // Returns a subtractor trained on backgrounds:
+  static std::shared_ptr<const Subtractor> Train(
+      const std::vector<cv::Mat> &backgrounds);
+  // Trains the coarse model, if it is not trained yet, and returns it:
+  const Subtractor& coarse() const;
+
+  // trained once in the constructor, read-only afterwards:
+  std::shared_ptr<const Subtractor> trained_;
+  std::shared_ptr<CoarseModel> coarse_;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_BACKGROUND_MODEL_H_
@@ -0,0 +1,100 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// batch_processor.h
+// Object Clustering
+// Declares a class which detects and clusters the objects of many
+// background/image pairs in parallel.
+
+#ifndef OBJECT_CLUSTERING_BATCH_PROCESSOR_H_
+#define OBJECT_CLUSTERING_BATCH_PROCESSOR_H_
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "abstract_cluster_algorithm.h"
+#include "image_source.h"
+#include "object_detector.h"
+#include "result_writer.h"
+
+namespace object_clustering {
+// One background/image pair of a batch:
+struct BatchItem {
+  std::string background_path;
+  std::string image_path;
+};
+// The result of one pair. Only the positions and groups of the objects are
+// kept, not their pixels, so a large batch does not fill the memory:
+struct BatchResult {
+  int index = 0;  // position of the pair in the batch
+  BatchItem item;
+  bool succeeded = false;
+  std::string error;  // why the pair failed, if it did
+  std::vector<cv::Rect> rects;  // one per object
+  std::vector<int> groups;  // the group of every object
+  int num_of_groups = 0;
+  double milliseconds = 0;  // time spent on the pair
+};
+// Reads a manifest: every line holds the paths of a background and of an
+// image, separated by whitespace. Empty lines and lines starting with '#' are
+// ignored. Returns false if the file cannot be read.
+// items should not be NULL.
+bool ReadBatchManifest(const std::string &filename,
+                       std::vector<BatchItem> *items);
+// Finds the pairs named like the sample images: N-1.png is the background of
+// N-2.png. The pairs are ordered by N. Returns false if the directory cannot
+// be read.
+// items should not be NULL.
+bool FindBatchPairsInDirectory(const std::string &directory,
+                               std::vector<BatchItem> *items);
+// Writes the result as one tab-separated line:
+// index, background, image, "ok" or the error, number of objects, number of
+// groups, milliseconds, then "x,y,width,height:group" for every object.
+// file should not be NULL.
+void WriteBatchResult(const BatchResult &result, FILE *file);
+// Processes every pair on a pool of threads. A pair which fails (cannot be
+// read, sizes differ, OpenCV error) gets a failed result; the others are not
+// affected.
+// Usage:
+// object_clustering::BatchProcessor processor(detector, clusterer, 8);
+// auto results = processor.Process(items);
+class BatchProcessor {
+ public:
+  BatchProcessor() = delete;
+  // The detector and the clusterer should outlive the processor;
+  // num_of_threads <= 0 means one thread per hardware thread.
+  BatchProcessor(const ObjectDetector &detector,
+                 const AbstractClusterAlgorithm &clusterer,
+                 const int &num_of_threads);
+
+  BatchProcessor(const BatchProcessor &processor) = delete;
+
+  BatchProcessor& operator=(const BatchProcessor &processor) = delete;
+
+  virtual ~BatchProcessor() = default;
+  // Returns one result per item, in the order of items.
+  std::vector<BatchResult> Process(const std::vector<BatchItem> &items) const;
+  // If set, the succeeded pairs are also written by writer, named by their
+  // index. writer should outlive the processing; NULL turns it off.
+  void set_result_writer(ResultWriter *writer) { result_writer_ = writer; }
+  // If set, the backgrounds are taken from cache, so a background shared by
+  // many pairs is decoded once. cache should outlive the processing; NULL
+  // turns it off.
+  void set_background_cache(DecodedImageCache *cache) {
+    background_cache_ = cache;
+  }
+
+ private:
+  // Processes one pair, catching its errors:
+  BatchResult ProcessItem(const int &index, const BatchItem &item) const;
+
+  const ObjectDetector &detector_;
+  const AbstractClusterAlgorithm &clusterer_;
+  int num_of_threads_;
+  ResultWriter *result_writer_ = nullptr;
+  DecodedImageCache *background_cache_ = nullptr;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_BATCH_PROCESSOR_H_
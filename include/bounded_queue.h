@@ -0,0 +1,78 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// bounded_queue.h
+// Object Clustering
+// Declares a thread-safe queue of limited capacity, used to connect the
+// stages of a pipeline.
+
+#ifndef OBJECT_CLUSTERING_BOUNDED_QUEUE_H_
+#define OBJECT_CLUSTERING_BOUNDED_QUEUE_H_
+
+#include <cassert>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace object_clustering {
+// Push() blocks while the queue is full and Pop() blocks while it is empty,
+// so a fast producer cannot run ahead of its consumers by more than capacity
+// items. After Close(), Push() refuses new items and Pop() returns false once
+// the remaining ones are taken.
+// Usage:
+// object_clustering::BoundedQueue<int> queue(4);
+// producer: queue.Push(1); ... queue.Close();
+// consumer: int item; while (queue.Pop(&item)) { ... }
+template <typename T>
+class BoundedQueue {
+ public:
+  // capacity should be > 0:
+  explicit BoundedQueue(const int &capacity): capacity_(capacity) {
+    assert(capacity > 0);
+  }
+  // The queue is shared by threads, it is not copied:
+  BoundedQueue(const BoundedQueue &queue) = delete;
+
+  BoundedQueue& operator=(const BoundedQueue &queue) = delete;
+
+  virtual ~BoundedQueue() = default;
+  // Returns false if the queue was closed and item was not added:
+  bool Push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] {
+      return closed_ || (items_.size() < capacity_);
+    });
+    if (closed_) return false;
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+  // Returns false if the queue is closed and empty; item should not be NULL:
+  bool Pop(T *item) {
+    assert(item != nullptr);
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+    if (items_.empty()) return false;
+    *item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+ private:
+  const size_t capacity_;
+  std::deque<T> items_;
+  bool closed_ = false;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_BOUNDED_QUEUE_H_
@@ -0,0 +1,50 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// cluster_metrics.h
+// Object Clustering
+// Declares the measures of how good a clustering of a FeatureMatrix is.
+
+#ifndef OBJECT_CLUSTERING_CLUSTER_METRICS_H_
+#define OBJECT_CLUSTERING_CLUSTER_METRICS_H_
+
+#include <cstdint>
+
+#include <vector>
+
+#include "feature_matrix.h"
+
+namespace object_clustering {
+// The silhouette compares every row with every other one, so it is computed
+// over a random sample of this many rows:
+const int kSilhouetteSampleSize = 256;
+// The sample is random, but always drawn from this seed:
+const uint64_t kSilhouetteSeed = 0x511;
+// inertia - the sum of the squared distances from the rows to their centers
+//   (the compactness of cv::kmeans(..));
+// mean_distance - the mean distance from the rows to their centers;
+// davies_bouldin - the mean, over the clusters, of the worst ratio between
+//   the scatter of two clusters and the distance of their centers; lower is
+//   better, 0 for a single cluster;
+// silhouette - the mean, over the sampled rows, of
+//   (b - a) / max(a, b), a being the mean distance to the rows of the same
+//   cluster and b the least mean distance to the rows of another cluster;
+//   from -1 to 1, higher is better, 0 for a single cluster.
+struct ClusterMetrics {
+  double inertia = 0;
+  double mean_distance = 0;
+  double davies_bouldin = 0;
+  double silhouette = 0;
+};
+// Computes the metrics of the clustering of the rows of data by labels, around
+// centers. inertia, mean_distance and the scatter of every cluster come from
+// one pass over the rows; davies_bouldin then takes the distances between the
+// centers. The silhouette takes at most silhouette_sample_size rows, drawn
+// with a reservoir in the same pass; 0 leaves it out.
+// labels should have a value in [0; centers.rows()) for every row of data;
+// data and centers should have the same columns; metrics should not be NULL.
+void ComputeClusterMetrics(const FeatureMatrix &data,
+                           const std::vector<int> &labels,
+                           const FeatureMatrix &centers,
+                           const int &silhouette_sample_size,
+                           ClusterMetrics *metrics);
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_CLUSTER_METRICS_H_
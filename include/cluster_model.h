@@ -0,0 +1,100 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// cluster_model.h
+// Object Clustering
+// Declares a trained clustering: the normalization of the features and the
+// centers of the groups. New objects are assigned to the nearest center
+// without running K-Means, and the model can be saved and loaded.
+
+#ifndef OBJECT_CLUSTERING_CLUSTER_MODEL_H_
+#define OBJECT_CLUSTERING_CLUSTER_MODEL_H_
+
+#include <string>
+#include <vector>
+
+#include "feature_descriptor.h"
+#include "feature_matrix.h"
+#include "object.h"
+
+namespace object_clustering {
+const int kClusterModelVersion = 1;
+// Normalizes the features of one example by the max and avg value of every
+// feature over a training set: (value - avg) / max, or 0.99 where max is 0.
+// The examples of the training set fall into (-1; 1); other examples may not.
+// features should not be NULL.
+void NormalizeFeatureRow(const FeatureVector &max_feature_value,
+                         const FeatureVector &avg_feature_value,
+                         float *features);
+// The groups found by KMeansClusteringAlgorithm::TrainModel(..). Assigning an
+// object costs its features and K distances, and the groups of a model do not
+// change from one frame to the next.
+// Usage:
+// object_clustering::ClusterModel model;
+// k.TrainModel(objects, &model);
+// model.Save("groups.yml");
+// ...
+// model.Load("groups.yml");
+// int num_of_groups = model.AssignGroupsToObjects(&new_objects, nullptr);
+class ClusterModel {
+ public:
+  ClusterModel() = default;
+  // centers are normalized by max_feature_value and avg_feature_value, see
+  // NormalizeFeatureRow(..); training_error is the mean distance from the
+  // training examples to their centers.
+  // centers should have kNumberOfFeatures columns.
+  ClusterModel(const FeatureVector &max_feature_value,
+               const FeatureVector &avg_feature_value,
+               const FeatureMatrix &centers,
+               const float &training_error);
+
+  ClusterModel(const ClusterModel &model) = default;
+
+  ClusterModel& operator=(const ClusterModel &model) = default;
+
+  virtual ~ClusterModel() = default;
+  // A model without centers has not been trained or loaded:
+  bool empty() const { return centers_.empty(); }
+
+  int num_of_clusters() const { return centers_.rows(); }
+
+  const FeatureVector& max_feature_value() const { return max_feature_value_; }
+
+  const FeatureVector& avg_feature_value() const { return avg_feature_value_; }
+
+  const FeatureMatrix& centers() const { return centers_; }
+
+  float training_error() const { return training_error_; }
+  // Normalizes the raw features of an example as the training set was.
+  // features should not be NULL.
+  void Normalize(float *features) const {
+    NormalizeFeatureRow(max_feature_value_, avg_feature_value_, features);
+  }
+  // Returns the cluster nearest to the raw features, and fills in the
+  // distance to it if distance is not NULL.
+  // The model should not be empty.
+  int Assign(const FeatureVector &features, float *distance) const;
+  // Sets the group of every object to its nearest cluster and fills in the
+  // distances to them if distances is not NULL. Returns num_of_clusters(), 0
+  // if objects is empty.
+  // The model should not be empty; objects should not be NULL.
+  int AssignGroupsToObjects(std::vector<Object> *objects,
+                            std::vector<float> *distances) const;
+  // Renumbers the clusters so that as many as possible keep the number of
+  // the nearest cluster of previous, nearest pairs first; the others get the
+  // numbers left. So a retrained model labels the same kind of objects as
+  // the model it replaces did.
+  void AlignTo(const ClusterModel &previous);
+  // Writes the model with cv::FileStorage; the format follows the extension
+  // (.yml or .xml). Returns false if it cannot be written.
+  bool Save(const std::string &filename) const;
+  // Reads a model written by Save(..). Returns false, leaving the model as it
+  // was, if the file cannot be read or is not a model of kNumberOfFeatures.
+  bool Load(const std::string &filename);
+
+ private:
+  FeatureVector max_feature_value_ = FeatureVector();
+  FeatureVector avg_feature_value_ = FeatureVector();
+  FeatureMatrix centers_;  // normalized
+  float training_error_ = 0;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_CLUSTER_MODEL_H_
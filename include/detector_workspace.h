@@ -0,0 +1,126 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// detector_workspace.h
+// Object Clustering
+// Declares the buffers the object detector works in, kept from one frame to
+// the next.
+
+#ifndef OBJECT_CLUSTERING_DETECTOR_WORKSPACE_H_
+#define OBJECT_CLUSTERING_DETECTOR_WORKSPACE_H_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "background_model.h"
+#include "connected_component_labeler.h"
+#include "pooling_mat_allocator.h"
+#include "rect_index.h"
+
+namespace object_clustering {
+// Everything ObjectDetector::DetectObjectsFromImage(..) builds for a frame:
+// the foreground mask, the gray image, the binary image of every threshold,
+// the contours or the blobs, and the rects. The matrices keep their pixels
+// and the vectors their capacity. Every matrix of the workspace comes from
+// its PoolingMatAllocator, so the ones whose size changes from one call to
+// the next, like the regions of kPyramidDetection, reuse the buffers of the
+// previous calls, and allocator().num_of_allocations() counts every buffer
+// the matrices of the workspace take from the system, in every mode.
+// Known limitation: OpenCV allocates its own temporaries with
+// cv::fastMalloc(..), which neither the allocator nor the heap counters see:
+// findContours(..) and approxPolyDP(..) build their sequences for
+// kContoursBackend, and pyrDown(..) its rows for kPyramidDetection. The
+// merge of the tiles of a pool allocates its own vectors, see MergeBands(..),
+// and a pool runs every task through a std::function. So the blobs of a
+// whole frame without a pool are the one mode which, once the workspace has
+// seen a frame of each size, calls no operator new at all.
+// The threshold search runs a task per threshold; every running task takes
+// a TaskScratch of its own for as long as it runs, so there are as many of
+// them as tasks running at once, not as thresholds.
+// A workspace serves one detection at a time: a thread which detects objects
+// keeps one for itself.
+// Usage:
+// object_clustering::DetectorWorkspace workspace;
+// std::vector<object_clustering::Object> objects;
+// for every frame:
+//   detector.DetectObjectsFromImage(frame, model, &workspace, &objects);
+class DetectorWorkspace {
+  friend class ObjectDetector;
+ public:
+  DetectorWorkspace();
+  // The matrices point to the allocator of the workspace, so it is not
+  // copied:
+  DetectorWorkspace(const DetectorWorkspace &workspace) = delete;
+
+  DetectorWorkspace& operator=(const DetectorWorkspace &workspace) = delete;
+
+  virtual ~DetectorWorkspace() = default;
+
+  const PoolingMatAllocator& allocator() const { return allocator_; }
+
+ private:
+  // The buffers of one task of the threshold search:
+  struct TaskScratch {
+    cv::Mat binary;
+    cv::vector<cv::vector<cv::Point>> contours;
+    cv::vector<cv::Vec4i> hierarchy;
+    cv::vector<cv::Point> polygon;  // a contour approximated
+    ConnectedComponentLabeler labeler;
+    std::vector<BlobStats> blobs;
+    std::vector<uchar> row_buffer;  // see ForegroundToBlurredGray(..)
+    std::vector<BandBlobs> bands;  // the tiles of one threshold, merged
+  };
+  // Holds a TaskScratch which no other task holds, from its construction
+  // to its destruction:
+  class TaskLease {
+   public:
+    // workspace should not be NULL:
+    explicit TaskLease(DetectorWorkspace *workspace);
+
+    TaskLease(const TaskLease &lease) = delete;
+
+    TaskLease& operator=(const TaskLease &lease) = delete;
+
+    virtual ~TaskLease();
+
+    TaskScratch& operator*() const { return *scratch_; }
+
+    TaskScratch* operator->() const { return scratch_; }
+
+   private:
+    DetectorWorkspace *workspace_;
+    TaskScratch *scratch_;
+  };
+
+  // first, so that it outlives the matrices below:
+  PoolingMatAllocator allocator_;
+  cv::Mat raw_mask_;
+  cv::Mat gray_;
+  cv::Mat threshold_output_;
+  // kPyramidDetection: the frame halved kCoarseLevels times, and the rest:
+  cv::Mat levels_[kCoarseLevels];
+  cv::Mat coarse_mask_;
+  cv::Mat coarse_gray_;
+  std::vector<cv::Rect> regions_;
+  std::vector<int> region_parents_;  // joining the overlapping regions
+  cv::Mat region_mask_;
+  cv::Mat region_gray_;
+  // the rects of the coarse frame, then the ones of every region:
+  cv::vector<cv::Rect> region_rects_;
+  // the threshold search:
+  std::vector<int> thresholds_;
+  std::vector<int> num_of_candidates_;  // per threshold
+  std::vector<cv::vector<cv::Rect>> candidate_rects_;  // per threshold
+  std::vector<BandBlobs> bands_;  // per threshold and tile
+  std::vector<uchar> row_buffer_;
+  cv::vector<cv::Rect> good_rects_;
+  RectIndex rect_index_;
+  std::vector<int> kept_rects_;
+  // the scratch of the tasks, all of them and the ones no task holds:
+  std::mutex task_mutex_;
+  std::vector<std::unique_ptr<TaskScratch>> tasks_;
+  std::vector<TaskScratch*> free_tasks_;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_DETECTOR_WORKSPACE_H_
@@ -0,0 +1,119 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// feature_descriptor.h
+// Object Clustering
+// Declares the features an object is described by. Every extractor knows at
+// compile time how many features it writes, and the descriptor of an object
+// is put together out of them, so its length is never written by hand.
+
+#ifndef OBJECT_CLUSTERING_FEATURE_DESCRIPTOR_H_
+#define OBJECT_CLUSTERING_FEATURE_DESCRIPTOR_H_
+
+#include <array>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "feature_matrix.h"
+#include "image.h"
+#include "integral_color_image.h"
+#include "object.h"
+
+namespace object_clustering {
+// The pixels of one object, as the extractors see them: its image and, if
+// there is one, the integral image of the frame the image is a region of.
+// Usage:
+// FeatureSource source(object.image().matrix(), &integral);
+// cv::Scalar color = source.Mean(cv::Rect(0, 0, 4, 4));
+class FeatureSource {
+ public:
+  // matrix and integral should outlive the source; integral may be NULL, or
+  // should be built from the frame matrix is a region of, and cover matrix.
+  explicit FeatureSource(const cv::Mat &matrix,
+                         const IntegralColorImage *integral = nullptr);
+
+  FeatureSource(const FeatureSource &source) = default;
+
+  FeatureSource& operator=(const FeatureSource &source) = default;
+
+  virtual ~FeatureSource() = default;
+
+  const cv::Mat& matrix() const { return *matrix_; }
+  // Returns the mean color of rect, given in the coordinates of matrix():
+  // from the integral image in constant time, or by cv::mean(..) without one.
+  cv::Scalar Mean(const cv::Rect &rect) const;
+
+ private:
+  const cv::Mat *matrix_;
+  const IntegralColorImage *integral_;
+  cv::Point offset_;  // of matrix_ in its frame
+};
+// An extractor is a class with:
+// static constexpr int kWidth - how many features it writes;
+// static void Extract(const FeatureSource &source, float *features) - writes
+// exactly kWidth features of the source into features.
+
+// matrix.cols and matrix.rows:
+struct SizeFeatures {
+  static constexpr int kWidth = 2;
+  static void Extract(const FeatureSource &source, float *features);
+};
+// The mean color (blue, green, red) of 6 regions:
+// 1. the whole image;
+// 2. the center of the image;
+// 3,4,5,6. the four quarters.
+struct RegionColorFeatures {
+  static constexpr int kNumberOfRegions = 6;
+  static constexpr int kWidth = kNumberOfRegions * 3;
+  // The regions of an image of size, in its coordinates:
+  static void Regions(const cv::Size &size,
+                      cv::Rect regions[kNumberOfRegions]);
+  static void Extract(const FeatureSource &source, float *features);
+};
+// How "square" the image is, abs(matrix.cols - matrix.rows), and how big it
+// is, matrix.cols * matrix.cols:
+struct ShapeFeatures {
+  static constexpr int kWidth = 2;
+  static void Extract(const FeatureSource &source, float *features);
+};
+// Runs the Extractors one after the other, each one writing right after the
+// previous one; kWidth is the sum of their widths.
+template <typename... Extractors>
+struct FeatureDescriptor;
+
+template <>
+struct FeatureDescriptor<> {
+  static constexpr int kWidth = 0;
+  static void Extract(const FeatureSource &source, float *features) {}
+};
+
+template <typename First, typename... Rest>
+struct FeatureDescriptor<First, Rest...> {
+  static constexpr int kWidth = First::kWidth +
+                                FeatureDescriptor<Rest...>::kWidth;
+  static void Extract(const FeatureSource &source, float *features) {
+    First::Extract(source, features);
+    FeatureDescriptor<Rest...>::Extract(source, features + First::kWidth);
+  }
+};
+// The features the objects are clustered by. To add a feature, write an
+// extractor and add it here:
+typedef FeatureDescriptor<SizeFeatures,
+                          RegionColorFeatures,
+                          ShapeFeatures> ObjectFeatures;
+// each object is characterized by this many features:
+const int kNumberOfFeatures = ObjectFeatures::kWidth;
+// The unnormalized features of one object:
+typedef std::array<float, kNumberOfFeatures> FeatureVector;
+// Usage:
+// FeatureVector features = ExtractFeatures(object.image());
+FeatureVector ExtractFeatures(const Image &image);
+// Writes the ObjectFeatures of every object into a row of features, which
+// should have as many rows as there are objects and kNumberOfFeatures columns.
+// One integral image is built for every frame the objects were cut out of,
+// over the part of the frame they cover, so a region costs the same whatever
+// its size.
+// features should not be NULL.
+void ExtractFeatures(const std::vector<Object> &objects,
+                     FeatureMatrix *features);
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_FEATURE_DESCRIPTOR_H_
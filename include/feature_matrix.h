@@ -0,0 +1,131 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// feature_matrix.h
+// Object Clustering
+// Declares a contiguous matrix of float features, one row per example, and the
+// distance kernels the clustering algorithms run over its rows.
+
+#ifndef OBJECT_CLUSTERING_FEATURE_MATRIX_H_
+#define OBJECT_CLUSTERING_FEATURE_MATRIX_H_
+
+#include <cassert>
+
+#include <utility>
+
+#include "opencv2/core/core.hpp"
+
+namespace object_clustering {
+// The rows are padded with zeros to a multiple of this many floats, so that
+// the kernels below can work on whole SSE registers:
+const int kFeaturesPerVector = 4;
+// Every row starts at an address aligned to this many bytes:
+const int kFeatureAlignment = 16;
+// A matrix of rows() examples with cols() features each, stored in one
+// row-major buffer. A row takes stride() floats; the ones past cols() are
+// zero and stay zero as long as only the kernels below write into the rows.
+// Copies are deep.
+// Usage:
+// object_clustering::FeatureMatrix features(num_of_objects, 22);
+// features.at(i, j) = ...;
+// float d = SquaredDistance(features.row(0), features.row(1),
+//                           features.stride());
+class FeatureMatrix {
+ public:
+  FeatureMatrix(): rows_(0), cols_(0), stride_(0) {}
+  // num_of_rows and num_of_columns should be >= 0; the features are zero.
+  FeatureMatrix(const int &num_of_rows, const int &num_of_columns) {
+    Create(num_of_rows, num_of_columns);
+  }
+
+  FeatureMatrix(const FeatureMatrix &matrix):
+    buffer_(matrix.buffer_.clone()),
+    rows_(matrix.rows_),
+    cols_(matrix.cols_),
+    stride_(matrix.stride_) {}
+
+  FeatureMatrix(FeatureMatrix &&matrix): FeatureMatrix() {
+    Swap(&matrix);
+  }
+
+  FeatureMatrix& operator=(FeatureMatrix matrix) {
+    Swap(&matrix);
+    return *this;
+  }
+
+  virtual ~FeatureMatrix() = default;
+  // Makes the matrix num_of_rows x num_of_columns, all zero. The buffer is
+  // reused when the size does not change.
+  void Create(const int &num_of_rows, const int &num_of_columns);
+  // Sets every feature (and the padding) to zero:
+  void SetZero();
+
+  int rows() const { return rows_; }
+
+  int cols() const { return cols_; }
+  // floats from the start of one row to the start of the next:
+  int stride() const { return stride_; }
+
+  bool empty() const { return rows_ == 0; }
+  // i should be in [0; rows()):
+  float* row(const int &i) {
+    assert((i >= 0) && (i < rows_));
+    return buffer_.ptr<float>(i);
+  }
+
+  const float* row(const int &i) const {
+    assert((i >= 0) && (i < rows_));
+    return buffer_.ptr<float>(i);
+  }
+
+  float& at(const int &i, const int &j) {
+    assert((j >= 0) && (j < cols_));
+    return row(i)[j];
+  }
+
+  const float& at(const int &i, const int &j) const {
+    assert((j >= 0) && (j < cols_));
+    return row(i)[j];
+  }
+  // A rows() x cols() CV_32FC1 header over the features, without the padding.
+  // The pixels are not copied.
+  cv::Mat matrix() const {
+    return buffer_.colRange(0, cols_);
+  }
+
+ private:
+  void Swap(FeatureMatrix *matrix) {
+    std::swap(buffer_, matrix->buffer_);
+    std::swap(rows_, matrix->rows_);
+    std::swap(cols_, matrix->cols_);
+    std::swap(stride_, matrix->stride_);
+  }
+
+  cv::Mat buffer_;  // rows_ x stride_, CV_32FC1, 16-byte aligned rows
+  int rows_;
+  int cols_;
+  int stride_;
+};
+// The kernels below take rows of FeatureMatrix objects with the same stride:
+// the pointers should be kFeatureAlignment aligned and stride a multiple of
+// kFeaturesPerVector, and the padding should be zero.
+
+// Returns the squared Euclidean distance between the rows a and b:
+float SquaredDistance(const float *a, const float *b, const int &stride);
+// Returns the index of the row of centers nearest to sample and stores the
+// squared distance to it. centers should not be empty; distance should not
+// be NULL.
+int NearestRow(const float *sample,
+               const FeatureMatrix &centers,
+               float *distance);
+// destination += source:
+void AddRow(const float *source, const int &stride, float *destination);
+// destination -= source:
+void SubtractRow(const float *source, const int &stride, float *destination);
+// destination += factor * source:
+void AddScaledRow(const float *source,
+                  const float &factor,
+                  const int &stride,
+                  float *destination);
+// row *= factor:
+void ScaleRow(const float &factor, const int &stride, float *row);
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_FEATURE_MATRIX_H_
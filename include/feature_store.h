@@ -0,0 +1,150 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// feature_store.h
+// Object Clustering
+// Declares an append-only file of the features of detected objects. It is
+// read by mapping it into memory, so it can be clustered chunk by chunk
+// without holding the objects, or even all of their features, in memory.
+
+#ifndef OBJECT_CLUSTERING_FEATURE_STORE_H_
+#define OBJECT_CLUSTERING_FEATURE_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "feature_descriptor.h"
+#include "feature_matrix.h"
+#include "object.h"
+
+namespace object_clustering {
+// The layout of a store, in native byte order:
+// 1. FeatureStoreHeader;
+// 2. one FeatureStoreRow per object, in the order they were appended.
+// The number of rows is not written anywhere: it follows from the size of the
+// file, so appending a row is a single write. A row which was cut short (the
+// program stopped while writing it) is not read, and is overwritten by the
+// next writer.
+const char kFeatureStoreMagic[8] = {'O', 'C', 'F', 'E', 'A', 'T', 'S', '1'};
+const uint32_t kFeatureStoreVersion = 1;
+// how many rows ReadChunk(..) callers read at a time:
+const int kFeatureStoreChunkRows = 4096;
+// the file name extension of the stores:
+const char kFeatureStoreExtension[] = ".features";
+
+struct FeatureStoreHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_of_features;  // kNumberOfFeatures of the writer
+  uint32_t row_size;  // sizeof(FeatureStoreRow) of the writer
+  uint32_t reserved;
+};
+// The features of one object, unnormalized, and where it was found:
+struct FeatureStoreRow {
+  int64_t frame_id;
+  int32_t x;
+  int32_t y;
+  int32_t width;
+  int32_t height;
+  float features[kNumberOfFeatures];
+
+  cv::Rect rect() const { return cv::Rect(x, y, width, height); }
+};
+// Appends rows to a store, creating it if needed. The rows may be appended
+// from several threads at once; the rows of one call stay together.
+// Usage:
+// object_clustering::FeatureStoreWriter writer("detections.features");
+// writer.Append(frame_id, objects);
+// bool written = writer.Close();
+class FeatureStoreWriter {
+ public:
+  FeatureStoreWriter() = delete;
+  // Opens the store for appending, or creates it; see IsOpened(). A file
+  // which is not a store of the current kNumberOfFeatures is not opened.
+  explicit FeatureStoreWriter(const std::string &filename);
+
+  FeatureStoreWriter(const FeatureStoreWriter &writer) = delete;
+
+  FeatureStoreWriter& operator=(const FeatureStoreWriter &writer) = delete;
+  // Closes the store if Close() was not called:
+  virtual ~FeatureStoreWriter();
+
+  bool IsOpened() const { return file_ != NULL; }
+  // Appends one row. Returns false if it cannot be written.
+  bool Append(const int64_t &frame_id,
+              const cv::Rect &rect,
+              const FeatureVector &features);
+  // Appends a row for every object of the frame, extracting their features.
+  // Returns false if they cannot be written.
+  bool Append(const int64_t &frame_id, const std::vector<Object> &objects);
+  // Writes the buffered rows, so that a store mapped from now on sees them.
+  // Returns false if anything could not be written so far.
+  bool Flush();
+  // Writes the buffered rows and closes the file. Returns false if anything
+  // could not be written, now or before.
+  bool Close();
+  // rows appended by this writer:
+  int64_t num_of_rows() const;
+
+ private:
+  // Writes the rows; mutex_ should be locked.
+  bool AppendRows(const FeatureStoreRow *rows, const size_t &num_of_rows);
+
+  mutable std::mutex mutex_;
+  FILE *file_ = NULL;
+  int64_t num_of_rows_ = 0;
+  bool failed_ = false;
+};
+// Maps a store into memory, as big as it is when mapped. The rows are read
+// straight from the mapping; only the pages touched are loaded, and the
+// system may drop them again, so the store may be bigger than the memory.
+// Usage:
+// object_clustering::MappedFeatureStore store("detections.features");
+// FeatureMatrix chunk;
+// for (int64_t i = 0; i < store.num_of_rows(); i += kFeatureStoreChunkRows) {
+//   store.ReadChunk(i, kFeatureStoreChunkRows, &chunk);
+// }
+class MappedFeatureStore {
+ public:
+  MappedFeatureStore() = delete;
+  // Maps the file; see IsOpened(). A file which is not a store of the
+  // current kNumberOfFeatures is not opened.
+  explicit MappedFeatureStore(const std::string &filename);
+  // The mapping is not copied:
+  MappedFeatureStore(const MappedFeatureStore &store) = delete;
+
+  MappedFeatureStore& operator=(const MappedFeatureStore &store) = delete;
+  // Unmaps the file; the rows should not be used anymore.
+  virtual ~MappedFeatureStore();
+
+  bool IsOpened() const { return opened_; }
+
+  int64_t num_of_rows() const { return num_of_rows_; }
+  // Returns the row, which lives in the mapping.
+  // index should be in [0; num_of_rows()).
+  const FeatureStoreRow& row(const int64_t &index) const;
+  // Copies the features of the rows [begin; begin + num_of_rows), cut at the
+  // end of the store, into chunk, which gets one row per row read and
+  // kNumberOfFeatures columns; its buffer is reused when its size does not
+  // change. Returns the number of rows read.
+  // begin should be in [0; num_of_rows()); chunk should not be NULL.
+  int ReadChunk(const int64_t &begin,
+                const int &num_of_rows,
+                FeatureMatrix *chunk) const;
+
+ private:
+  void *data_ = nullptr;  // the whole mapping, header included
+  size_t size_ = 0;
+  const FeatureStoreRow *rows_ = nullptr;  // right after the header
+  int64_t num_of_rows_ = 0;
+  bool opened_ = false;
+};
+// Returns true if the file name has kFeatureStoreExtension:
+bool IsFeatureStoreName(const std::string &filename);
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_FEATURE_STORE_H_
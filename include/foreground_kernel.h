@@ -0,0 +1,44 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// foreground_kernel.h
+// Object Clustering
+// Declares a fused kernel which turns a background subtraction mask and the
+// image into the blurred gray image used for object detection.
+
+#ifndef OBJECT_CLUSTERING_FOREGROUND_KERNEL_H_
+#define OBJECT_CLUSTERING_FOREGROUND_KERNEL_H_
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+namespace object_clustering {
+// BackgroundSubtractorMOG2 marks the shadow pixels with this intensity:
+const uchar kShadowIntensity = 127;
+// Computes, in one pass over the rows, exactly what this chain computes:
+// 1. recolor the shadow (kShadowIntensity) of raw_mask to 0;
+// 2. copy image using the mask, the other pixels being black;
+// 3. recolor exactly black pixels to white and all the others to black;
+// 4. convert to gray;
+// 5. blur with a 3x3 box filter, default border.
+// Every step gives either 0 or 255 in all channels, so the chain reduces to
+// counting the "white" pixels in the 3x3 neighbourhood of every pixel.
+// raw_mask should be of type CV_8UC1 and image of type CV_8UC3, of the same
+// size; blurred_gray should not be NULL.
+// row_buffer, if not NULL, holds the few rows the kernel works on, so that
+// reusing it for many frames saves their allocation.
+void ForegroundToBlurredGray(const cv::Mat &raw_mask,
+                             const cv::Mat &image,
+                             cv::Mat *blurred_gray,
+                             std::vector<uchar> *row_buffer = nullptr);
+// Same as above, but computes only the rows [row_begin; row_end) of
+// blurred_gray, which should already be allocated as CV_8UC1 of the image
+// size. The neighbouring rows are read from the whole raw_mask and image, so
+// disjoint row ranges can be computed independently.
+void ForegroundToBlurredGrayRows(const cv::Mat &raw_mask,
+                                 const cv::Mat &image,
+                                 const int &row_begin,
+                                 const int &row_end,
+                                 cv::Mat *blurred_gray,
+                                 std::vector<uchar> *row_buffer = nullptr);
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_FOREGROUND_KERNEL_H_
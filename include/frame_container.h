@@ -0,0 +1,149 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// frame_container.h
+// Object Clustering
+// Declares a container file of raw BGR frames. It is read by mapping it into
+// memory, so its frames are neither decoded nor copied.
+
+#ifndef OBJECT_CLUSTERING_FRAME_CONTAINER_H_
+#define OBJECT_CLUSTERING_FRAME_CONTAINER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "frame_stream.h"
+#include "image.h"
+
+namespace object_clustering {
+// The layout of a container, in native byte order:
+// 1. FrameContainerHeader;
+// 2. the pixels of every frame, row after row, each frame starting at a
+// multiple of kFrameAlignment bytes;
+// 3. the index: one FrameContainerEntry per frame, at header.index_offset.
+const char kFrameContainerMagic[8] = {'O', 'C', 'F', 'R', 'A', 'M', 'E', 'S'};
+const uint32_t kFrameContainerVersion = 1;
+const int kFrameAlignment = 64;  // bytes
+// the file name extension of the containers:
+const char kFrameContainerExtension[] = ".frames";
+
+struct FrameContainerHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_of_frames;
+  uint64_t index_offset;  // from the start of the file
+};
+
+struct FrameContainerEntry {
+  int32_t rows;
+  int32_t cols;
+  uint64_t step;  // bytes per row
+  uint64_t offset;  // of the first pixel, from the start of the file
+};
+// Writes a container frame by frame. The index is written by Close().
+// Usage:
+// object_clustering::FrameContainerWriter writer("recording.frames");
+// writer.Append(frame);
+// bool written = writer.Close();
+class FrameContainerWriter {
+ public:
+  FrameContainerWriter() = delete;
+  // Creates or truncates the file; see IsOpened().
+  explicit FrameContainerWriter(const std::string &filename);
+
+  FrameContainerWriter(const FrameContainerWriter &writer) = delete;
+
+  FrameContainerWriter& operator=(const FrameContainerWriter &writer) = delete;
+  // Closes the container if Close() was not called:
+  virtual ~FrameContainerWriter();
+
+  bool IsOpened() const { return file_ != NULL; }
+  // Appends the frame, which should be of type CV_8UC3. Returns false if it
+  // cannot be written.
+  bool Append(const cv::Mat &frame);
+  // Writes the index and the header and closes the file. Returns false if
+  // anything could not be written, now or by Append(..).
+  bool Close();
+
+  int num_of_frames() const { return static_cast<int>(index_.size()); }
+
+ private:
+  FILE *file_;
+  uint64_t size_ = 0;  // bytes written so far
+  std::vector<FrameContainerEntry> index_;
+  bool failed_ = false;
+};
+// Maps a container into memory. The frames are views into the mapping: they
+// need no decoding and are not copied. The mapping is private, so changing
+// the pixels of a frame copies just the changed pages and never changes the
+// file.
+// Usage:
+// object_clustering::MappedFrameContainer container("recording.frames");
+// if (container.IsOpened()) {
+//   Image frame = container.frame(0);
+// }
+class MappedFrameContainer {
+ public:
+  MappedFrameContainer() = delete;
+  // Maps the file; see IsOpened(). A file which is not a whole, valid
+  // container is not opened.
+  explicit MappedFrameContainer(const std::string &filename);
+  // The mapping is not copied:
+  MappedFrameContainer(const MappedFrameContainer &container) = delete;
+
+  MappedFrameContainer& operator=(
+      const MappedFrameContainer &container) = delete;
+  // Unmaps the file; the frames should not be used anymore.
+  virtual ~MappedFrameContainer();
+
+  bool IsOpened() const { return data_ != nullptr; }
+
+  int num_of_frames() const { return static_cast<int>(index_.size()); }
+  // Returns the frame, a view into the mapping, which should outlive it.
+  // index should be in [0; num_of_frames()).
+  Image frame(const int &index) const;
+
+ private:
+  // Checks the header and the index, and keeps the index. Returns false if
+  // they do not fit into the file.
+  bool ReadIndex();
+
+  uchar *data_ = nullptr;
+  size_t size_ = 0;
+  std::vector<FrameContainerEntry> index_;
+};
+// Gives the frames of a container in order. Each frame is copied out of the
+// mapping, at the speed of memory rather than of a decoder, so that it has its
+// own pixels, as AbstractFrameSource promises: the frames may outlive the
+// source, and so the mapping.
+// Usage:
+// object_clustering::ContainerFrameSource source("recording.frames");
+// cv::Mat frame;
+// while (source.NextFrame(&frame)) { ... }
+class ContainerFrameSource: public AbstractFrameSource {
+ public:
+  explicit ContainerFrameSource(const std::string &filename);
+
+  virtual ~ContainerFrameSource() = default;
+
+  bool IsOpened() const { return container_.IsOpened(); }
+
+  bool NextFrame(cv::Mat *frame) override;
+
+ private:
+  MappedFrameContainer container_;
+  int next_frame_ = 0;
+};
+// Returns true if the file name has kFrameContainerExtension:
+bool IsFrameContainerName(const std::string &filename);
+// Writes every frame of source into a new container. Returns the number of
+// frames written, -1 if the container cannot be written.
+// source should not be NULL.
+int ConvertToFrameContainer(AbstractFrameSource *source,
+                            const std::string &filename);
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_FRAME_CONTAINER_H_
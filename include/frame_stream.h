@@ -0,0 +1,140 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// frame_stream.h
+// Object Clustering
+// Declares the sources of frames for continuous feeds and a pipeline which
+// detects and clusters the objects on every frame of a stream.
+
+#ifndef OBJECT_CLUSTERING_FRAME_STREAM_H_
+#define OBJECT_CLUSTERING_FRAME_STREAM_H_
+
+#include <cstdint>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/highgui/highgui.hpp"
+
+#include "abstract_cluster_algorithm.h"
+#include "background_model.h"
+#include "object.h"
+#include "object_detector.h"
+
+namespace object_clustering {
+// how many frames may wait between reading and processing:
+const int kStreamQueueCapacity = 8;
+// Defines a common interface for anything which gives frames one by one:
+class AbstractFrameSource {
+ public:
+  AbstractFrameSource() = default;
+
+  AbstractFrameSource(const AbstractFrameSource &source) = delete;
+
+  AbstractFrameSource& operator=(const AbstractFrameSource &source) = delete;
+
+  virtual ~AbstractFrameSource() = default;
+  // Reads the next frame into frame, which gets its own pixels. Returns false
+  // at the end of the stream.
+  // frame should not be NULL.
+  virtual bool NextFrame(cv::Mat *frame) = 0;
+  // a source is identified by its name:
+  std::string get_name() const { return name_; }
+
+  void set_name(const std::string &name) { name_ = name; }
+
+ private:
+  std::string name_ = "unknown";
+};
+// Reads the frames using OpenCV VideoCapture, which opens video files as well
+// as numbered image sequences given by a pattern like "frames/%04d.png".
+// Usage:
+// object_clustering::VideoFrameSource source("feed.avi");
+// cv::Mat frame;
+// while (source.NextFrame(&frame)) { ... }
+class VideoFrameSource: public AbstractFrameSource {
+ public:
+  explicit VideoFrameSource(const std::string &path);
+
+  virtual ~VideoFrameSource() = default;
+
+  bool IsOpened() const { return capture_.isOpened(); }
+
+  bool NextFrame(cv::Mat *frame) override;
+
+ private:
+  cv::VideoCapture capture_;
+};
+// The result of processing one frame of a stream:
+struct FrameResult {
+  int frame_index = 0;  // counted from 0
+  cv::Mat frame;  // the objects' images are views into it
+  std::vector<Object> objects;  // empty if nothing was detected
+  int num_of_groups = 0;
+  double latency_ms = 0;  // from reading the frame to the result
+};
+// Summary of a processed stream:
+struct StreamStatistics {
+  int num_of_frames = 0;
+  int num_of_skipped_frames = 0;  // the ones of wrong size
+  int64_t num_of_objects = 0;
+  int64_t num_of_tracked_objects = 0;  // not clustered, see set_tracking(..)
+  double seconds = 0;  // wall-clock time of the whole stream
+  double frames_per_second = 0;
+  double mean_latency_ms = 0;
+  double max_latency_ms = 0;
+};
+// A bounded producer/consumer pipeline: the calling thread reads the frames
+// and a few worker threads detect and cluster the objects. At most
+// queue_capacity frames wait in between, so memory stays bounded when the
+// source is faster than the workers.
+// The detector, background model and clustering algorithm are only read, so
+// one processor (or several processors sharing them) can serve many streams
+// at once, each from its own thread.
+// With tracking, the objects of every frame are matched to the ones of the
+// previous frame by an ObjectTracker, and only the new or changed ones are
+// clustered. The detection still runs on all the workers at once, but the
+// tracking and clustering run one frame at a time, in the order of the
+// stream.
+// Usage:
+// object_clustering::StreamProcessor processor(detector, model, clusterer);
+// auto stats = processor.Process(&source, [](const FrameResult &r) { ... });
+class StreamProcessor {
+ public:
+  StreamProcessor() = delete;
+  // The arguments should outlive the processor;
+  // queue_capacity and num_of_workers should be > 0.
+  StreamProcessor(const ObjectDetector &detector,
+                  const BackgroundModel &background,
+                  const AbstractClusterAlgorithm &clusterer,
+                  const int &queue_capacity = kStreamQueueCapacity,
+                  const int &num_of_workers = 1);
+
+  StreamProcessor(const StreamProcessor &processor) = delete;
+
+  StreamProcessor& operator=(const StreamProcessor &processor) = delete;
+
+  virtual ~StreamProcessor() = default;
+  // Processes every frame of source. on_result is called once per frame, from
+  // the worker threads but never from two of them at the same time; with more
+  // than one worker the frames may come out of order.
+  // Frames not of the background's size are skipped.
+  // source should not be NULL.
+  StreamStatistics Process(
+      AbstractFrameSource *source,
+      const std::function<void(const FrameResult&)> &on_result) const;
+
+  bool tracking() const { return tracking_; }
+  // Every call of Process(..) tracks its stream from the first frame:
+  void set_tracking(bool tracking) { tracking_ = tracking; }
+
+ private:
+  const ObjectDetector &detector_;
+  const BackgroundModel &background_;
+  const AbstractClusterAlgorithm &clusterer_;
+  int queue_capacity_;
+  int num_of_workers_;
+  bool tracking_ = false;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_FRAME_STREAM_H_
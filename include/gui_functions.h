@@ -15,7 +15,8 @@
 
 namespace object_clustering {
 void ShowImage(const Image &image);
-// Displays a window on the screen, showing the result of clustering
+// Displays a window on the screen, showing the result of clustering, drawn by
+// AnnotateResult(..). For servers without a display, see ResultWriter.
 // objects should not be empty;
 // num_of_groups should be > 0;
 void ShowResult(const Image &image,
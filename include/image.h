@@ -7,10 +7,10 @@
 #ifndef OBJECT_CLUSTERING_IMAGE_H_
 #define OBJECT_CLUSTERING_IMAGE_H_
 
-#include <cstdio>
-
 #include <algorithm>
+#include <stdexcept>
 #include <string>
+#include <utility>
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/opencv.hpp"
@@ -18,9 +18,6 @@
 // All types and functions defined during this project go into this namespace:
 namespace object_clustering {
 
-const int kImageWidth = 1280;  // in pixels
-const int kImageHeight = 960;
-
 // Used to identify an image.
 // The bounded_rect() and GetCenter() methods return the position of the image
 // in the superimage (image that contains this image)
@@ -33,45 +30,52 @@ class Image {
   // An image without a matrix is not an image:
   Image() = delete;
   // An image is loaded from the file. In this case, the superimage is the image
-  // itself, so bounding_rect is set the upper-left corner.
+  // itself, so bounding_rect covers the whole matrix, whatever its size.
+  // Throws std::runtime_error if the file cannot be read.
   explicit Image(const std::string &filename):
     matrix_(cv::imread(filename, CV_LOAD_IMAGE_COLOR)),
-    bounding_rect_(cv::Rect(0, 0, kImageWidth, kImageHeight)) {
+    bounding_rect_(cv::Rect(0, 0, matrix_.cols, matrix_.rows)) {
     if (matrix_.data == NULL) {
-      fprintf(stderr, "Could not read the image from file %s \n",
-      filename.c_str());
-      exit(1);
+      throw std::runtime_error("Could not read the image from file " +
+                               filename);
     }
   }
   // An image is constructed from the matrix. No bounding rect is specified,
-  // thus it occupies the whole space:
+  // thus it occupies the whole matrix. The pixels are not copied, the image
+  // shares them with matrix (use Clone() for an independent copy):
   explicit Image(const cv::Mat &matrix):
-     bounding_rect_(cv::Rect(0, 0, kImageWidth, kImageHeight)) {
-     matrix.copyTo(matrix_);
-  }
+     matrix_(matrix),
+     bounding_rect_(cv::Rect(0, 0, matrix_.cols, matrix_.rows)) {}
   // An image is constructed from a matrix and the position of this matrix in
-  // the superimage:
+  // the superimage. Passing a region of the superimage, like src(rect), gives
+  // a view into the superimage's pixels rather than a copy:
   explicit Image(const cv::Mat &matrix, const cv::Rect &bounding_rect):
-    bounding_rect_(bounding_rect) {
-    matrix.copyTo(matrix_);
-  }
-  // A copy of an image is independent of the original:
-  Image(const Image &image):
+    matrix_(matrix),
+    bounding_rect_(bounding_rect) {}
+  // A copy of an image shares the pixels with the original:
+  Image(const Image &image) = default;
+  // A moved-from image is left without a matrix. Neither moving nor
+  // assigning throws, so containers of images move them when they grow:
+  Image(Image &&image) noexcept:
     bounding_rect_(image.bounding_rect_) {
-    image.matrix_.copyTo(matrix_);
+    std::swap(matrix_, image.matrix_);
   }
-  // Implemented using copy-and-swap idiom:
-  Image& operator=(Image image) {
+  // Implemented using copy-and-swap idiom; it is the move assignment as well:
+  Image& operator=(Image image) noexcept {
     std::swap(matrix_, image.matrix_);
     std::swap(bounding_rect_, image.bounding_rect_);
     return *this;
   }
   // no dynamic memory to manage:
   virtual ~Image() = default;
+  // Returns an image with its own copy of the pixels, at the same position:
+  Image Clone() const {
+    return Image(matrix_.clone(), bounding_rect_);
+  }
 
-  cv::Mat matrix() const { return matrix_; }
+  const cv::Mat& matrix() const { return matrix_; }
 
-  cv::Rect bounding_rect() const { return bounding_rect_; }
+  const cv::Rect& bounding_rect() const { return bounding_rect_; }
 
   // Returns the center of the image in its superimage coordinates:
   cv::Point2d GetCenter() const {
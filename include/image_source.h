@@ -0,0 +1,120 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// image_source.h
+// Object Clustering
+// Declares where the images come from: a file which is decoded only when it
+// is first needed, possibly in the background, and a cache of the decoded
+// images which many frames share, like their background.
+
+#ifndef OBJECT_CLUSTERING_IMAGE_SOURCE_H_
+#define OBJECT_CLUSTERING_IMAGE_SOURCE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "opencv2/core/core.hpp"
+
+#include "image.h"
+
+namespace object_clustering {
+// How many bytes of decoded pixels a cache keeps by default:
+const size_t kDecodedImageCacheBytes = 256 << 20;
+// A least recently used cache of decoded image files. A file is decoded again
+// if its modification time (in nanoseconds) or size changed since it was
+// decoded. When many
+// threads ask for the same file at once, it is decoded only once and the
+// others wait for it. The images share their pixels with the cache, so they
+// should not be changed (use Image::Clone() for a copy to change).
+// Usage:
+// object_clustering::DecodedImageCache cache(64 << 20);
+// object_clustering::Image background = cache.Get("background.png");
+class DecodedImageCache {
+ public:
+  // capacity_bytes is the most pixel data kept; an image which is bigger on
+  // its own is returned, but not kept, and evicts nothing.
+  explicit DecodedImageCache(
+      const size_t &capacity_bytes = kDecodedImageCacheBytes);
+  // The cache is shared, not copied:
+  DecodedImageCache(const DecodedImageCache &cache) = delete;
+
+  DecodedImageCache& operator=(const DecodedImageCache &cache) = delete;
+
+  virtual ~DecodedImageCache() = default;
+  // Returns the image decoded from filename, as Image(filename) does.
+  // Throws std::runtime_error if the file cannot be read.
+  Image Get(const std::string &filename);
+
+  size_t capacity_bytes() const { return capacity_bytes_; }
+  // The bytes of pixel data kept now:
+  size_t size_bytes() const;
+  // How many times a file has been decoded, for the statistics:
+  int num_of_decodes() const;
+
+ private:
+  struct Entry {
+    int64_t modification_time;  // in nanoseconds
+    int64_t file_size;
+    uint64_t id;  // tells apart the entries of the same file
+    std::shared_future<cv::Mat> matrix;
+    size_t bytes = 0;  // 0 while the file is being decoded
+    std::list<std::string>::iterator position;  // in recency_
+  };
+  // Removes the entry; the mutex should be locked:
+  void Erase(std::unordered_map<std::string, Entry>::iterator entry);
+
+  size_t capacity_bytes_;
+  size_t size_bytes_ = 0;
+  int num_of_decodes_ = 0;
+  uint64_t next_id_ = 0;
+  std::unordered_map<std::string, Entry> entries_;
+  // the file names, the most recently used first:
+  std::list<std::string> recency_;
+  mutable std::mutex mutex_;
+};
+// An image file which is decoded on the first call of image(), or in the
+// background after Prefetch(), so several files can be decoded at the same
+// time. With a cache, the file is taken from it.
+// Usage:
+// object_clustering::ImageSource objects("objects.png");
+// object_clustering::ImageSource background("background.png", &cache);
+// background.Prefetch();
+// const Image &image = objects.image();  // decoded while background is
+class ImageSource {
+ public:
+  ImageSource() = delete;
+  // Nothing is read yet. cache may be NULL, or should outlive the source.
+  explicit ImageSource(const std::string &filename,
+                       DecodedImageCache *cache = nullptr);
+  // The decoding is not copied:
+  ImageSource(const ImageSource &source) = delete;
+
+  ImageSource& operator=(const ImageSource &source) = delete;
+  // Waits for the decoding started by Prefetch(), if there is one:
+  virtual ~ImageSource() = default;
+
+  const std::string& filename() const { return filename_; }
+  // Starts decoding on a thread of its own, if it has not started yet:
+  void Prefetch();
+  // Returns the image, decoding it in the calling thread if it has not
+  // started yet, or waiting for Prefetch() otherwise.
+  // Throws std::runtime_error if the file cannot be read.
+  const Image& image();
+
+ private:
+  // Starts decoding with the policy, if it has not started yet:
+  void Start(const std::launch &policy);
+  // Decodes the file, or takes it from the cache:
+  Image Decode() const;
+
+  std::string filename_;
+  DecodedImageCache *cache_;
+  std::shared_future<Image> image_;
+  std::mutex mutex_;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_IMAGE_SOURCE_H_
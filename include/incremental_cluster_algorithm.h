@@ -0,0 +1,116 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// incremental_cluster_algorithm.h
+// Object Clustering
+// Declares a clustering algorithm for streams: the objects are labeled by a
+// ClusterModel, and K-Means runs again only when the objects drift away from
+// it.
+
+#ifndef OBJECT_CLUSTERING_INCREMENTAL_CLUSTER_ALGORITHM_H_
+#define OBJECT_CLUSTERING_INCREMENTAL_CLUSTER_ALGORITHM_H_
+
+#include <cassert>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "abstract_cluster_algorithm.h"
+#include "cluster_model.h"
+#include "feature_matrix.h"
+#include "k_means_clustering_algorithm.h"
+
+namespace object_clustering {
+// the model is trained again when drift() gets above this:
+const float kModelDriftThreshold = 2;
+// how many of the latest objects drift() looks at, and the model is trained
+// again on:
+const int kDriftWindow = 1000;
+// drift() is 0 until this many objects were labeled by the model:
+const int kMinDriftObjects = 100;
+// a training error below this counts as this, so that a model which fits its
+// examples exactly does not drift at the first object it has not seen:
+const float kMinTrainingError = 1e-3;
+// The first objects train the model; from then on every object gets the group
+// of its nearest center, at the cost of its features and K distances, and the
+// groups keep their numbers from frame to frame. The drift is the mean
+// distance of the latest objects to their centers over the one of the
+// training examples; when it gets above drift_threshold(), the model is
+// trained again on the latest objects, and its groups take the numbers of the
+// nearest groups of the old one, see ClusterModel::AlignTo(..).
+// Objects may be labeled from several threads at once; while the model is
+// trained again, the other threads keep using the old one.
+// Usage:
+// KMeansClusteringAlgorithm k;
+// IncrementalClusterAlgorithm incremental(k);
+// incremental.AssignGroupsToObjects(&objects);  // trains the model
+// incremental.AssignGroupsToObjects(&next_objects);  // just labels them
+class IncrementalClusterAlgorithmTest;  // forward declaration for testing
+class IncrementalClusterAlgorithm: public AbstractClusterAlgorithm {
+  friend class IncrementalClusterAlgorithmTest;
+ public:
+  IncrementalClusterAlgorithm() = delete;
+  // The models are trained by trainer, which should outlive the algorithm.
+  explicit IncrementalClusterAlgorithm(
+      const KMeansClusteringAlgorithm &trainer);
+  // The model and the drift are not copied:
+  IncrementalClusterAlgorithm(
+      const IncrementalClusterAlgorithm &algorithm) = delete;
+
+  IncrementalClusterAlgorithm& operator=(
+      const IncrementalClusterAlgorithm &algorithm) = delete;
+
+  virtual ~IncrementalClusterAlgorithm() = default;
+  // Labels the objects by the model, training it first if there is none, and
+  // again if they drifted. Returns the number of groups of the model which
+  // labeled them, 0 if objects is empty.
+  int AssignGroupsToObjects(std::vector<Object> *objects) const override;
+  // The groups keep their numbers from call to call, and across a training as
+  // far as ClusterModel::AlignTo(..) can tell:
+  bool keeps_groups() const override { return true; }
+  // A copy of the current model, empty until the first objects:
+  ClusterModel model() const;
+  // Replaces the model, by a loaded one for instance, and forgets the drift.
+  void set_model(const ClusterModel &model);
+  // The drift of the latest objects, 0 until kMinDriftObjects of them:
+  float drift() const;
+
+  float drift_threshold() const { return drift_threshold_; }
+  // drift_threshold should be > 0:
+  void set_drift_threshold(float drift_threshold) {
+    assert(drift_threshold > 0);
+    drift_threshold_ = drift_threshold;
+  }
+  // how many times the model was trained, the first time included:
+  int num_of_trainings() const;
+
+ private:
+  // Trains a model on the latest objects, aligns it to the current one and
+  // makes it the current one. lock should hold mutex_, and is released while
+  // the model is trained.
+  void Retrain(std::unique_lock<std::mutex> *lock) const;
+  // Keeps the raw features of an object, a row of a FeatureMatrix, among the
+  // latest ones; mutex_ should be locked.
+  void RecordFeatures(const float *features) const;
+  // Adds the distance of an object to its center to the drift; mutex_ should
+  // be locked.
+  void AddDistance(const float &distance) const;
+  // drift(), with mutex_ locked:
+  float DriftLocked() const;
+
+  const KMeansClusteringAlgorithm &trainer_;
+  float drift_threshold_ = kModelDriftThreshold;
+  mutable std::mutex mutex_;  // guards everything below
+  mutable std::condition_variable trained_;  // signaled after a training
+  mutable std::shared_ptr<const ClusterModel> model_;  // never NULL
+  // the raw features of the latest kDriftWindow objects, a ring:
+  mutable FeatureMatrix latest_features_;
+  mutable int num_of_latest_ = 0;  // rows of latest_features_ in use
+  mutable int next_latest_ = 0;  // the row the next object goes into
+  // the mean distance of the latest objects to their centers:
+  mutable double recent_error_ = 0;
+  mutable int num_of_recent_objects_ = 0;  // labeled since the training
+  mutable bool training_ = false;
+  mutable int num_of_trainings_ = 0;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_INCREMENTAL_CLUSTER_ALGORITHM_H_
@@ -0,0 +1,49 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// integral_color_image.h
+// Object Clustering
+// Declares a summed-area table of the colors of a frame, which gives the mean
+// color of any rectangle of the frame in constant time.
+
+#ifndef OBJECT_CLUSTERING_INTEGRAL_COLOR_IMAGE_H_
+#define OBJECT_CLUSTERING_INTEGRAL_COLOR_IMAGE_H_
+
+#include "opencv2/core/core.hpp"
+
+namespace object_clustering {
+// The sums of the pixels of region of frame: the sum of any rectangle inside
+// region takes four lookups per channel, whatever its size. frame should be
+// CV_8UC3, as the images of the objects are.
+// Usage:
+// IntegralColorImage integral(frame, cv::Rect(0, 0, frame.cols, frame.rows));
+// cv::Scalar color = integral.Mean(object_rect);
+class IntegralColorImage {
+ public:
+  // region should be inside frame:
+  IntegralColorImage(const cv::Mat &frame, const cv::Rect &region);
+  // The sums are shared by the copies, as the pixels of a cv::Mat are:
+  IntegralColorImage(const IntegralColorImage &integral) = default;
+
+  IntegralColorImage& operator=(const IntegralColorImage &integral) = default;
+
+  virtual ~IntegralColorImage() = default;
+  // the rectangle of the frame the sums cover:
+  const cv::Rect& region() const { return region_; }
+  // rect is in the coordinates of the frame.
+  bool Contains(const cv::Rect &rect) const {
+    return (rect & region_) == rect;
+  }
+  // Returns the sum of the pixels of rect, per channel, the same as
+  // cv::sum(frame(rect)). rect should be in region().
+  cv::Scalar Sum(const cv::Rect &rect) const;
+  // Returns the mean color of rect, the same as cv::mean(frame(rect)); zero
+  // if rect is empty. rect should be in region().
+  cv::Scalar Mean(const cv::Rect &rect) const;
+
+ private:
+  // (region_.height + 1) x (region_.width + 1), CV_32SC3 if the sums fit into
+  // an int, CV_64FC3 otherwise:
+  cv::Mat sums_;
+  cv::Rect region_;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_INTEGRAL_COLOR_IMAGE_H_
@@ -8,22 +8,81 @@
 #ifndef OBJECT_CLUSTERING_K_MEANS_CLUSTERING_ALGORITHM_H_
 #define OBJECT_CLUSTERING_K_MEANS_CLUSTERING_ALGORITHM_H_
 
+#include <cassert>
+#include <cfloat>
+#include <cstdint>
+
+#include <memory>
 #include <vector>
 
 #include "abstract_cluster_algorithm.h"
+#include "cluster_model.h"
+#include "feature_descriptor.h"
+#include "feature_matrix.h"
+#include "thread_pool.h"
 
 namespace object_clustering {
-// each object is characterized by 22 features
-const int kNumberOfFeatures = 22;
 // how many iterations per one cv::kmeans(..); call:
 const int kNumberOfIterationsPerOneRun = 10;
+// no limit for the number of clusters other than the number of objects:
+const int kUnboundedNumberOfClusters = 0;
+// how many numbers of clusters kParallelKSearch tries at the same time:
+const int kParallelKWindow = 4;
+// the attempts of kParallelKSearch are seeded from this one:
+const uint64_t kParallelKSearchSeed = 0x9a11e1;
+// Defines how cv::kmeans(..) is started for every number of clusters K tried
+// by the Elbow method:
+// kColdKSearch - kNumberOfIterationsPerOneRun attempts from k-means++ centers;
+// kWarmStartedKSearch - one attempt, started from the centers found for K - 1
+// plus the example farthest from them. Much faster, but since the starting
+// centers differ, the clustering may differ as well;
+// kParallelKSearch - the attempts of kColdKSearch, but the ones of k_window()
+// consecutive values of K all run at the same time on a thread pool, each one
+// from a seed of its own. K is then chosen from the collected results in the
+// order of K, exactly as the other modes do, so the result depends neither on
+// the number of threads nor on the window.
+enum KSearchMode {
+  kColdKSearch,
+  kWarmStartedKSearch,
+  kParallelKSearch
+};
+// Defines what the search for the number of clusters K looks at, see
+// ClusterMetrics:
+// kMeanDistanceCriterion - the Elbow method over the mean distance, as
+// computed by ComputeError(..);
+// kInertiaCriterion - the Elbow method over the inertia, which K-Means already
+// returns, so it costs nothing more;
+// kDaviesBouldinCriterion - the search stops at the first K which does not
+// lower the Davies-Bouldin index;
+// kSilhouetteCriterion - the search stops at the first K which does not raise
+// the sampled silhouette.
+// The last two cannot judge a single cluster, so they start from K = 2.
+enum KSelectionCriterion {
+  kMeanDistanceCriterion,
+  kInertiaCriterion,
+  kDaviesBouldinCriterion,
+  kSilhouetteCriterion
+};
 // Usage:
 // KMeansClusteringAlgorithm k;
 // std::vector<Object> objects = ...;
 // k.AssignGroupsToObjects(objects);
+// To try at most 8 groups, each one started from the previous solution:
+// k.set_max_k(8);
+// k.set_k_search_mode(kWarmStartedKSearch);
+// To label the objects of the next frames the same way, without clustering:
+// ClusterModel model;
+// k.TrainModel(objects, &model);
+// model.AssignGroupsToObjects(&next_objects, nullptr);
+// To try 8 values of K at a time on 32 threads:
+// k.set_k_search_mode(kParallelKSearch);
+// k.set_num_of_threads(32);
+// k.set_k_window(8);
 class KMeansClusteringAlgorithmTest;  // forward declaration for testing
+class PipelineBenchmark;  // and for benchmarking
 class KMeansClusteringAlgorithm: public AbstractClusterAlgorithm {
   friend class KMeansClusteringAlgorithmTest;
+  friend class PipelineBenchmark;
  public:
   KMeansClusteringAlgorithm() = default;
 
@@ -37,40 +96,200 @@ class KMeansClusteringAlgorithm: public AbstractClusterAlgorithm {
   // This method does the whole job:
   // after its call, object.group_ would be assigned
   // here we also define the abstract method from the base class:
-  // objects should not be empty.
+  // returns 0 if objects is empty.
   int AssignGroupsToObjects(std::vector<Object> *objects) const override;
+  // Clusters the objects as AssignGroupsToObjects(..) does, without labeling
+  // them, and keeps the result in model, which can then label new objects
+  // without clustering again. Returns the number of clusters, 0 (and an empty
+  // model) if objects is empty.
+  // model should not be NULL.
+  int TrainModel(const std::vector<Object> &objects,
+                 ClusterModel *model) const;
+  // The same, from the features the objects would have, unnormalized: one
+  // row per object and kNumberOfFeatures columns.
+  int TrainModel(const FeatureMatrix &features, ClusterModel *model) const;
+
+  int max_k() const { return max_k_; }
+  // max_k should be >= 0, kUnboundedNumberOfClusters for no limit:
+  void set_max_k(int max_k) {
+    assert(max_k >= 0);
+    max_k_ = max_k;
+  }
+
+  KSearchMode k_search_mode() const { return k_search_mode_; }
+
+  void set_k_search_mode(KSearchMode mode) { k_search_mode_ = mode; }
+
+  KSelectionCriterion k_selection_criterion() const {
+    return k_selection_criterion_;
+  }
+
+  void set_k_selection_criterion(KSelectionCriterion criterion) {
+    k_selection_criterion_ = criterion;
+  }
+
+  int k_window() const { return k_window_; }
+  // k_window should be > 0; kParallelKSearch only:
+  void set_k_window(int k_window) {
+    assert(k_window > 0);
+    k_window_ = k_window;
+  }
+  // The thread pool of kParallelKSearch; num_of_threads <= 0 means one thread
+  // per hardware thread. The copies of the algorithm share the pool. Without
+  // it, the attempts of a window run one after another on the calling thread.
+  void set_num_of_threads(int num_of_threads) {
+    pool_ = std::make_shared<ThreadPool>(num_of_threads);
+  }
+
+ protected:
+  // Runs K-Means for num_of_clusters clusters over the rows of data, as
+  // k_search_mode() says; previous_centers are the centers found for
+  // num_of_clusters - 1 (empty for one cluster). Fills in the cluster of every
+  // row and the centers, and returns the compactness: the sum of the squared
+  // distances from the rows to their centers.
+  // This implementation calls cv::kmeans(..); subclasses may run their own.
+  // labels and centers should not be NULL.
+  virtual double RunKMeans(const FeatureMatrix &data,
+                           const int &num_of_clusters,
+                           const FeatureMatrix &previous_centers,
+                           std::vector<int> *labels,
+                           FeatureMatrix *centers) const;
+  // Runs one attempt of kParallelKSearch: K-Means for num_of_clusters clusters
+  // from k-means++ centers drawn by a random number generator started from
+  // seed, so that the result depends on nothing else. It is called from
+  // several threads at once. Fills in the labels and the centers and returns
+  // the compactness, as RunKMeans(..) does.
+  // labels and centers should not be NULL.
+  virtual double RunKMeansAttempt(const FeatureMatrix &data,
+                                  const int &num_of_clusters,
+                                  const uint64_t &seed,
+                                  std::vector<int> *labels,
+                                  FeatureMatrix *centers) const;
+  // Makes centers out of previous_centers and one more center: the row of
+  // data farthest from all of them (the first row if there are none).
+  // centers should not be NULL.
+  void SeedCentersFromPrevious(const FeatureMatrix &data,
+                               const FeatureMatrix &previous_centers,
+                               FeatureMatrix *centers) const;
+  // Searches the number of clusters of training_set, whose rows should be
+  // normalized, the way AssignGroupsToObjects(..) does, and fills in the
+  // labels and the centers of the chosen clustering. Returns the number of
+  // clusters.
+  // training_set should not be empty; labels and centers should not be NULL.
+  int ClusterTrainingSet(const FeatureMatrix &training_set,
+                         std::vector<int> *labels,
+                         FeatureMatrix *centers) const;
+  // Clusters training_set, whose rows are normalized by max_feature_value and
+  // avg_feature_value, as ClusterTrainingSet(..) does, and keeps the result
+  // in model. Returns the number of clusters.
+  // training_set should not be empty; model should not be NULL.
+  int TrainNormalizedModel(const FeatureMatrix &training_set,
+                           const FeatureVector &max_feature_value,
+                           const FeatureVector &avg_feature_value,
+                           ClusterModel *model) const;
+  // Computes the max and avg value of every feature over training_set, by
+  // which NormalizeFeatures(..) normalizes it.
+  // training_set should not be empty; the others should not be NULL.
+  void ComputeNormalization(const FeatureMatrix &training_set,
+                            FeatureVector *max_feature_value,
+                            FeatureVector *avg_feature_value) const;
+  // Normalizes the features of one example of the training set, as
+  // NormalizeFeatures(..) does, see NormalizeFeatureRow(..).
+  // features should not be NULL.
+  static void NormalizeExample(const FeatureVector &max_feature_value,
+                               const FeatureVector &avg_feature_value,
+                               float *features);
 
  private:
-  // generates a set of unnormalized features which represent the mean color of
-  // different regions of the image:
-  std::vector<cv::Scalar> ColorFeaturesFromImage(const Image &image) const;
-  // returns a vector of vectors of floats containing as many rows as examples,
-  // each with kNumberOfFeatures columns, filled with scaled and normalized data
+  // The result of K-Means for one number of clusters:
+  struct KCandidate {
+    std::vector<int> labels;
+    FeatureMatrix centers;
+    double compactness = 0;
+  };
+  // What the search for K remembers from the previous number of clusters:
+  struct KSearchState {
+    // the computed error cannot be negative, so -1 means there is none:
+    float previous_error = -1;
+    float previous_error_ratio = 1;
+    // the score of the previous number of clusters, when the Elbow method is
+    // not used:
+    double best_score = -DBL_MAX;
+  };
+  // returns a matrix with a row for every example, holding its
+  // kNumberOfFeatures ObjectFeatures, scaled and normalized:
   // objects should not be empty.
-  std::vector<std::vector<float>> AssignFeaturesFromObjects(
+  FeatureMatrix AssignFeaturesFromObjects(
     const std::vector<Object> &objects) const;
   // bring the training_set numbers in the range (-1; 1):
   // training_set should not be empty.
-  void NormalizeFeatures(std::vector<std::vector<float>> *training_set) const;
+  void NormalizeFeatures(FeatureMatrix *training_set) const;
   // as we try to find optimal number of clusters, we need to compute the
   // error for each case:
   // clusters, training_set and centroids should not be empty;
-  // num_of_training_examples and num_of_clusters should be >= 0;
-  float ComputeError(
-    const std::vector<int> &clusters,
-    const std::vector<std::vector<float>> &training_set,
-    const std::vector<std::vector<float>> &centroids,
-    const int &num_of_training_examples,
-    const int &num_of_clusters) const;
+  // clusters should have a value in [0; centroids.rows()) for every row of
+  // training_set.
+  float ComputeError(const std::vector<int> &clusters,
+                     const FeatureMatrix &training_set,
+                     const FeatureMatrix &centroids) const;
   // Clusters the training set with different random initial centroids then
   // chooses the best clustering and labels the objects accordingly.
   // training_set and objects should not be empty.
+  // The search is done by ClusterTrainingSet(..), the clustering itself by
+  // RunKMeans(..).
   int KMeansClusteringOpenCVImplementation(
-    const std::vector<std::vector<float>> &training_set,
+    const FeatureMatrix &training_set,
     std::vector<Object> *objects) const;
+  // Returns the error of the clustering for the Elbow method, as
+  // k_selection_criterion() says; compactness is the one returned by
+  // RunKMeans(..).
+  float ElbowError(const std::vector<int> &clusters,
+                   const FeatureMatrix &training_set,
+                   const FeatureMatrix &centroids,
+                   const double &compactness) const;
+  // Returns the score of the clustering for kDaviesBouldinCriterion and
+  // kSilhouetteCriterion; higher is better.
+  double ClusteringScore(const std::vector<int> &clusters,
+                         const FeatureMatrix &training_set,
+                         const FeatureMatrix &centroids) const;
+  // Returns true if clustering into candidate.centers.rows() clusters is
+  // better than into one less, and updates state; perfect tells whether the
+  // clustering cannot be improved any more.
+  // state and perfect should not be NULL.
+  bool IsBetterClustering(const KCandidate &candidate,
+                          const FeatureMatrix &training_set,
+                          KSearchState *state,
+                          bool *perfect) const;
+  // kParallelKSearch: runs every attempt for every number of clusters in
+  // [first_k; last_k] on the thread pool and keeps the best attempt of every
+  // one of them, in the order of K.
+  // window should not be NULL.
+  void RunKWindow(const FeatureMatrix &training_set,
+                  const int &first_k,
+                  const int &last_k,
+                  std::vector<KCandidate> *window) const;
+  // Copies the labels and the centers cv::kmeans(..) made into labels and
+  // centers, which should not be NULL.
+  void CopyKMeansResult(const cv::Mat &label_matrix,
+                        const cv::Mat &center_matrix,
+                        const int &num_of_columns,
+                        std::vector<int> *labels,
+                        FeatureMatrix *centers) const;
+  // Labels every row of data with its nearest center among the ones made by
+  // SeedCentersFromPrevious(..).
+  // labels should not be NULL.
+  void SeedLabelsFromCenters(const FeatureMatrix &data,
+                             const FeatureMatrix &previous_centers,
+                             std::vector<int> *labels) const;
   // Assigns the best_labeling to objects:
   void LabelObjects(const std::vector<int> &best_labeling,
                     std::vector<Object> *objects) const;
+
+  int max_k_ = kUnboundedNumberOfClusters;
+  KSearchMode k_search_mode_ = kColdKSearch;
+  KSelectionCriterion k_selection_criterion_ = kMeanDistanceCriterion;
+  int k_window_ = kParallelKWindow;
+  std::shared_ptr<ThreadPool> pool_;  // NULL until set_num_of_threads(..)
 };
 }  // namespace object_clustering
 #endif  // _OBJECT_CLUSTERING_K_MEANS_CLUSTERING_ALGORITHM_H_
@@ -0,0 +1,144 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// mini_batch_k_means_clustering_algorithm.h
+// Object Clustering
+// Declares a clustering algorithm for very large sets of objects: the Elbow
+// method of KMeansClusteringAlgorithm over a mini-batch K-Means.
+
+#ifndef OBJECT_CLUSTERING_MINI_BATCH_K_MEANS_CLUSTERING_ALGORITHM_H_
+#define OBJECT_CLUSTERING_MINI_BATCH_K_MEANS_CLUSTERING_ALGORITHM_H_
+
+#include <cassert>
+
+#include <vector>
+
+#include "feature_matrix.h"
+#include "feature_store.h"
+#include "native_k_means_clustering_algorithm.h"
+
+namespace object_clustering {
+// how many random rows every iteration looks at:
+const int kMiniBatchSize = 1024;
+// the run stops when no center moves farther than this in an iteration:
+const float kMiniBatchTolerance = 1e-3;
+const int kMiniBatchMaxIterations = 100;
+// how many rows of a feature store the number of clusters is searched on:
+const int kFeatureStoreSampleSize = 65536;
+// Instead of visiting every row in every iteration, each iteration draws a
+// random batch of rows, assigns them to their nearest centers and moves each
+// center towards its rows with a step of 1 / (rows it has seen so far), see
+// Sculley, "Web-scale k-means clustering". The seeding uses one batch as well.
+// Apart from the labels of the rows, which the caller needs anyway, the
+// memory used depends on the batch size and the number of clusters, not on
+// the number of rows. Only the final pass, which labels the rows and sums the
+// compactness, visits every row, and it visits them in order.
+// AssignGroupsToStore(..) goes one step further and clusters the rows of a
+// feature store, which need not fit into the memory.
+// Usage:
+// MiniBatchKMeansClusteringAlgorithm k;
+// k.set_batch_size(4096);
+// k.AssignGroupsToObjects(&objects);
+// To cluster the objects of a month of frames:
+// MappedFeatureStore store("detections.features");
+// std::vector<int> groups;
+// int num_of_groups = k.AssignGroupsToStore(store, &groups);
+// forward declaration for testing:
+class MiniBatchKMeansClusteringAlgorithmTest;
+class MiniBatchKMeansClusteringAlgorithm:
+    public NativeKMeansClusteringAlgorithm {
+  friend class MiniBatchKMeansClusteringAlgorithmTest;
+ public:
+  MiniBatchKMeansClusteringAlgorithm() = default;
+
+  MiniBatchKMeansClusteringAlgorithm(
+    const MiniBatchKMeansClusteringAlgorithm &algorithm) = default;
+
+  MiniBatchKMeansClusteringAlgorithm& operator=(
+    const MiniBatchKMeansClusteringAlgorithm &algorithm) = default;
+
+  virtual ~MiniBatchKMeansClusteringAlgorithm() = default;
+
+  int batch_size() const { return batch_size_; }
+  // batch_size should be > 0:
+  void set_batch_size(int batch_size) {
+    assert(batch_size > 0);
+    batch_size_ = batch_size;
+  }
+
+  float tolerance() const { return tolerance_; }
+  // tolerance should be >= 0:
+  void set_tolerance(float tolerance) {
+    assert(tolerance >= 0);
+    tolerance_ = tolerance;
+  }
+
+  int sample_size() const { return sample_size_; }
+  // sample_size should be > 0:
+  void set_sample_size(int sample_size) {
+    assert(sample_size > 0);
+    sample_size_ = sample_size;
+  }
+  // Clusters every row of store, chunk by chunk:
+  // 1. one pass over the store finds the max and avg value of every feature,
+  // for the normalization, and draws a uniform sample of sample_size() rows;
+  // 2. the number of clusters and the centers are searched on the normalized
+  // sample, the way AssignGroupsToObjects(..) searches them on the objects;
+  // 3. one more pass labels every row with its nearest center.
+  // Apart from groups, the memory used depends on the sample and the chunks,
+  // not on the store. Fills in the group of every row, in the order of the
+  // store, and returns the number of groups, 0 if the store is empty.
+  // store should be opened; groups should not be NULL.
+  int AssignGroupsToStore(const MappedFeatureStore &store,
+                          std::vector<int> *groups) const;
+  // Steps 1 and 2 of AssignGroupsToStore(..): keeps the normalization and
+  // the centers in model, which can then label the rows, or new objects.
+  // Returns the number of groups, 0 (and an empty model) if the store is
+  // empty.
+  // store should be opened; model should not be NULL.
+  int TrainModelOnStore(const MappedFeatureStore &store,
+                        ClusterModel *model) const;
+
+ protected:
+  // One mini-batch run: kColdKSearch seeds it by k-means++ over a batch,
+  // kWarmStartedKSearch by SeedCentersFromPrevious(..). Clusters which got
+  // no rows keep their label unused.
+  double RunKMeans(const FeatureMatrix &data,
+                   const int &num_of_clusters,
+                   const FeatureMatrix &previous_centers,
+                   std::vector<int> *labels,
+                   FeatureMatrix *centers) const override;
+  // One mini-batch run, seeded by k-means++ over a batch drawn from seed:
+  double RunKMeansAttempt(const FeatureMatrix &data,
+                          const int &num_of_clusters,
+                          const uint64_t &seed,
+                          std::vector<int> *labels,
+                          FeatureMatrix *centers) const override;
+
+ private:
+  // The run of RunKMeans(..), with the batches drawn by rng, which should not
+  // be NULL, as well as labels and centers.
+  double RunMiniBatch(const FeatureMatrix &data,
+                      const int &num_of_clusters,
+                      const FeatureMatrix &previous_centers,
+                      cv::RNG *rng,
+                      std::vector<int> *labels,
+                      FeatureMatrix *centers) const;
+  // Fills batch with batch_size_ random rows of data.
+  // rng and batch should not be NULL.
+  void DrawBatch(const FeatureMatrix &data,
+                 cv::RNG *rng,
+                 FeatureMatrix *batch) const;
+
+  // Pass 1 of AssignGroupsToStore(..): fills in the max and avg value of every
+  // feature over store, and sample with a sample of its rows, unnormalized.
+  // The arguments should not be NULL.
+  void ScanFeatureStore(const MappedFeatureStore &store,
+                        FeatureVector *max_feature_value,
+                        FeatureVector *avg_feature_value,
+                        FeatureMatrix *sample) const;
+
+  int batch_size_ = kMiniBatchSize;
+  float tolerance_ = kMiniBatchTolerance;
+  int sample_size_ = kFeatureStoreSampleSize;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_MINI_BATCH_K_MEANS_CLUSTERING_ALGORITHM_H_
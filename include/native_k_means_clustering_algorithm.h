@@ -0,0 +1,102 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// native_k_means_clustering_algorithm.h
+// Object Clustering
+// Declares a clustering algorithm which chooses the number of groups by the
+// same Elbow method as KMeansClusteringAlgorithm, but runs its own K-Means
+// instead of cv::kmeans(..).
+
+#ifndef OBJECT_CLUSTERING_NATIVE_K_MEANS_CLUSTERING_ALGORITHM_H_
+#define OBJECT_CLUSTERING_NATIVE_K_MEANS_CLUSTERING_ALGORITHM_H_
+
+#include <cstdint>
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "feature_matrix.h"
+#include "k_means_clustering_algorithm.h"
+
+namespace object_clustering {
+// The run stops after this many iterations or when no center moves farther
+// than kNativeKMeansEpsilon, the same criteria cv::kmeans(..) gets:
+const int kNativeKMeansMaxIterations = 10;
+const float kNativeKMeansEpsilon = 1.0;
+// The k-means++ seeding is random, but always starts from this seed, so that
+// the same objects always get the same groups:
+const uint64_t kNativeKMeansSeed = 0x5eed;
+// K-Means over the contiguous rows of a FeatureMatrix: every assignment step
+// finds the nearest center with the vectorized distance kernel, and every
+// update step sums the rows in place. The buffers are allocated once per run,
+// not per iteration. It is a drop-in replacement for
+// KMeansClusteringAlgorithm, with the same options.
+// Usage:
+// NativeKMeansClusteringAlgorithm k;
+// std::vector<Object> objects = ...;
+// k.AssignGroupsToObjects(&objects);
+class NativeKMeansClusteringAlgorithmTest;  // forward declaration for testing
+class NativeKMeansClusteringAlgorithm: public KMeansClusteringAlgorithm {
+  friend class NativeKMeansClusteringAlgorithmTest;
+ public:
+  NativeKMeansClusteringAlgorithm() = default;
+
+  NativeKMeansClusteringAlgorithm(
+    const NativeKMeansClusteringAlgorithm &algorithm) = default;
+
+  NativeKMeansClusteringAlgorithm& operator=(
+    const NativeKMeansClusteringAlgorithm &algorithm) = default;
+
+  virtual ~NativeKMeansClusteringAlgorithm() = default;
+
+ protected:
+  // kColdKSearch: kNumberOfIterationsPerOneRun runs from k-means++ centers,
+  // the one with the least compactness wins; kWarmStartedKSearch: one run
+  // from the centers made by SeedCentersFromPrevious(..).
+  double RunKMeans(const FeatureMatrix &data,
+                   const int &num_of_clusters,
+                   const FeatureMatrix &previous_centers,
+                   std::vector<int> *labels,
+                   FeatureMatrix *centers) const override;
+  // One run from k-means++ centers drawn from seed:
+  double RunKMeansAttempt(const FeatureMatrix &data,
+                          const int &num_of_clusters,
+                          const uint64_t &seed,
+                          std::vector<int> *labels,
+                          FeatureMatrix *centers) const override;
+
+  // The buffers of one RunKMeans(..) call:
+  struct Workspace {
+    FeatureMatrix centers;
+    FeatureMatrix sums;
+    std::vector<int> labels;
+    std::vector<int> counts;
+    std::vector<float> distances;  // squared, to the center of every row
+  };
+  // Allocates the buffers of workspace for num_of_clusters clusters of the
+  // rows of data; the centers are left to the seeding.
+  // workspace should not be NULL.
+  void CreateWorkspace(const FeatureMatrix &data,
+                       const int &num_of_clusters,
+                       Workspace *workspace) const;
+  // Chooses num_of_clusters rows of data as the centers, each next one with a
+  // probability proportional to its squared distance from the chosen ones.
+  // workspace->distances should have as many elements as data has rows.
+  // rng and workspace should not be NULL.
+  void SeedCentersPlusPlus(const FeatureMatrix &data,
+                           const int &num_of_clusters,
+                           cv::RNG *rng,
+                           Workspace *workspace) const;
+
+ private:
+  // Lloyd's iterations from workspace->centers; leaves the final centers and
+  // labels in the workspace and returns the compactness.
+  // workspace should not be NULL.
+  double Lloyd(const FeatureMatrix &data, Workspace *workspace) const;
+  // A cluster which lost all its rows takes the row farthest from its center
+  // out of a cluster which has more than one.
+  // workspace should not be NULL.
+  void FillEmptyClusters(const FeatureMatrix &data,
+                         Workspace *workspace) const;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_NATIVE_K_MEANS_CLUSTERING_ALGORITHM_H_
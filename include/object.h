@@ -8,6 +8,8 @@
 
 #include <cassert>
 
+#include <utility>
+
 #include "opencv2/opencv.hpp"
 
 #include "image.h"
@@ -30,17 +32,26 @@ class Object {
     group_(kNoGroup),
     grouped_(false) {}
 
+  explicit Object(Image &&image):
+    image_(std::move(image)),
+    group_(kNoGroup),
+    grouped_(false) {}
+  // Copies share the pixels of the image, see Image:
   Object(const Object &object) = default;
 
+  Object(Object &&object) = default;
+
   Object& operator=(const Object &object) = default;
 
+  Object& operator=(Object &&object) = default;
+
   virtual ~Object() = default;
 
   int group() const { return group_; }
 
   bool grouped() const { return grouped_; }
 
-  Image image() const { return image_; }
+  const Image& image() const { return image_; }
   // parameter group should have values >= -1;
   // A group is negative only when set to -1 which signifies that this object
   // does not have a group, otherwise it should be a positive number:
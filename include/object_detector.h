@@ -6,22 +6,84 @@
 #ifndef OBJECT_CLUSTERING_OBJECT_DETECTOR_H_
 #define OBJECT_CLUSTERING_OBJECT_DETECTOR_H_
 
+#include <cassert>
+
+#include <memory>
 #include <vector>
 
+#include "background_model.h"
+#include "connected_component_labeler.h"
+#include "detector_workspace.h"
 #include "object.h"
+#include "thread_pool.h"
 
 namespace object_clustering {
 const float kMinimalAreaForObjectIdentification = 2000;  // pixels
 const float kMaximalAreaForObjectIdentification = 50000;
+const int kNumberOfGrayLevels = 256;
+// With a thread pool, the frames are cut into tiles of this many rows:
+const int kDetectionTileHeight = 256;
+// Defines which thresholds are tried when searching for the contours:
+// kExhaustiveThresholdSearch - every gray level, from 0 to 255;
+// kDistinctLevelsThresholdSearch - only the levels which give a different
+// binary image, i.e. the gray levels which actually occur in the image.
+// Both modes give exactly the same result.
+enum ThresholdSearchMode {
+  kExhaustiveThresholdSearch,
+  kDistinctLevelsThresholdSearch
+};
+// Defines how the objects are found in the binary image:
+// kContoursBackend - OpenCV contours, approximated to polygons;
+// kConnectedComponentsBackend - connected blobs with their statistics computed
+// in one raster scan. The blob area is the number of its pixels, and holes
+// inside an object do not count as separate objects.
+enum DetectionBackend {
+  kContoursBackend,
+  kConnectedComponentsBackend
+};
+// Defines at which resolution the objects are searched for:
+// kFullResolutionDetection - the whole frame at full resolution;
+// kPyramidDetection - the whole frame downscaled by DownscaleFrame(..), with
+// the area limits scaled with it; then only the regions around the objects
+// found there are searched again at full resolution, with the full limits,
+// each for the threshold which gives the most objects in it. If the
+// downscaled frame has no object, or more foreground outside them than an
+// object takes there, the whole frame is searched at full resolution instead.
+// A frame whose objects all prefer the threshold the whole frame does gives
+// the same objects both ways.
+enum DetectionResolution {
+  kFullResolutionDetection,
+  kPyramidDetection
+};
+// The coarse area limits are widened by this factor, so the objects whose
+// area is close to a limit are not lost by the downscaling; the full
+// resolution search applies the exact limits:
+const float kPyramidAreaSlack = 2;
+// The regions searched at full resolution reach this many pixels beyond the
+// objects found on the coarse frame:
+const int kPyramidMargin = 16;
 // Detects the objects from the image.
 // Usage:
 // object_clustering::Image background = ...;
 // object_clustering::Image image = ...;
 // object_clustering::ObjectDetector detector;
 // auto objects = detector.DetectObjectsFromImage(image, background);
+// When many images share the same background, train the model once:
+// object_clustering::BackgroundModel model(background);
+// auto objects = detector.DetectObjectsFromImage(image, model);
+// To detect in large frames on 8 threads:
+// detector.set_num_of_threads(8);
+// To search a downscaled frame first:
+// detector.set_detection_resolution(kPyramidDetection);
+// To detect the frames of a stream in the same buffers, one workspace per
+// thread:
+// object_clustering::DetectorWorkspace workspace;
+// detector.DetectObjectsFromImage(image, model, &workspace, &objects);
 class ObjectDetectorTest;  // forward declaration for testing
+class PipelineBenchmark;  // and for benchmarking
 class ObjectDetector {
   friend class ObjectDetectorTest;
+  friend class PipelineBenchmark;
  public:
   ObjectDetector() = default;
   // No need to copy a detector:
@@ -32,55 +94,216 @@ class ObjectDetector {
   virtual ~ObjectDetector() = default;
   // Takes two images of the same size. One image is a clear background, like a
   // plain floor, and on the other the objects are present.
-  // Returns a vector of detected objects.
+  // Returns a vector of detected objects, empty if there are none.
   std::vector<Object> DetectObjectsFromImage(const Image &image,
                                              const Image &background) const;
+  // Same as above, but the background model is already trained.
+  // image should be of the size of the background of the model.
+  std::vector<Object> DetectObjectsFromImage(
+      const Image &image,
+      const BackgroundModel &background) const;
+  // Same as above, but works in the buffers of workspace and replaces objects
+  // with the objects found, so that detecting frame after frame through the
+  // same workspace and objects allocates nothing once they are warm, see
+  // DetectorWorkspace.
+  // workspace and objects should not be NULL.
+  void DetectObjectsFromImage(const Image &image,
+                              const BackgroundModel &background,
+                              DetectorWorkspace *workspace,
+                              std::vector<Object> *objects) const;
+
+  ThresholdSearchMode threshold_search_mode() const {
+    return threshold_search_mode_;
+  }
+
+  void set_threshold_search_mode(ThresholdSearchMode mode) {
+    threshold_search_mode_ = mode;
+  }
+
+  DetectionBackend detection_backend() const { return detection_backend_; }
+
+  void set_detection_backend(DetectionBackend backend) {
+    detection_backend_ = backend;
+  }
+
+  DetectionResolution detection_resolution() const {
+    return detection_resolution_;
+  }
+
+  void set_detection_resolution(DetectionResolution resolution) {
+    detection_resolution_ = resolution;
+  }
+  // Runs the detection on a pool of num_of_threads threads, one per hardware
+  // thread if it is <= 0. The preprocessing works on tiles of tile_height()
+  // rows; the thresholds are tried at the same time, and with
+  // kConnectedComponentsBackend every tile is labeled on its own and the blobs
+  // crossing the seams are joined. The objects are the same as without the
+  // pool, which runs everything in the calling thread.
+  void set_num_of_threads(int num_of_threads) {
+    pool_ = std::make_shared<ThreadPool>(num_of_threads);
+  }
+
+  int tile_height() const { return tile_height_; }
+  // tile_height should be > 0:
+  void set_tile_height(int tile_height) {
+    assert(tile_height > 0);
+    tile_height_ = tile_height;
+  }
 
  private:
-  // Returns true if the rect rectangles[index] has its center inside of any of
-  // the other rectangles:
-  // rectangles should not be empty;
-  bool RectCenterInsideOtherRect(const int &index,
-                               const cv::vector<cv::Rect> &rectangles) const;
   // This method subtracts the two given images, returning a mask containing
   // only black & white pixels, denoting the objects. Shadow is also eliminated
   // here.
   // images should be of the same size.
   cv::Mat ComputeForegroundMask(const Image &image,
                                 const Image &background) const;
+  // Same as above, but the shadow is left marked with kShadowIntensity:
+  cv::Mat ComputeRawForegroundMask(const Image &image,
+                                   const BackgroundModel &background) const;
   // Simple transformation which makes all exactly black pixels (0,0,0) ->
   // white and all the other black.
   // mat should not be NULL.
   void RecolorDetectedPixels(cv::Mat *mat) const;
   // Given the image and the background, returns a grayed matrix of black &
-  // white pixels after background subtraction & recoloring:
+  // white pixels after background subtraction & recoloring. The steps after
+  // the background subtraction are fused, see ForegroundToBlurredGray(..):
   cv::Mat ExtractForegroundAndPreprocess(const Image &image,
                                          const Image &background) const;
-  // Fills in the detected rectangles of objects from the given gray matrix:
+
+  cv::Mat ExtractForegroundAndPreprocess(
+      const Image &image,
+      const BackgroundModel &background) const;
+  // Same as above, into the gray matrix of workspace:
+  const cv::Mat& ExtractForegroundAndPreprocess(
+      const Image &image,
+      const BackgroundModel &background,
+      DetectorWorkspace *workspace) const;
+  // Finds the rects of the objects in the whole frame at full resolution, and
+  // appends them to good_rects.
+  // workspace and good_rects should not be NULL.
+  void DetectRectsAtFullResolution(const Image &image,
+                                   const BackgroundModel &background,
+                                   DetectorWorkspace *workspace,
+                                   cv::vector<cv::Rect> *good_rects) const;
+  // Same as above, but by the coarse-to-fine search described at
+  // kPyramidDetection:
+  void DetectRectsCoarseToFine(const Image &image,
+                               const BackgroundModel &background,
+                               DetectorWorkspace *workspace,
+                               cv::vector<cv::Rect> *good_rects) const;
+  // Returns the number of foreground pixels of mask, neither 0 nor
+  // kShadowIntensity, which are inside none of rects:
+  int CountForegroundOutside(const cv::Mat &mask,
+                             const cv::vector<cv::Rect> &rects) const;
+  // Returns true if an object of the given area is neither too small nor too
+  // big. level is the number of times the frame was halved, see
+  // DownscaleFrame(..): on a downscaled frame the limits are scaled with the
+  // frame and widened by kPyramidAreaSlack.
+  bool HasObjectArea(const float &area, const int &level) const;
+  // Fills in the detected rectangles of objects from the given gray matrix,
+  // whose objects are measured at the given level, see HasObjectArea(..):
   // threshold_output and good_rects should not be NULL.
   void DetectBoundingRectsAndEdges(const cv::Mat &src_gray,
                                    cv::Mat *threshold_output,
-                                   cv::vector<cv::Rect> *good_rects) const;
+                                   cv::vector<cv::Rect> *good_rects,
+                                   const int &level = 0) const;
+  // Same as above, in the buffers of workspace, which should not be NULL:
+  void DetectBoundingRectsAndEdges(const cv::Mat &src_gray,
+                                   cv::Mat *threshold_output,
+                                   cv::vector<cv::Rect> *good_rects,
+                                   const int &level,
+                                   DetectorWorkspace *workspace) const;
+  // Appends to good_rects the rects of the objects in the binary image of
+  // src_gray for threshold, found by the backend without any search:
+  // workspace and good_rects should not be NULL.
+  void DetectBoundingRectsAtThreshold(const cv::Mat &src_gray,
+                                      const int &threshold,
+                                      const int &level,
+                                      DetectorWorkspace *workspace,
+                                      cv::vector<cv::Rect> *good_rects) const;
   // Detects the contours of the objects from the gray image. Determines also
   // the threshold which gives the most contours. The contours which are either
   // too small or too big are ignored.
   // best_contours and threshold_output should not be NULL.
   void DetectContoursInMatrixWithThresholdOutput(const cv::Mat &gray,
                               cv::vector<cv::vector<cv::Point>> *best_contours,
-                              cv::Mat *threshold_output) const;
-  // Finds the enclosing rectangles for the given contours:
-  // contours should not be empty;
+                              cv::Mat *threshold_output,
+                              const int &level = 0) const;
+  // Tries every threshold as the method above does, but only counts the good
+  // contours of each. Returns the first threshold with the most of them, -1
+  // if no threshold gives any; workspace is left with the candidate
+  // thresholds.
+  // workspace should not be NULL.
+  int FindBestContourThreshold(const cv::Mat &gray,
+                               const int &level,
+                               DetectorWorkspace *workspace) const;
+  // Same as above, but for the kConnectedComponentsBackend: finds the blobs
+  // for every threshold and keeps the rects of the good ones for the threshold
+  // which gives the most of them. threshold_output is set to the binary image
+  // of that threshold.
+  // good_rects and threshold_output should not be NULL.
+  void DetectBlobsInMatrixWithThresholdOutput(const cv::Mat &gray,
+                                              cv::vector<cv::Rect> *good_rects,
+                                              cv::Mat *threshold_output,
+                                              const int &level = 0) const;
+  // Same as above, in the buffers of workspace, which should not be NULL:
+  void DetectBlobsInMatrixWithThresholdOutput(
+      const cv::Mat &gray,
+      cv::vector<cv::Rect> *good_rects,
+      cv::Mat *threshold_output,
+      const int &level,
+      DetectorWorkspace *workspace) const;
+  // Returns the thresholds which should be tried for the given gray matrix,
+  // in increasing order. In kDistinctLevelsThresholdSearch mode, thresholds
+  // which give the same binary image are collapsed into the first of them.
+  // gray should be of type CV_8UC1.
+  std::vector<int> CandidateThresholds(const cv::Mat &gray) const;
+  // Same as above, into thresholds, which should not be NULL:
+  void CandidateThresholds(const cv::Mat &gray,
+                           std::vector<int> *thresholds) const;
+  // Runs task(i) for every i in [0; num_of_tasks), on the pool if there is
+  // one, in the calling thread otherwise. Without a pool the task is called
+  // as it is, not through a std::function, which would take memory from the
+  // heap for every search:
+  template <typename Task>
+  void RunTasks(const int &num_of_tasks, const Task &task) const {
+    if (pool_) {
+      pool_->ParallelFor(0, num_of_tasks, task);
+      return;
+    }
+    for (int i = 0; i < num_of_tasks; i++) {
+      task(i);
+    }
+  }
+  // How many tiles a frame of num_of_rows rows is cut into; one if there is
+  // no pool:
+  int NumberOfTiles(const int &num_of_rows) const;
+  // Finds the enclosing rectangles for the given contours, the polygons being
+  // approximated into polygon if it is not NULL:
   // good_rects should not be NULL.
   void GetGoodBoundingRectsOfContours(
       const cv::vector<cv::vector<cv::Point>> &contours,
-      cv::vector<cv::Rect> *good_rects) const;
+      cv::vector<cv::Rect> *good_rects,
+      const int &level = 0,
+      cv::vector<cv::Point> *polygon = nullptr) const;
   // Given the initial image (src) the method creates the objects from the
-  // rectangles that have been found.
-  // good_rects should not be empty.
+  // rectangles that have been found. No rectangles give no objects.
   std::vector<Object> GetObjectsFromRects(
       const cv::vector<cv::Rect> &good_rects,
-      const cv::Mat &threshold_output,
       const cv::Mat &src) const;
+  // Same as above, but replaces objects with them, and suppresses the nested
+  // rects in the buffers of workspace.
+  // workspace and objects should not be NULL.
+  void GetObjectsFromRects(const cv::vector<cv::Rect> &good_rects,
+                           const cv::Mat &src,
+                           DetectorWorkspace *workspace,
+                           std::vector<Object> *objects) const;
+
+  ThresholdSearchMode threshold_search_mode_ = kDistinctLevelsThresholdSearch;
+  DetectionBackend detection_backend_ = kContoursBackend;
+  DetectionResolution detection_resolution_ = kFullResolutionDetection;
+  int tile_height_ = kDetectionTileHeight;
+  std::shared_ptr<ThreadPool> pool_;  // NULL until set_num_of_threads(..)
 };
 }  // namespace object_clustering
 #endif  // OBJECT_CLUSERING_OBJECT_DETECTOR_H_
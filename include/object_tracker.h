@@ -0,0 +1,132 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// object_tracker.h
+// Object Clustering
+// Declares a tracker which carries the groups of the objects of a frame over
+// to the same objects on the next frame, so that only the new or changed
+// objects are clustered.
+
+#ifndef OBJECT_CLUSTERING_OBJECT_TRACKER_H_
+#define OBJECT_CLUSTERING_OBJECT_TRACKER_H_
+
+#include <cassert>
+#include <cstdint>
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "abstract_cluster_algorithm.h"
+#include "cluster_model.h"
+#include "feature_descriptor.h"
+#include "object.h"
+
+namespace object_clustering {
+// an object is the one of the previous frame only if their rects overlap by
+// at least this much, as intersection over union:
+const float kTrackerMinOverlap = 0.8;
+// and if their mean colors differ by at most this much on every channel:
+const float kTrackerMaxColorShift = 12;
+// the mean colors are taken over every this many rows and columns, a
+// sixteenth of the pixels, since a swap of objects changes them far more:
+const int kTrackerColorStride = 4;
+// Matches the objects of a frame to the ones of the previous frame of the
+// same stream. An object is the same as a previous one when the center of
+// its rect is inside the previous rect, the rects overlap by at least
+// min_overlap() and their mean colors are within max_color_shift(); every
+// previous object is matched at most once, the biggest overlaps first. The
+// matched objects (hits) get the group of the previous one, without their
+// features being extracted; the others (misses) are grouped anew.
+// When the algorithm keeps its groups, see
+// AbstractClusterAlgorithm::keeps_groups(), the misses are given to it. Any
+// other algorithm numbers the groups anew on every call, so it only clusters
+// the frames without a hit, as a whole; the tracker then keeps the features
+// of the frame and the centers of its groups in a ClusterModel, and a miss of
+// the frames after it gets the group of its nearest center. The features of
+// the hits are carried over from the previous frame, so only the misses are
+// extracted.
+// A tracker follows one stream, frame after frame, from one thread at a time.
+// Usage:
+// object_clustering::ObjectTracker tracker;
+// for every frame:
+//   auto objects = detector.DetectObjectsFromImage(frame, background);
+//   int num_of_groups = tracker.AssignGroupsToObjects(clusterer, &objects);
+// the objects not clustered: tracker.num_of_hits()
+class ObjectTrackerTest;  // forward declaration for testing
+class ObjectTracker {
+  friend class ObjectTrackerTest;
+ public:
+  ObjectTracker() = default;
+  // A copy follows the same stream from the same frame:
+  ObjectTracker(const ObjectTracker &tracker) = default;
+
+  ObjectTracker& operator=(const ObjectTracker &tracker) = default;
+
+  virtual ~ObjectTracker() = default;
+  // Labels the objects of the next frame: the hits by the previous frame, the
+  // misses by clusterer. Returns the number of groups clusterer gave last,
+  // 0 if objects is empty.
+  // objects should not be NULL.
+  int AssignGroupsToObjects(const AbstractClusterAlgorithm &clusterer,
+                            std::vector<Object> *objects);
+  // Forgets the previous frame and its groups, at a cut of the stream for
+  // instance; the counters are kept.
+  void Reset();
+
+  float min_overlap() const { return min_overlap_; }
+  // min_overlap should be in (0; 1]:
+  void set_min_overlap(float min_overlap) {
+    assert((min_overlap > 0) && (min_overlap <= 1));
+    min_overlap_ = min_overlap;
+  }
+
+  float max_color_shift() const { return max_color_shift_; }
+  // max_color_shift should be >= 0:
+  void set_max_color_shift(float max_color_shift) {
+    assert(max_color_shift >= 0);
+    max_color_shift_ = max_color_shift;
+  }
+  // objects which got the group of a previous one:
+  int64_t num_of_hits() const { return num_of_hits_; }
+  // objects which were clustered:
+  int64_t num_of_misses() const { return num_of_misses_; }
+
+ private:
+  // An object of the previous frame:
+  struct Track {
+    cv::Rect rect;
+    cv::Scalar color;  // the mean one
+    int group;
+    FeatureVector features;  // unnormalized; with model_ only
+  };
+  // Returns the intersection over union of two rects, 0 if one is empty:
+  static float Overlap(const cv::Rect &first, const cv::Rect &second);
+  // Returns the mean color of the pixels of matrix on every
+  // kTrackerColorStride-th row and column, starting with the first one.
+  // matrix should have 8-bit channels, at most 4 of them.
+  static cv::Scalar MeanColor(const cv::Mat &matrix);
+  // Fills in matches[i] with the previous object which object i is, -1 for
+  // none.
+  // colors should have the MeanColor(..) of every object, matches should not
+  // be NULL.
+  void MatchObjects(const std::vector<Object> &objects,
+                    const std::vector<cv::Scalar> &colors,
+                    std::vector<int> *matches) const;
+  // Builds model_ from the features and the groups of tracks_, which were
+  // clustered as a whole into num_of_groups_ groups: the features are
+  // normalized over them, as K-Means normalizes its training set, and the
+  // center of a group is the mean of its objects. model_ is left empty if a
+  // group has no object.
+  void BuildModel();
+
+  std::vector<Track> tracks_;  // the objects of the previous frame
+  // the groups of the frame last clustered as a whole, when the algorithm
+  // does not keep its groups:
+  ClusterModel model_;
+  int num_of_groups_ = 0;  // given by the clustering algorithm last
+  float min_overlap_ = kTrackerMinOverlap;
+  float max_color_shift_ = kTrackerMaxColorShift;
+  int64_t num_of_hits_ = 0;
+  int64_t num_of_misses_ = 0;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_OBJECT_TRACKER_H_
@@ -0,0 +1,79 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// pooling_mat_allocator.h
+// Object Clustering
+// Declares an OpenCV matrix allocator which keeps the released buffers for the
+// next matrices instead of freeing them.
+
+#ifndef OBJECT_CLUSTERING_POOLING_MAT_ALLOCATOR_H_
+#define OBJECT_CLUSTERING_POOLING_MAT_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <mutex>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+namespace object_clustering {
+// The smallest buffer the pool hands out; the bigger ones are rounded up to
+// this times 1, 1.25, 1.5, 1.75, 2, 2.5, ..., so a buffer is at most a quarter
+// bigger than asked for:
+const size_t kMinPooledBlockBytes = 4096;
+// A cv::MatAllocator whose released buffers go into free lists, one per size
+// class, and are handed out again to the next matrices of the same class.
+// Once a loop has allocated the biggest matrices it needs, its matrices take
+// no memory from the system anymore, whatever their sizes from one iteration
+// to the next. The buffers are freed by the destructor, or by Trim().
+// A matrix uses the allocator when it is set before the matrix is created;
+// the allocator should outlive every matrix it allocated. It may be used from
+// several threads at once.
+// Usage:
+// object_clustering::PoolingMatAllocator pool;
+// cv::Mat binary;
+// binary.allocator = &pool;
+// cv::threshold(gray, binary, 127, 255, cv::THRESH_BINARY);
+class PoolingMatAllocatorTest;  // forward declaration for testing
+class PoolingMatAllocator: public cv::MatAllocator {
+  friend class PoolingMatAllocatorTest;
+ public:
+  PoolingMatAllocator() = default;
+  // The matrices point to the allocator, so it is not copied:
+  PoolingMatAllocator(const PoolingMatAllocator &allocator) = delete;
+
+  PoolingMatAllocator& operator=(const PoolingMatAllocator &allocator) =
+    delete;
+  // Frees the pooled buffers:
+  virtual ~PoolingMatAllocator();
+  // Called by cv::Mat::create(..): hands out a pooled buffer of the size
+  // class of the matrix, or a new one if there is none, with the reference
+  // counter right after the pixels.
+  void allocate(int dims, const int *sizes, int type, int *&refcount,
+                uchar *&datastart, uchar *&data, size_t *step) override;
+  // Called when the last matrix of a buffer is released: the buffer goes back
+  // into its free list.
+  void deallocate(int *refcount, uchar *datastart,
+                  uchar * /* data */) override;
+  // Frees the pooled buffers; the ones in use stay with their matrices.
+  void Trim();
+  // buffers taken from the system:
+  int64_t num_of_allocations() const;
+  // buffers handed out from the free lists:
+  int64_t num_of_reuses() const;
+  // bytes of the buffers in the free lists:
+  size_t pooled_bytes() const;
+
+ private:
+  // Returns the index of the smallest size class of at least bytes, and sets
+  // class_bytes to its size.
+  // class_bytes should not be NULL.
+  static int SizeClassOf(const size_t &bytes, size_t *class_bytes);
+
+  mutable std::mutex mutex_;  // guards everything below
+  std::vector<std::vector<uchar*>> free_blocks_;  // by size class
+  int64_t num_of_allocations_ = 0;
+  int64_t num_of_reuses_ = 0;
+  size_t pooled_bytes_ = 0;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_POOLING_MAT_ALLOCATOR_H_
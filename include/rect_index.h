@@ -0,0 +1,88 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// rect_index.h
+// Object Clustering
+// Declares a spatial index over a set of rectangles, and the suppression of
+// the rectangles nested into bigger ones, which is built on it.
+
+#ifndef OBJECT_CLUSTERING_RECT_INDEX_H_
+#define OBJECT_CLUSTERING_RECT_INDEX_H_
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+namespace object_clustering {
+// A uniform grid over the bounding box of the rectangles: every cell lists the
+// rectangles which overlap it, so the rectangles containing a point are looked
+// for among the few of its cell only. The cell side is about the side of an
+// average rectangle, and there are at most a few cells per rectangle, so the
+// index takes O(n) memory for n rectangles of similar sizes.
+// Usage:
+// RectIndex index(rectangles);
+// std::vector<int> containing;
+// index.FindContaining(cv::Point(10, 20), &containing);
+// To index the rectangles of the next frame in the same buffers:
+// index.Build(next_rectangles);
+class RectIndex {
+ public:
+  // The rectangles are copied; the empty ones contain no point.
+  explicit RectIndex(const std::vector<cv::Rect> &rectangles);
+
+  RectIndex(const RectIndex &index) = default;
+
+  RectIndex& operator=(const RectIndex &index) = default;
+
+  virtual ~RectIndex() = default;
+
+  int size() const { return static_cast<int>(rectangles_.size()); }
+  // index should be in [0; size()):
+  const cv::Rect& rect(const int &index) const { return rectangles_[index]; }
+  // Indexes rectangles instead of the current ones, as the constructor does,
+  // reusing the buffers of the index.
+  void Build(const std::vector<cv::Rect> &rectangles);
+  // Replaces indices with the indices of the rectangles which contain point,
+  // as cv::Rect::contains(..) says, in increasing order.
+  // indices should not be NULL.
+  void FindContaining(const cv::Point &point, std::vector<int> *indices) const;
+  // Same as above, but calls visit(index) for each of them instead of
+  // collecting them:
+  template <typename Visitor>
+  void ForEachContaining(const cv::Point &point, Visitor visit) const {
+    int cell = CellOf(point);
+    if (cell < 0) return;
+    for (int member = cell_starts_[cell];
+         member < cell_starts_[cell + 1];
+         member++) {
+      int index = cell_members_[member];
+      if (rectangles_[index].contains(point)) visit(index);
+    }
+  }
+
+ private:
+  // Returns the index of the cell of the point, -1 if it is outside the grid:
+  int CellOf(const cv::Point &point) const;
+
+  std::vector<cv::Rect> rectangles_;
+  cv::Rect bounds_;  // of the grid, covers every non-empty rectangle
+  int cell_side_ = 1;
+  int num_of_columns_ = 0;
+  int num_of_rows_ = 0;
+  // the rectangles of cell c are cell_members_[cell_starts_[c]] up to
+  // cell_members_[cell_starts_[c + 1]], in increasing order:
+  std::vector<int> cell_starts_;
+  std::vector<int> cell_members_;
+};
+// Returns the indices, in increasing order, of the rectangles whose center is
+// not inside any rectangle with a bigger area: the others are parts of a
+// bigger object. It is the same as checking every pair of rectangles, but
+// takes about O(n) for n rectangles of similar sizes.
+std::vector<int> SuppressNestedRects(const std::vector<cv::Rect> &rectangles);
+// Same as above, but builds the index into index and the indices into kept,
+// so that reusing them for many frames allocates nothing once they are big
+// enough.
+// index and kept should not be NULL.
+void SuppressNestedRects(const std::vector<cv::Rect> &rectangles,
+                         RectIndex *index,
+                         std::vector<int> *kept);
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_RECT_INDEX_H_
@@ -0,0 +1,112 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// result_writer.h
+// Object Clustering
+// Declares the headless output of the clustering results: annotated images
+// and machine-readable records, written in the background.
+
+#ifndef OBJECT_CLUSTERING_RESULT_WRITER_H_
+#define OBJECT_CLUSTERING_RESULT_WRITER_H_
+
+#include <cstdio>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "bounded_queue.h"
+#include "object.h"
+
+namespace object_clustering {
+// how many results may wait to be written:
+const int kResultQueueCapacity = 16;
+const int kResultRectThickness = 5;  // pixels
+// Returns a copy of image with the rectangle of every object drawn in the
+// color of its group. The objects are drawn in one pass, the colors being taken
+// from a fixed palette by the group number; objects without a group are gray.
+cv::Mat AnnotateResult(const cv::Mat &image,
+                       const std::vector<Object> &objects);
+// The same, for the rectangles and groups of the objects:
+// rects and groups should be of the same size.
+cv::Mat AnnotateResult(const cv::Mat &image,
+                       const std::vector<cv::Rect> &rects,
+                       const std::vector<int> &groups);
+// The format of the file with the records of the results:
+// kJsonRecords - results.json, one JSON object per line:
+//   {"name": "...", "num_of_groups": 2,
+//    "objects": [{"x": 1, "y": 2, "width": 3, "height": 4, "group": 0}, ...]}
+// kBinaryRecords - results.bin, a sequence of records of native-endian 32-bit
+//   integers: name length, name bytes, num_of_groups, number of objects, then
+//   x, y, width, height, group for every object.
+enum RecordFormat {
+  kNoRecords,
+  kJsonRecords,
+  kBinaryRecords
+};
+// Writes the results into a directory without any window. Write() only
+// queues the result: the drawing, the encoding of the images and the writing
+// of the records are done by a thread of the writer, so they do not delay the
+// processing of the next frame. The records are buffered.
+// Usage:
+// object_clustering::ResultWriter writer("out", true, kJsonRecords);
+// writer.Write("frame_0001", image, objects, num_of_groups);
+// writer.Close();  // or let the destructor wait for the writes
+class ResultWriter {
+ public:
+  ResultWriter() = delete;
+  // directory should exist. If write_images, "<name>.png" files are written
+  // with the annotated images.
+  ResultWriter(const std::string &directory,
+               const bool &write_images,
+               const RecordFormat &format);
+
+  ResultWriter(const ResultWriter &writer) = delete;
+
+  ResultWriter& operator=(const ResultWriter &writer) = delete;
+  // Waits for the queued results:
+  virtual ~ResultWriter();
+  // false if the records file could not be created:
+  bool IsOpened() const {
+    return (format_ == kNoRecords) || (records_ != NULL);
+  }
+  // Queues the result of one image. It can be called from any thread. The
+  // pixels of image should not be changed afterwards; name should be usable as
+  // a file name.
+  void Write(const std::string &name,
+             const cv::Mat &image,
+             const std::vector<Object> &objects,
+             const int &num_of_groups);
+  // Writes the queued results and closes the files; later writes are ignored.
+  void Close();
+  // how many images or records could not be written:
+  int num_of_errors() const { return num_of_errors_; }
+
+ private:
+  struct Job {
+    std::string name;
+    cv::Mat image;
+    std::vector<cv::Rect> rects;
+    std::vector<int> groups;
+    int num_of_groups;
+  };
+
+  void WriterLoop();
+
+  void WriteJsonRecord(const Job &job);
+
+  void WriteBinaryRecord(const Job &job);
+
+  std::string directory_;
+  bool write_images_;
+  RecordFormat format_;
+  FILE *records_ = NULL;
+  std::vector<char> records_buffer_;
+  std::atomic<int> num_of_errors_;
+  BoundedQueue<Job> queue_;
+  std::thread thread_;
+  bool closed_ = false;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_RESULT_WRITER_H_
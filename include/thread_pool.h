@@ -0,0 +1,58 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// thread_pool.h
+// Object Clustering
+// Declares a fixed-size pool of worker threads.
+
+#ifndef OBJECT_CLUSTERING_THREAD_POOL_H_
+#define OBJECT_CLUSTERING_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace object_clustering {
+// The threads are started once and run the submitted tasks in the order of
+// submission. The destructor finishes the remaining tasks before joining.
+// Usage:
+// object_clustering::ThreadPool pool(4);
+// pool.Submit([] { ... });
+// pool.ParallelFor(0, n, [&](int i) { ... });
+class ThreadPool {
+ public:
+  // num_of_threads <= 0 means one thread per hardware thread:
+  explicit ThreadPool(const int &num_of_threads);
+  // The threads are not copied:
+  ThreadPool(const ThreadPool &pool) = delete;
+
+  ThreadPool& operator=(const ThreadPool &pool) = delete;
+
+  virtual ~ThreadPool();
+  // Queues the task; a task should not throw.
+  void Submit(std::function<void()> task);
+  // Blocks until every submitted task is finished.
+  void Wait();
+  // Runs body(i) for every i in [begin; end) on the pool and blocks until all
+  // of them are finished. If body throws, the other indices still run, and
+  // the first exception is rethrown by this call. It should not be called
+  // from a task of the same pool.
+  void ParallelFor(const int &begin, const int &end,
+                   const std::function<void(int)> &body);
+
+  int num_of_threads() const { return static_cast<int>(threads_.size()); }
+
+ private:
+  void WorkerLoop();
+
+  std::vector<std::thread> threads_;
+  std::deque<std::function<void()>> tasks_;
+  int num_of_running_tasks_ = 0;
+  bool stopping_ = false;
+  std::mutex mutex_;
+  std::condition_variable task_available_;
+  std::condition_variable all_done_;
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_THREAD_POOL_H_
@@ -0,0 +1,386 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// background_model.cc
+// Object Clustering
+
+#include <cassert>
+
+#include <algorithm>
+#include <utility>
+
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include "background_model.h"
+
+namespace object_clustering {
+namespace {
+// The biggest mixtures and pixels BackgroundModel::Subtractor::Classify(..)
+// takes; the subtractor is built with the default 5 modes:
+const int kMaxBackgroundModes = 8;
+const int kMaxBackgroundChannels = 4;
+// A mode of the mixture of a pixel, as cv::BackgroundSubtractorMOG2 keeps it:
+struct Mode {
+  float weight;
+  float variance;
+};
+// The parameters of cv::BackgroundSubtractorMOG2 a pixel is classified with,
+// taken out of the subtractor once per frame:
+struct MixtureParameters {
+  int num_of_channels;
+  int max_num_of_modes;  // nmixtures
+  float background_ratio;  // backgroundRatio
+  float background_threshold;  // varThreshold
+  float fit_threshold;  // varThresholdGen
+  float initial_variance;  // fVarInit
+  float min_variance;  // fVarMin
+  float max_variance;  // fVarMax
+  float complexity_reduction;  // fCT
+  bool detect_shadows;  // bShadowDetection
+  uchar shadow_value;  // nShadowDetection
+  float shadow_threshold;  // fTau
+};
+// Moves the mode at from, with its mean, up to to, shifting the ones between
+// down by one.
+void MoveModeUp(int from, int to, int num_of_channels, Mode *modes,
+                float *means) {
+  for (int i = from; i > to; i--) {
+    std::swap(modes[i], modes[i - 1]);
+    std::swap_ranges(means + i * num_of_channels,
+                     means + (i + 1) * num_of_channels,
+                     means + (i - 1) * num_of_channels);
+  }
+}
+// Whether data is background: near enough to one of the modes before the
+// ones which sum to background_ratio, before the first mode it fits. This
+// depends on the mixture before learning from data, so it is only read.
+// The weights are the ones of the step of cv::BackgroundSubtractorMOG2 at
+// learning rate 0, see LearnPixel(..).
+inline bool IsBackground(const MixtureParameters &parameters,
+                         const float *data,
+                         int num_of_modes,
+                         const Mode *modes,
+                         const float *means) {
+  const float learning_rate = 0;
+  const float keep_rate = 1.f - learning_rate;
+  const float prune = -learning_rate * parameters.complexity_reduction;
+  int num_of_channels = parameters.num_of_channels;
+  float total_weight = 0;
+  const float *mean = means;
+  for (int mode = 0; mode < num_of_modes; mode++, mean += num_of_channels) {
+    float variance = modes[mode].variance;
+    float distance2 = 0;
+    for (int c = 0; c < num_of_channels; c++) {
+      float difference = mean[c] - data[c];
+      distance2 += difference * difference;
+    }
+    if ((total_weight < parameters.background_ratio) &&
+        (distance2 < parameters.background_threshold * variance)) {
+      return true;
+    }
+    if (distance2 < parameters.fit_threshold * variance) return false;
+    float weight = keep_rate * modes[mode].weight + prune;
+    if (weight < -prune) {
+      weight = 0;
+      num_of_modes--;
+    }
+    total_weight += weight;
+  }
+  return false;
+}
+// The step of cv::BackgroundSubtractorMOG2 for one pixel, at learning rate 0,
+// with the same floating point operations in the same order. At rate 0
+// learning changes no weight and no mean, but the variance of the mode which
+// fits is clamped, the weights are normalized, and the modes may be reordered
+// or a new one added, all of which the shadow test sees. modes and means are
+// the mixture of the pixel, changed in place; returns the new number of its
+// modes:
+// 1. Find the first mode the pixel fits, and learn from the pixel;
+// 2. normalize the weights;
+// 3. if no mode fits, add one at the pixel, replacing the last one if the
+// mixture is full.
+inline int LearnPixel(const MixtureParameters &parameters,
+                      const float *data,
+                      int num_of_modes,
+                      Mode *modes,
+                      float *means) {
+  const float learning_rate = 0;
+  const float keep_rate = 1.f - learning_rate;
+  const float prune = -learning_rate * parameters.complexity_reduction;
+  int num_of_channels = parameters.num_of_channels;
+  float difference[kMaxBackgroundChannels];
+  bool fits = false;
+  float total_weight = 0;
+  // 1:
+  float *mean = means;
+  for (int mode = 0; mode < num_of_modes; mode++, mean += num_of_channels) {
+    float weight = keep_rate * modes[mode].weight + prune;
+    int num_of_swaps = 0;
+    if (!fits) {
+      float variance = modes[mode].variance;
+      float distance2 = 0;
+      for (int c = 0; c < num_of_channels; c++) {
+        difference[c] = mean[c] - data[c];
+        distance2 += difference[c] * difference[c];
+      }
+      if (distance2 < parameters.fit_threshold * variance) {
+        fits = true;
+        weight += learning_rate;
+        float k = learning_rate / weight;
+        for (int c = 0; c < num_of_channels; c++) {
+          mean[c] -= k * difference[c];
+        }
+        float new_variance = variance + k * (distance2 - variance);
+        new_variance = std::max(new_variance, parameters.min_variance);
+        new_variance = std::min(new_variance, parameters.max_variance);
+        modes[mode].variance = new_variance;
+        // the modes stay sorted by weight, the ones of equal weight after it:
+        while ((mode - num_of_swaps > 0) &&
+               (weight >= modes[mode - num_of_swaps - 1].weight)) {
+          num_of_swaps++;
+        }
+        MoveModeUp(mode, mode - num_of_swaps, num_of_channels, modes, means);
+      }
+    }
+    if (weight < -prune) {
+      weight = 0;
+      num_of_modes--;
+    }
+    modes[mode - num_of_swaps].weight = weight;
+    total_weight += weight;
+  }
+  // 2:
+  total_weight = 1.f / total_weight;
+  for (int mode = 0; mode < num_of_modes; mode++) {
+    modes[mode].weight *= total_weight;
+  }
+  // 3:
+  if (!fits) {
+    int mode = num_of_modes == parameters.max_num_of_modes ?
+               num_of_modes - 1 : num_of_modes++;
+    if (num_of_modes == 1) {
+      modes[mode].weight = 1;
+    } else {
+      modes[mode].weight = learning_rate;
+      for (int i = 0; i < num_of_modes - 1; i++) {
+        modes[i].weight *= keep_rate;
+      }
+    }
+    std::copy(data, data + num_of_channels, means + mode * num_of_channels);
+    modes[mode].variance = parameters.initial_variance;
+    int new_place = mode;
+    while ((new_place > 0) &&
+           !(learning_rate < modes[new_place - 1].weight)) {
+      new_place--;
+    }
+    MoveModeUp(mode, new_place, num_of_channels, modes, means);
+  }
+  return num_of_modes;
+}
+// Whether data is a darker copy of one of the background modes: a * mean for
+// some a in [shadow_threshold, 1], near enough to it. Only the modes before
+// the ones which sum to background_ratio are tried.
+inline bool IsShadow(const MixtureParameters &parameters,
+                     const float *data,
+                     int num_of_modes,
+                     const Mode *modes,
+                     const float *means) {
+  int num_of_channels = parameters.num_of_channels;
+  float total_weight = 0;
+  const float *mean = means;
+  for (int mode = 0; mode < num_of_modes; mode++, mean += num_of_channels) {
+    float numerator = 0;
+    float denominator = 0;
+    for (int c = 0; c < num_of_channels; c++) {
+      numerator += data[c] * mean[c];
+      denominator += mean[c] * mean[c];
+    }
+    if (denominator == 0) return false;
+    if ((numerator <= denominator) &&
+        (numerator >= parameters.shadow_threshold * denominator)) {
+      float a = numerator / denominator;
+      float distance2 = 0;
+      for (int c = 0; c < num_of_channels; c++) {
+        float difference = a * mean[c] - data[c];
+        distance2 += difference * difference;
+      }
+      if (distance2 <
+          parameters.background_threshold * modes[mode].variance * a * a) {
+        return true;
+      }
+    }
+    total_weight += modes[mode].weight;
+    if (total_weight > parameters.background_ratio) return false;
+  }
+  return false;
+}
+// The mask of a pixel, as cv::BackgroundSubtractorMOG2 gives it at learning
+// rate 0, given its trained mixture, which is only read: the background,
+// most of the frame, needs no learning, and the foreground learns in a copy
+// of the mixture on the stack, for the shadow test.
+inline uchar ClassifyPixel(const MixtureParameters &parameters,
+                           const float *data,
+                           int num_of_modes,
+                           const Mode *trained_modes,
+                           const float *trained_means) {
+  if (IsBackground(parameters, data, num_of_modes, trained_modes,
+                   trained_means)) {
+    return 0;
+  }
+  if (!parameters.detect_shadows) return 255;
+  Mode modes[kMaxBackgroundModes];
+  float means[kMaxBackgroundModes * kMaxBackgroundChannels];
+  std::copy(trained_modes, trained_modes + num_of_modes, modes);
+  std::copy(trained_means,
+            trained_means + num_of_modes * parameters.num_of_channels, means);
+  num_of_modes = LearnPixel(parameters, data, num_of_modes, modes, means);
+  if (IsShadow(parameters, data, num_of_modes, modes, means)) {
+    return parameters.shadow_value;
+  }
+  return 255;
+}
+}  // namespace
+
+void DownscaleFrame(const cv::Mat &frame, cv::Mat *coarse_frame) {
+  assert(coarse_frame != nullptr);
+  cv::Mat levels[kCoarseLevels];
+  DownscaleFrameLevels(frame, levels);
+  *coarse_frame = levels[kCoarseLevels - 1];
+}
+
+void DownscaleFrameLevels(const cv::Mat &frame, cv::Mat *levels) {
+  assert(levels != nullptr);
+  const cv::Mat *level = &frame;
+  for (int i = 0; i < kCoarseLevels; i++) {
+    cv::pyrDown(*level, levels[i]);
+    level = &levels[i];
+  }
+}
+
+BackgroundModel::Subtractor::Subtractor():
+  cv::BackgroundSubtractorMOG2(kBackgroundHistory,
+                               kBackgroundVarThreshold,
+                               true) {  // shadow detection
+  fVarInit = kBackgroundVarInit;
+  fTau = kShadowThreshold;
+}
+// The state of cv::BackgroundSubtractorMOG2 is, for the pixel i of the frame,
+// in raster order:
+// - nmixtures modes at i * nmixtures in the first part of bgmodel;
+// - nmixtures means of nchannels values each, at i * nmixtures * nchannels in
+// the second part of bgmodel;
+// - the number of the modes used at i in bgmodelUsedModes.
+void BackgroundModel::Subtractor::Classify(const cv::Mat &image,
+                                           const cv::Rect &region,
+                                           cv::Mat *raw_mask) const {
+  assert(raw_mask != nullptr);
+  assert(image.size() == region.size());
+  assert(image.type() == frameType);
+  assert(image.depth() == CV_8U);
+  assert((region & cv::Rect(cv::Point(0, 0), frameSize)) == region);
+  assert(nmixtures <= kMaxBackgroundModes);
+  assert(image.channels() <= kMaxBackgroundChannels);
+  MixtureParameters parameters;
+  parameters.num_of_channels = image.channels();
+  parameters.max_num_of_modes = nmixtures;
+  parameters.background_ratio = backgroundRatio;
+  parameters.background_threshold = static_cast<float>(varThreshold);
+  parameters.fit_threshold = varThresholdGen;
+  parameters.initial_variance = fVarInit;
+  parameters.min_variance = fVarMin;
+  parameters.max_variance = fVarMax;
+  parameters.complexity_reduction = fCT;
+  parameters.detect_shadows = bShadowDetection;
+  parameters.shadow_value = nShadowDetection;
+  parameters.shadow_threshold = fTau;
+  int num_of_channels = parameters.num_of_channels;
+  static_assert(sizeof(Mode) == 2 * sizeof(float),
+                "a mode should be laid out as OpenCV lays it out");
+  const Mode *all_modes = reinterpret_cast<const Mode*>(bgmodel.ptr<float>());
+  const float *all_means = bgmodel.ptr<float>() +
+                           2 * nmixtures * frameSize.area();
+  raw_mask->create(region.size(), CV_8UC1);
+  float data[kMaxBackgroundChannels];
+  for (int y = 0; y < region.height; y++) {
+    const uchar *pixels = image.ptr<uchar>(y);
+    const uchar *modes_used = bgmodelUsedModes.ptr<uchar>(region.y + y) +
+                              region.x;
+    uchar *mask = raw_mask->ptr<uchar>(y);
+    int pixel = (region.y + y) * frameSize.width + region.x;
+    for (int x = 0; x < region.width; x++, pixel++) {
+      for (int c = 0; c < num_of_channels; c++) {
+        data[c] = pixels[x * num_of_channels + c];
+      }
+      mask[x] = ClassifyPixel(parameters, data, modes_used[x],
+                              all_modes + nmixtures * pixel,
+                              all_means + nmixtures * num_of_channels * pixel);
+    }
+  }
+}
+BackgroundModel::BackgroundModel(const Image &background):
+  BackgroundModel(std::vector<Image>(1, background)) {}
+
+BackgroundModel::BackgroundModel(const std::vector<Image> &backgrounds):
+  coarse_(std::make_shared<CoarseModel>()) {
+  assert(backgrounds.size() > 0);
+  for (const auto &background : backgrounds) {
+    assert(background.matrix().size() == backgrounds[0].matrix().size());
+    assert(background.matrix().type() == backgrounds[0].matrix().type());
+    // the pixels are shared, not copied:
+    coarse_->backgrounds.push_back(background.matrix());
+  }
+  trained_ = Train(coarse_->backgrounds);
+}
+
+std::shared_ptr<const BackgroundModel::Subtractor> BackgroundModel::Train(
+    const std::vector<cv::Mat> &backgrounds) {
+  std::shared_ptr<Subtractor> subtractor(new Subtractor());
+  cv::Mat mask;
+  for (const auto &background : backgrounds) {
+    subtractor->operator()(background, mask);
+  }
+  return subtractor;
+}
+void BackgroundModel::ComputeRawForegroundMask(const cv::Mat &image,
+                                               cv::Mat *raw_mask) const {
+  assert(raw_mask != nullptr);
+  assert(image.size() == frame_size());
+  trained_->Classify(image, cv::Rect(cv::Point(0, 0), frame_size()),
+                     raw_mask);
+}
+
+void BackgroundModel::ComputeRawForegroundMask(const cv::Mat &image,
+                                               const cv::Rect &region,
+                                               cv::Mat *raw_mask) const {
+  assert(raw_mask != nullptr);
+  assert(image.size() == region.size());
+  trained_->Classify(image, region, raw_mask);
+}
+
+void BackgroundModel::ComputeCoarseRawForegroundMask(
+    const cv::Mat &coarse_image,
+    cv::Mat *raw_mask) const {
+  assert(raw_mask != nullptr);
+  assert(coarse_image.size() == coarse_frame_size());
+  const Subtractor &coarse_subtractor = coarse();
+  coarse_subtractor.Classify(
+      coarse_image, cv::Rect(cv::Point(0, 0), coarse_subtractor.frame_size()),
+      raw_mask);
+}
+
+cv::Size BackgroundModel::coarse_frame_size() const {
+  return coarse().frame_size();
+}
+// The backgrounds are downscaled only now; the ones at full resolution are
+// not needed anymore.
+const BackgroundModel::Subtractor& BackgroundModel::coarse() const {
+  std::call_once(coarse_->trained, [this]() {
+    for (auto &background : coarse_->backgrounds) {
+      cv::Mat coarse_background;
+      DownscaleFrame(background, &coarse_background);
+      background = coarse_background;
+    }
+    coarse_->subtractor = Train(coarse_->backgrounds);
+    coarse_->backgrounds.clear();
+  });
+  return *coarse_->subtractor;
+}
+}  // namespace object_clustering
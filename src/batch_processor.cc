@@ -0,0 +1,184 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// batch_processor.cc
+// Object Clustering
+
+#include <dirent.h>
+
+#include <cassert>
+#include <cctype>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#include "batch_processor.h"
+#include "thread_pool.h"
+
+namespace object_clustering {
+namespace {
+const char kBackgroundSuffix[] = "-1";
+const char kImageSuffix[] = "-2";
+
+bool IsNumber(const std::string &text) {
+  return !text.empty() &&
+         std::all_of(text.begin(), text.end(), [](char c) {
+           return isdigit(static_cast<unsigned char>(c)) != 0;
+         });
+}
+// Numbers are compared by value, so that "2" comes before "10":
+bool PrefixLess(const std::string &a, const std::string &b) {
+  if (IsNumber(a) && IsNumber(b) && (a.size() != b.size())) {
+    return a.size() < b.size();
+  }
+  return a < b;
+}
+// The fields of a record are separated by tabs and the records by new lines,
+// so the messages (OpenCV ones end with a new line) should have neither:
+std::string OneLine(std::string text) {
+  std::replace(text.begin(), text.end(), '\t', ' ');
+  std::replace(text.begin(), text.end(), '\n', ' ');
+  while (!text.empty() && (text[text.size() - 1] == ' ')) {
+    text.erase(text.size() - 1);
+  }
+  return text;
+}
+}  // namespace
+
+bool ReadBatchManifest(const std::string &filename,
+                       std::vector<BatchItem> *items) {
+  assert(items != nullptr);
+  std::ifstream file(filename.c_str());
+  if (!file) return false;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream stream(line);
+    BatchItem item;
+    if (!(stream >> item.background_path) ||
+        (item.background_path[0] == '#')) {
+      continue;
+    }
+    // a line with a single path is kept, and fails when processed:
+    stream >> item.image_path;
+    items->push_back(item);
+  }
+  return true;
+}
+// 1. Collect the file names of the directory;
+// 2. For every "prefix-1.ext" look for "prefix-2.ext".
+bool FindBatchPairsInDirectory(const std::string &directory,
+                               std::vector<BatchItem> *items) {
+  assert(items != nullptr);
+  // 1:
+  DIR *dir = opendir(directory.c_str());
+  if (dir == NULL) return false;
+  std::set<std::string> names;
+  while (struct dirent *entry = readdir(dir)) {
+    names.insert(entry->d_name);
+  }
+  closedir(dir);
+  // 2:
+  std::vector<std::pair<std::string, BatchItem>> pairs;
+  for (const auto &name : names) {
+    size_t dot = name.rfind('.');
+    if ((dot == std::string::npos) || (dot < 2)) continue;
+    std::string stem = name.substr(0, dot);
+    std::string extension = name.substr(dot);
+    std::string prefix = stem.substr(0, stem.size() - 2);
+    if (stem.compare(stem.size() - 2, 2, kBackgroundSuffix) != 0) continue;
+    std::string image_name = prefix + kImageSuffix + extension;
+    if (names.count(image_name) == 0) continue;
+    BatchItem item;
+    item.background_path = directory + "/" + name;
+    item.image_path = directory + "/" + image_name;
+    pairs.push_back(std::make_pair(prefix, item));
+  }
+  std::sort(pairs.begin(), pairs.end(),
+            [](const std::pair<std::string, BatchItem> &a,
+               const std::pair<std::string, BatchItem> &b) {
+              return PrefixLess(a.first, b.first);
+            });
+  for (const auto &pair : pairs) {
+    items->push_back(pair.second);
+  }
+  return true;
+}
+
+void WriteBatchResult(const BatchResult &result, FILE *file) {
+  assert(file != nullptr);
+  fprintf(file, "%d\t%s\t%s\t%s\t%d\t%d\t%.1f\t",
+          result.index,
+          result.item.background_path.c_str(),
+          result.item.image_path.c_str(),
+          result.succeeded ? "ok" : OneLine(result.error).c_str(),
+          static_cast<int>(result.rects.size()),
+          result.num_of_groups,
+          result.milliseconds);
+  for (size_t i = 0; i < result.rects.size(); i++) {
+    const cv::Rect &rect = result.rects[i];
+    fprintf(file, "%s%d,%d,%d,%d:%d", i > 0 ? " " : "",
+            rect.x, rect.y, rect.width, rect.height, result.groups[i]);
+  }
+  fprintf(file, "\n");
+}
+
+BatchProcessor::BatchProcessor(const ObjectDetector &detector,
+                               const AbstractClusterAlgorithm &clusterer,
+                               const int &num_of_threads):
+  detector_(detector),
+  clusterer_(clusterer),
+  num_of_threads_(num_of_threads) {}
+// The pool is created once for the whole batch:
+std::vector<BatchResult> BatchProcessor::Process(
+    const std::vector<BatchItem> &items) const {
+  std::vector<BatchResult> results(items.size());
+  ThreadPool pool(num_of_threads_);
+  pool.ParallelFor(0, static_cast<int>(items.size()), [&](int i) {
+    results[i] = ProcessItem(i, items[i]);
+  });
+  return results;
+}
+
+BatchResult BatchProcessor::ProcessItem(const int &index,
+                                        const BatchItem &item) const {
+  auto start = std::chrono::steady_clock::now();
+  BatchResult result;
+  result.index = index;
+  result.item = item;
+  try {
+    // the image is decoded in the background while the background is taken
+    // from the cache (or decoded):
+    ImageSource image_source(item.image_path);
+    ImageSource background_source(item.background_path, background_cache_);
+    image_source.Prefetch();
+    const Image &background = background_source.image();
+    const Image &image = image_source.image();
+    if (image.matrix().size() != background.matrix().size()) {
+      throw std::runtime_error("the image and the background differ in size");
+    }
+    auto objects = detector_.DetectObjectsFromImage(image, background);
+    result.num_of_groups = clusterer_.AssignGroupsToObjects(&objects);
+    for (const auto &object : objects) {
+      result.rects.push_back(object.image().bounding_rect());
+      result.groups.push_back(object.group());
+    }
+    result.succeeded = true;
+    if (result_writer_ != nullptr) {
+      char name[16];
+      snprintf(name, sizeof(name), "%06d", index);
+      result_writer_->Write(name, image.matrix(), objects,
+                            result.num_of_groups);
+    }
+  } catch (const std::exception &error) {
+    result.error = error.what();
+    result.rects.clear();
+    result.groups.clear();
+    result.num_of_groups = 0;
+  }
+  result.milliseconds = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+}  // namespace object_clustering
@@ -0,0 +1,123 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// cluster_metrics.cc
+// Object Clustering
+
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+#include <algorithm>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "cluster_metrics.h"
+
+namespace object_clustering {
+namespace {
+// The mean silhouette of the sampled rows, against the sample itself:
+double SampledSilhouette(const FeatureMatrix &data,
+                         const std::vector<int> &labels,
+                         const int &num_of_clusters,
+                         const std::vector<int> &sample) {
+  int sample_size = static_cast<int>(sample.size());
+  std::vector<double> distance_sum(num_of_clusters);
+  std::vector<int> count(num_of_clusters);
+  double silhouette = 0;
+  for (int i = 0; i < sample_size; i++) {
+    std::fill(distance_sum.begin(), distance_sum.end(), 0);
+    std::fill(count.begin(), count.end(), 0);
+    const float *row = data.row(sample[i]);
+    for (int j = 0; j < sample_size; j++) {
+      if (j == i) continue;
+      int label = labels[sample[j]];
+      distance_sum[label] += std::sqrt(SquaredDistance(
+          row, data.row(sample[j]), data.stride()));
+      count[label]++;
+    }
+    int own = labels[sample[i]];
+    // a row alone in its cluster counts as 0:
+    if (count[own] == 0) continue;
+    double a = distance_sum[own] / count[own];
+    double b = DBL_MAX;
+    for (int k = 0; k < num_of_clusters; k++) {
+      if ((k != own) && (count[k] > 0)) {
+        b = std::min(b, distance_sum[k] / count[k]);
+      }
+    }
+    if (b == DBL_MAX) continue;
+    double larger = std::max(a, b);
+    if (larger > 0) silhouette += (b - a) / larger;
+  }
+  return sample_size > 0 ? silhouette / sample_size : 0;
+}
+}  // namespace
+
+void ComputeClusterMetrics(const FeatureMatrix &data,
+                           const std::vector<int> &labels,
+                           const FeatureMatrix &centers,
+                           const int &silhouette_sample_size,
+                           ClusterMetrics *metrics) {
+  assert(metrics != nullptr);
+  assert(!data.empty() && !centers.empty());
+  assert(data.cols() == centers.cols());
+  assert(static_cast<int>(labels.size()) == data.rows());
+  assert(silhouette_sample_size >= 0);
+  int n = data.rows();
+  int num_of_clusters = centers.rows();
+  int stride = data.stride();
+  *metrics = ClusterMetrics();
+  // 1. The pass over the rows:
+  std::vector<double> scatter(num_of_clusters, 0);
+  std::vector<int> size(num_of_clusters, 0);
+  std::vector<int> sample;
+  sample.reserve(std::min(n, silhouette_sample_size));
+  cv::RNG rng(kSilhouetteSeed);
+  for (int i = 0; i < n; i++) {
+    int label = labels[i];
+    assert((label >= 0) && (label < num_of_clusters));
+    float squared_distance = SquaredDistance(data.row(i), centers.row(label),
+                                             stride);
+    double distance = std::sqrt(squared_distance);
+    metrics->inertia += squared_distance;
+    metrics->mean_distance += distance;
+    scatter[label] += distance;
+    size[label]++;
+    // every row ends up in the sample with the same probability:
+    if (i < silhouette_sample_size) {
+      sample.push_back(i);
+    } else if (silhouette_sample_size > 0) {
+      int slot = rng.uniform(0, i + 1);
+      if (slot < silhouette_sample_size) sample[slot] = i;
+    }
+  }
+  metrics->mean_distance /= n;
+  // 2. Davies-Bouldin, over the clusters which got rows:
+  int num_of_used_clusters = 0;
+  for (int k = 0; k < num_of_clusters; k++) {
+    if (size[k] == 0) continue;
+    scatter[k] /= size[k];
+    num_of_used_clusters++;
+  }
+  if (num_of_used_clusters > 1) {
+    for (int i = 0; i < num_of_clusters; i++) {
+      if (size[i] == 0) continue;
+      double worst = 0;
+      for (int j = 0; j < num_of_clusters; j++) {
+        if ((j == i) || (size[j] == 0)) continue;
+        double separation = std::sqrt(SquaredDistance(centers.row(i),
+                                                      centers.row(j),
+                                                      stride));
+        double ratio = separation > 0 ? (scatter[i] + scatter[j]) / separation :
+                                        DBL_MAX;
+        worst = std::max(worst, ratio);
+      }
+      metrics->davies_bouldin += worst;
+    }
+    metrics->davies_bouldin /= num_of_used_clusters;
+    // 3. The silhouette:
+    metrics->silhouette = SampledSilhouette(data, labels, num_of_clusters,
+                                            sample);
+  }
+}
+}  // namespace object_clustering
@@ -0,0 +1,221 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// cluster_model.cc
+// Object Clustering
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "cluster_model.h"
+
+namespace object_clustering {
+namespace {
+// floats per row of a FeatureMatrix of kNumberOfFeatures columns:
+const int kFeatureStride = (kNumberOfFeatures + kFeaturesPerVector - 1) /
+                           kFeaturesPerVector * kFeaturesPerVector;
+// A 1 x kNumberOfFeatures CV_32FC1 copy of values:
+cv::Mat FeatureVectorToMat(const FeatureVector &values) {
+  cv::Mat matrix(1, kNumberOfFeatures, CV_32FC1);
+  std::copy(values.begin(), values.end(), matrix.ptr<float>(0));
+  return matrix;
+}
+// Copies a 1 x kNumberOfFeatures CV_32FC1 matrix into values. Returns false
+// if the matrix is of another size or type.
+bool MatToFeatureVector(const cv::Mat &matrix, FeatureVector *values) {
+  assert(values != nullptr);
+  if ((matrix.type() != CV_32FC1) || (matrix.rows != 1) ||
+      (matrix.cols != kNumberOfFeatures)) {
+    return false;
+  }
+  const float *row = matrix.ptr<float>(0);
+  std::copy(row, row + kNumberOfFeatures, values->begin());
+  return true;
+}
+}  // namespace
+
+void NormalizeFeatureRow(const FeatureVector &max_feature_value,
+                         const FeatureVector &avg_feature_value,
+                         float *features) {
+  assert(features != nullptr);
+  for (int j = 0; j < kNumberOfFeatures; j++) {
+    if (max_feature_value[j] == 0) {
+      features[j] = 0.99;
+    } else {
+      features[j] = (features[j] - avg_feature_value[j]) /
+                    max_feature_value[j];
+    }
+  }
+}
+
+ClusterModel::ClusterModel(const FeatureVector &max_feature_value,
+                           const FeatureVector &avg_feature_value,
+                           const FeatureMatrix &centers,
+                           const float &training_error):
+  max_feature_value_(max_feature_value),
+  avg_feature_value_(avg_feature_value),
+  centers_(centers),
+  training_error_(training_error) {
+  assert(centers.empty() || (centers.cols() == kNumberOfFeatures));
+  assert(training_error >= 0);
+}
+// The row is normalized in an aligned buffer on the stack, so that nothing is
+// allocated per object.
+int ClusterModel::Assign(const FeatureVector &features,
+                         float *distance) const {
+  assert(!empty());
+  alignas(kFeatureAlignment) float row[kFeatureStride] = {0};
+  std::copy(features.begin(), features.end(), row);
+  Normalize(row);
+  float squared_distance;
+  int cluster = NearestRow(row, centers_, &squared_distance);
+  if (distance != nullptr) *distance = std::sqrt(squared_distance);
+  return cluster;
+}
+
+int ClusterModel::AssignGroupsToObjects(std::vector<Object> *objects,
+                                        std::vector<float> *distances) const {
+  assert(!empty());
+  assert(objects != nullptr);
+  int num_of_objects = static_cast<int>(objects->size());
+  if (distances != nullptr) distances->resize(num_of_objects);
+  if (num_of_objects == 0) return 0;
+  FeatureMatrix features(num_of_objects, kNumberOfFeatures);
+  ExtractFeatures(*objects, &features);
+  for (int i = 0; i < num_of_objects; i++) {
+    float *row = features.row(i);
+    Normalize(row);
+    float squared_distance;
+    (*objects)[i].set_group(NearestRow(row, centers_, &squared_distance));
+    if (distances != nullptr) (*distances)[i] = std::sqrt(squared_distance);
+  }
+  return num_of_clusters();
+}
+// 1. Bring the centers of previous into the normalization of this model;
+// 2. pair the clusters, nearest first, until one of the models runs out;
+// 3. with more clusters than previous, the unpaired ones get the numbers
+// after the ones of previous; with fewer, the ones paired with a number out
+// of [0; K) get the numbers in [0; K) left unpaired.
+void ClusterModel::AlignTo(const ClusterModel &previous) {
+  if (empty() || previous.empty()) return;
+  int K = num_of_clusters();
+  int previous_K = previous.num_of_clusters();
+  // 1. Features whose max was 0 were all 0:
+  FeatureMatrix previous_centers(previous_K, kNumberOfFeatures);
+  for (int k = 0; k < previous_K; k++) {
+    const float *center = previous.centers_.row(k);
+    float *raw = previous_centers.row(k);
+    for (int j = 0; j < kNumberOfFeatures; j++) {
+      raw[j] = previous.max_feature_value_[j] == 0 ? 0 :
+               center[j] * previous.max_feature_value_[j] +
+               previous.avg_feature_value_[j];
+    }
+    Normalize(raw);
+  }
+  // 2:
+  std::vector<int> numbers(K, -1);
+  std::vector<bool> previous_taken(previous_K, false);
+  for (int pair = 0; pair < std::min(K, previous_K); pair++) {
+    float best_distance = -1;
+    int best_k = 0;
+    int best_previous = 0;
+    for (int k = 0; k < K; k++) {
+      if (numbers[k] >= 0) continue;
+      for (int p = 0; p < previous_K; p++) {
+        if (previous_taken[p]) continue;
+        float distance = SquaredDistance(centers_.row(k),
+                                         previous_centers.row(p),
+                                         centers_.stride());
+        if ((best_distance < 0) || (distance < best_distance)) {
+          best_distance = distance;
+          best_k = k;
+          best_previous = p;
+        }
+      }
+    }
+    numbers[best_k] = best_previous;
+    previous_taken[best_previous] = true;
+  }
+  // 3:
+  int next_number = previous_K;
+  for (int k = 0; k < K; k++) {
+    if (numbers[k] < 0) {
+      numbers[k] = next_number++;
+    }
+  }
+  std::vector<int> unused;
+  for (int p = 0; p < std::min(K, previous_K); p++) {
+    if (!previous_taken[p]) unused.push_back(p);
+  }
+  for (int k = 0, u = 0; k < K; k++) {
+    if (numbers[k] >= K) numbers[k] = unused[u++];
+  }
+  FeatureMatrix centers(K, kNumberOfFeatures);
+  for (int k = 0; k < K; k++) {
+    std::copy(centers_.row(k), centers_.row(k) + centers_.stride(),
+              centers.row(numbers[k]));
+  }
+  centers_ = std::move(centers);
+}
+
+bool ClusterModel::Save(const std::string &filename) const {
+  try {
+    cv::FileStorage file(filename, cv::FileStorage::WRITE);
+    if (!file.isOpened()) return false;
+    file << "version" << kClusterModelVersion;
+    file << "num_of_features" << kNumberOfFeatures;
+    file << "num_of_clusters" << num_of_clusters();
+    file << "training_error" << training_error_;
+    file << "max_feature_value" << FeatureVectorToMat(max_feature_value_);
+    file << "avg_feature_value" << FeatureVectorToMat(avg_feature_value_);
+    if (!empty()) file << "centers" << centers_.matrix();
+    file.release();
+  } catch (const cv::Exception &error) {
+    return false;
+  }
+  return true;
+}
+// Everything is read and checked before the model is changed. A file which
+// cannot be parsed makes cv::FileStorage throw.
+bool ClusterModel::Load(const std::string &filename) {
+  int K;
+  float training_error;
+  cv::Mat max_matrix, avg_matrix, center_matrix;
+  try {
+    cv::FileStorage file(filename, cv::FileStorage::READ);
+    if (!file.isOpened() ||
+        (static_cast<int>(file["version"]) != kClusterModelVersion) ||
+        (static_cast<int>(file["num_of_features"]) != kNumberOfFeatures)) {
+      return false;
+    }
+    K = static_cast<int>(file["num_of_clusters"]);
+    training_error = static_cast<float>(file["training_error"]);
+    file["max_feature_value"] >> max_matrix;
+    file["avg_feature_value"] >> avg_matrix;
+    if (K > 0) file["centers"] >> center_matrix;
+  } catch (const cv::Exception &error) {
+    return false;
+  }
+  FeatureVector max_feature_value, avg_feature_value;
+  if ((K < 0) || !(training_error >= 0) ||
+      !MatToFeatureVector(max_matrix, &max_feature_value) ||
+      !MatToFeatureVector(avg_matrix, &avg_feature_value) ||
+      ((K > 0) && ((center_matrix.type() != CV_32FC1) ||
+                   (center_matrix.rows != K) ||
+                   (center_matrix.cols != kNumberOfFeatures)))) {
+    return false;
+  }
+  FeatureMatrix centers(K, kNumberOfFeatures);
+  for (int k = 0; k < K; k++) {
+    const float *center = center_matrix.ptr<float>(k);
+    std::copy(center, center + kNumberOfFeatures, centers.row(k));
+  }
+  *this = ClusterModel(max_feature_value, avg_feature_value, centers,
+                       training_error);
+  return true;
+}
+}  // namespace object_clustering
@@ -4,35 +4,569 @@
 // A clustering application. Given two images: one of the background and the
 // other of the objects, the program detects and circles the objects, each
 // group with a different color.
-// Usage: cluster background_image object_image
+// In streaming mode, the objects are detected and clustered on every frame of
+// one or more video files or image sequences, and the latency and the frame
+// rate are reported.
+// In batch mode, many background/image pairs are processed in parallel and a
+// result record is written for every pair.
+// With --pack, the frames of a video or an image sequence are written into a
+// frame container, which the streaming mode reads without decoding.
+// With --feature-store, the streaming mode appends the features of every
+// object into a feature store, and --cluster-store clusters all of them
+// without loading the store into memory.
+// With --model, the streaming mode labels the objects by a saved clustering
+// model, trains it again only when the objects drift away from it, and saves
+// it at the end.
+// With --track, the streaming mode carries the groups of the objects which did
+// not change over to the next frame, and groups only the new ones.
+// With --output-dir, the results are written into a directory instead of being
+// shown, so the program can run without a display.
+// Usage: cluster background_image object_image [options]
+//        cluster --stream background_image source [source ...] [options]
+//        cluster --batch manifest_or_directory [options]
+//        cluster --pack source container.frames
+//        cluster --cluster-store store.features [options]
 
+#include <sys/stat.h>
+
+#include <cassert>
+#include <cinttypes>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "background_model.h"
+#include "batch_processor.h"
+#include "feature_store.h"
+#include "frame_container.h"
+#include "frame_stream.h"
 #include "gui_functions.h"
+#include "image_source.h"
+#include "incremental_cluster_algorithm.h"
 #include "object_detector.h"
 #include "k_means_clustering_algorithm.h"
+#include "mini_batch_k_means_clustering_algorithm.h"
+#include "native_k_means_clustering_algorithm.h"
+#include "result_writer.h"
 
 namespace oc = object_clustering;
 
-int main(int argc, char **argv) {
-  if (argc != 3) {
-    printf("Usage: cluster background_image object_image \n");
+namespace {
+// The command line, apart from the mode:
+struct Options {
+  std::vector<std::string> arguments;  // the ones which are not options
+  int num_of_threads = 0;  // one per hardware thread
+  std::string output_name;  // the batch records, stdout if empty
+  std::string output_directory;  // headless output, if not empty
+  oc::RecordFormat record_format = oc::kJsonRecords;
+  bool write_images = true;
+  std::string kmeans = "opencv";  // opencv, native or minibatch
+  int kmeans_batch_size = oc::kMiniBatchSize;
+  bool parallel_k_search = false;
+  int kmeans_num_of_threads = 0;  // one per hardware thread
+  bool tiled_detection = false;
+  int detection_num_of_threads = 0;  // one per hardware thread
+  bool pyramid_detection = false;
+  size_t background_cache_bytes = oc::kDecodedImageCacheBytes;
+  std::string feature_store_name;  // appended by the streaming mode, if set
+  std::string model_name;  // the clustering model of the streaming mode
+  float drift_threshold = oc::kModelDriftThreshold;
+  bool tracking = false;
+};
+
+void PrintUsage() {
+  printf("Usage: cluster background_image object_image [options] \n");
+  printf("       cluster --stream background_image source [source ...] "
+         "[options] \n");
+  printf("       cluster --batch manifest_or_directory [options] \n");
+  printf("       cluster --pack source container.frames \n");
+  printf("       cluster --cluster-store store.features [options] \n");
+  printf("source is a video file, an image sequence like frames/%%04d.png \n");
+  printf("or a frame container written by --pack \n");
+  printf("a manifest lists a background and an image per line; a directory \n");
+  printf("is searched for pairs named N-1.png (background) and N-2.png \n");
+  printf("Options: \n");
+  printf("  --output-dir dir            write the results into dir instead \n");
+  printf("                              of showing them \n");
+  printf("  --records json|binary|none  format of the records in dir \n");
+  printf("  --no-images                 do not write the annotated images \n");
+  printf("  --threads N                 threads of the batch mode \n");
+  printf("  --output file               records of the batch mode \n");
+  printf("  --kmeans opencv|native|minibatch \n");
+  printf("                              K-Means implementation; minibatch \n");
+  printf("                              is meant for large inputs \n");
+  printf("  --kmeans-batch N            rows per mini-batch \n");
+  printf("  --kmeans-threads N          try several numbers of groups at \n");
+  printf("                              once on N threads (0: all cores) \n");
+  printf("  --detect-threads N          detect the objects of large frames \n");
+  printf("                              tile by tile on N threads \n");
+  printf("  --pyramid                   search a downscaled frame first, \n");
+  printf("                              then only around its objects \n");
+  printf("  --background-cache MB       decoded backgrounds kept by the \n");
+  printf("                              batch mode (default 256) \n");
+  printf("  --feature-store file        append the features of the objects \n");
+  printf("                              of the streams to file \n");
+  printf("  --model file                label the objects of the streams by \n");
+  printf("                              the model in file, train it when \n");
+  printf("                              missing or drifted, and save it \n");
+  printf("  --drift-threshold X         drift which trains the model again \n");
+  printf("                              (default 2) \n");
+  printf("  --track                     group only the objects which are \n");
+  printf("                              not on the previous frame \n");
+}
+// Returns false on an unknown or incomplete option.
+// options should not be NULL.
+bool ParseOptions(int argc, char **argv, int first, Options *options) {
+  for (int i = first; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+    if (strncmp(argv[i], "--", 2) != 0) {
+      options->arguments.push_back(argv[i]);
+    } else if ((strcmp(argv[i], "--threads") == 0) && has_value) {
+      options->num_of_threads = atoi(argv[++i]);
+    } else if ((strcmp(argv[i], "--output") == 0) && has_value) {
+      options->output_name = argv[++i];
+    } else if ((strcmp(argv[i], "--output-dir") == 0) && has_value) {
+      options->output_directory = argv[++i];
+    } else if ((strcmp(argv[i], "--records") == 0) && has_value) {
+      std::string format = argv[++i];
+      if (format == "json") {
+        options->record_format = oc::kJsonRecords;
+      } else if (format == "binary") {
+        options->record_format = oc::kBinaryRecords;
+      } else if (format == "none") {
+        options->record_format = oc::kNoRecords;
+      } else {
+        return false;
+      }
+    } else if ((strcmp(argv[i], "--kmeans") == 0) && has_value) {
+      options->kmeans = argv[++i];
+      if ((options->kmeans != "opencv") && (options->kmeans != "native") &&
+          (options->kmeans != "minibatch")) {
+        return false;
+      }
+    } else if ((strcmp(argv[i], "--kmeans-batch") == 0) && has_value) {
+      options->kmeans_batch_size = atoi(argv[++i]);
+      if (options->kmeans_batch_size <= 0) return false;
+    } else if ((strcmp(argv[i], "--kmeans-threads") == 0) && has_value) {
+      options->parallel_k_search = true;
+      options->kmeans_num_of_threads = atoi(argv[++i]);
+    } else if ((strcmp(argv[i], "--detect-threads") == 0) && has_value) {
+      options->tiled_detection = true;
+      options->detection_num_of_threads = atoi(argv[++i]);
+    } else if ((strcmp(argv[i], "--background-cache") == 0) && has_value) {
+      int megabytes = atoi(argv[++i]);
+      if (megabytes < 0) return false;
+      options->background_cache_bytes = static_cast<size_t>(megabytes) << 20;
+    } else if ((strcmp(argv[i], "--feature-store") == 0) && has_value) {
+      options->feature_store_name = argv[++i];
+    } else if ((strcmp(argv[i], "--model") == 0) && has_value) {
+      options->model_name = argv[++i];
+    } else if ((strcmp(argv[i], "--drift-threshold") == 0) && has_value) {
+      options->drift_threshold = static_cast<float>(atof(argv[++i]));
+      if (!(options->drift_threshold > 0)) return false;
+    } else if (strcmp(argv[i], "--pyramid") == 0) {
+      options->pyramid_detection = true;
+    } else if (strcmp(argv[i], "--track") == 0) {
+      options->tracking = true;
+    } else if (strcmp(argv[i], "--no-images") == 0) {
+      options->write_images = false;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+// Returns the clustering algorithm chosen by --kmeans:
+std::unique_ptr<oc::KMeansClusteringAlgorithm> CreateClusterer(
+    const Options &options) {
+  std::unique_ptr<oc::KMeansClusteringAlgorithm> clusterer;
+  if (options.kmeans == "native") {
+    clusterer.reset(new oc::NativeKMeansClusteringAlgorithm());
+  } else if (options.kmeans == "minibatch") {
+    auto mini_batch = new oc::MiniBatchKMeansClusteringAlgorithm();
+    mini_batch->set_batch_size(options.kmeans_batch_size);
+    clusterer.reset(mini_batch);
+  } else {
+    clusterer.reset(new oc::KMeansClusteringAlgorithm());
+  }
+  if (options.parallel_k_search) {
+    clusterer->set_k_search_mode(oc::kParallelKSearch);
+    clusterer->set_num_of_threads(options.kmeans_num_of_threads);
+  }
+  return clusterer;
+}
+// Applies --detect-threads and --pyramid to the detector:
+// object_detector should not be NULL.
+void ConfigureDetector(const Options &options,
+                       oc::ObjectDetector *object_detector) {
+  assert(object_detector != nullptr);
+  if (options.tiled_detection) {
+    object_detector->set_num_of_threads(options.detection_num_of_threads);
+  }
+  if (options.pyramid_detection) {
+    object_detector->set_detection_resolution(oc::kPyramidDetection);
+  }
+}
+// Returns the writer of the headless output, or NULL if the results should be
+// shown instead:
+std::unique_ptr<oc::ResultWriter> CreateResultWriter(const Options &options) {
+  std::unique_ptr<oc::ResultWriter> writer;
+  if (options.output_directory.empty()) return writer;
+  writer.reset(new oc::ResultWriter(options.output_directory,
+                                    options.write_images,
+                                    options.record_format));
+  if (!writer->IsOpened()) {
+    fprintf(stderr, "Could not write into %s \n",
+            options.output_directory.c_str());
+    // its thread is joined before exiting, which does not unwind the stack:
+    writer.reset();
     std::exit(1);
   }
-  auto image_name = argv[2];
-  auto background_name = argv[1];
-  // 0.1 Extract images:
-  oc::Image objects_image(image_name);
-  oc::Image background(background_name);
+  return writer;
+}
+// The stream name with the characters which cannot be in a file name replaced:
+std::string FileNameOf(std::string name) {
+  std::replace(name.begin(), name.end(), '/', '_');
+  std::replace(name.begin(), name.end(), '%', '_');
+  return name;
+}
+// Opens a frame container, or anything VideoCapture opens, by its name.
+// Returns NULL if the source cannot be opened.
+std::unique_ptr<oc::AbstractFrameSource> OpenFrameSource(
+    const std::string &name) {
+  std::unique_ptr<oc::AbstractFrameSource> source;
+  if (oc::IsFrameContainerName(name)) {
+    auto container = new oc::ContainerFrameSource(name);
+    source.reset(container);
+    if (!container->IsOpened()) source.reset();
+  } else {
+    auto video = new oc::VideoFrameSource(name);
+    source.reset(video);
+    if (!video->IsOpened()) source.reset();
+  }
+  return source;
+}
+// Detects, clusters and shows (or writes) the objects of one image:
+int ProcessImage(const Options &options) {
+  // 0.1 Extract images, both at the same time:
+  oc::ImageSource objects_source(options.arguments[1]);
+  oc::ImageSource background_source(options.arguments[0]);
+  background_source.Prefetch();
+  const oc::Image &objects_image = objects_source.image();
+  const oc::Image &background = background_source.image();
   // 1. Detect objects;
   oc::ObjectDetector object_detector;
+  ConfigureDetector(options, &object_detector);
   auto objects = object_detector.DetectObjectsFromImage(objects_image,
                                                         background);
   // 2. Cluster them;
-  oc::KMeansClusteringAlgorithm object_clusterer;
-  auto num_of_groups = object_clusterer.AssignGroupsToObjects(&objects);
-  // 3. Show the result.
+  auto object_clusterer = CreateClusterer(options);
+  auto num_of_groups = object_clusterer->AssignGroupsToObjects(&objects);
+  // 3. Show or write the result.
+  auto writer = CreateResultWriter(options);
+  if (writer) {
+    writer->Write("result", objects_image.matrix(), objects, num_of_groups);
+    writer->Close();
+    return writer->num_of_errors() > 0 ? 1 : 0;
+  }
+  if (objects.empty()) {
+    printf("No objects detected. \n");
+    return 0;
+  }
   oc::ShowResult(objects_image, objects, num_of_groups);
   return 0;
 }
+// Processes every stream in its own thread; all of them share the background
+// model, the detector, the clustering algorithm and the result writer:
+int ProcessStreams(const Options &options) {
+  oc::Image background_image(options.arguments[0]);
+  oc::BackgroundModel background(background_image);
+  oc::ObjectDetector object_detector;
+  ConfigureDetector(options, &object_detector);
+  auto object_clusterer = CreateClusterer(options);
+  oc::IncrementalClusterAlgorithm incremental_clusterer(*object_clusterer);
+  incremental_clusterer.set_drift_threshold(options.drift_threshold);
+  bool use_model = !options.model_name.empty();
+  if (use_model) {
+    oc::ClusterModel model;
+    if (model.Load(options.model_name)) {
+      incremental_clusterer.set_model(model);
+    } else {
+      fprintf(stderr, "No model in %s, training one \n",
+              options.model_name.c_str());
+    }
+  }
+  const oc::AbstractClusterAlgorithm &clusterer = use_model ?
+      static_cast<const oc::AbstractClusterAlgorithm&>(incremental_clusterer) :
+      *object_clusterer;
+  std::vector<std::string> source_names(options.arguments.begin() + 1,
+                                        options.arguments.end());
+  int num_of_streams = static_cast<int>(source_names.size());
+  int num_of_workers = std::max(
+      1, static_cast<int>(std::thread::hardware_concurrency()) /
+         num_of_streams);
+  oc::StreamProcessor processor(object_detector,
+                                background,
+                                clusterer,
+                                oc::kStreamQueueCapacity,
+                                num_of_workers);
+  processor.set_tracking(options.tracking);
+  auto writer = CreateResultWriter(options);
+  std::unique_ptr<oc::FeatureStoreWriter> feature_store;
+  if (!options.feature_store_name.empty()) {
+    feature_store.reset(
+        new oc::FeatureStoreWriter(options.feature_store_name));
+    if (!feature_store->IsOpened()) {
+      fprintf(stderr, "Could not append to %s \n",
+              options.feature_store_name.c_str());
+      return 1;
+    }
+  }
+  std::mutex output_mutex;
+  int result = 0;
+  // Processes one stream, in a thread of its own:
+  auto process_stream = [&](const std::string &source_name,
+                            const int &stream_index) {
+    auto source = OpenFrameSource(source_name);
+    if (!source) {
+      std::lock_guard<std::mutex> lock(output_mutex);
+      fprintf(stderr, "Could not open the stream %s \n",
+              source_name.c_str());
+      result = 1;
+      return;
+    }
+    auto statistics = processor.Process(
+        source.get(), [&](const oc::FrameResult &frame_result) {
+      if (writer) {
+        char frame_suffix[16];
+        snprintf(frame_suffix, sizeof(frame_suffix), "_%06d",
+                 frame_result.frame_index);
+        writer->Write(FileNameOf(source_name) + frame_suffix,
+                      frame_result.frame,
+                      frame_result.objects,
+                      frame_result.num_of_groups);
+      }
+      if (feature_store) {
+        // the stream in the high half, the frame in the low one:
+        int64_t frame_id = (static_cast<int64_t>(stream_index) << 32) |
+                           static_cast<uint32_t>(frame_result.frame_index);
+        feature_store->Append(frame_id, frame_result.objects);
+      }
+      std::lock_guard<std::mutex> lock(output_mutex);
+      printf("%s frame %d: %d objects, %d groups, %.1f ms \n",
+             source_name.c_str(),
+             frame_result.frame_index,
+             static_cast<int>(frame_result.objects.size()),
+             frame_result.num_of_groups,
+             frame_result.latency_ms);
+    });
+    std::lock_guard<std::mutex> lock(output_mutex);
+    printf("%s: %d frames (%d skipped) in %.2f s, %.2f fps, "
+           "latency mean %.1f ms, max %.1f ms \n",
+           source_name.c_str(),
+           statistics.num_of_frames,
+           statistics.num_of_skipped_frames,
+           statistics.seconds,
+           statistics.frames_per_second,
+           statistics.mean_latency_ms,
+           statistics.max_latency_ms);
+    if (options.tracking) {
+      printf("%s: %" PRId64 " of %" PRId64 " objects tracked, %" PRId64
+             " clustered \n",
+             source_name.c_str(),
+             statistics.num_of_tracked_objects,
+             statistics.num_of_objects,
+             statistics.num_of_objects - statistics.num_of_tracked_objects);
+    }
+  };
+  std::vector<std::thread> streams;
+  for (int stream_index = 0; stream_index < num_of_streams; stream_index++) {
+    const std::string &source_name = source_names[stream_index];
+    streams.push_back(std::thread([&, source_name, stream_index]() {
+      // an error ends the stream, not the program, so the results queued by
+      // the other streams are still written:
+      try {
+        process_stream(source_name, stream_index);
+      } catch (const std::exception &error) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        fprintf(stderr, "%s: %s \n", source_name.c_str(), error.what());
+        result = 1;
+      }
+    }));
+  }
+  for (auto &stream : streams) {
+    stream.join();
+  }
+  if (writer) {
+    writer->Close();
+    if (writer->num_of_errors() > 0) result = 1;
+  }
+  if (use_model) {
+    oc::ClusterModel model = incremental_clusterer.model();
+    if (!model.empty() && !model.Save(options.model_name)) {
+      fprintf(stderr, "Could not write %s \n", options.model_name.c_str());
+      result = 1;
+    }
+    fprintf(stderr, "model: %d groups, trained %d times, drift %.2f \n",
+            model.num_of_clusters(), incremental_clusterer.num_of_trainings(),
+            incremental_clusterer.drift());
+  }
+  if (feature_store && !feature_store->Close()) {
+    fprintf(stderr, "Could not write %s \n",
+            options.feature_store_name.c_str());
+    result = 1;
+  }
+  return result;
+}
+// Writes the frames of a video or an image sequence into a frame container:
+int PackFrames(const Options &options) {
+  const std::string &source_name = options.arguments[0];
+  const std::string &container_name = options.arguments[1];
+  oc::VideoFrameSource source(source_name);
+  if (!source.IsOpened()) {
+    fprintf(stderr, "Could not open the stream %s \n", source_name.c_str());
+    return 1;
+  }
+  int num_of_frames = oc::ConvertToFrameContainer(&source, container_name);
+  if (num_of_frames < 0) {
+    fprintf(stderr, "Could not write %s \n", container_name.c_str());
+    return 1;
+  }
+  fprintf(stderr, "%d frames written into %s \n", num_of_frames,
+          container_name.c_str());
+  return 0;
+}
+// Clusters every row of a feature store with the mini-batch K-Means and
+// writes one line per row: frame id, x, y, width, height and group.
+int ClusterFeatureStore(const Options &options) {
+  const std::string &store_name = options.arguments[0];
+  oc::MappedFeatureStore store(store_name);
+  if (!store.IsOpened()) {
+    fprintf(stderr, "Could not read the feature store %s \n",
+            store_name.c_str());
+    return 1;
+  }
+  FILE *output = stdout;
+  if (!options.output_name.empty()) {
+    output = fopen(options.output_name.c_str(), "w");
+    if (output == NULL) {
+      fprintf(stderr, "Could not open %s \n", options.output_name.c_str());
+      return 1;
+    }
+  }
+  oc::MiniBatchKMeansClusteringAlgorithm clusterer;
+  clusterer.set_batch_size(options.kmeans_batch_size);
+  if (options.parallel_k_search) {
+    clusterer.set_k_search_mode(oc::kParallelKSearch);
+    clusterer.set_num_of_threads(options.kmeans_num_of_threads);
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::vector<int> groups;
+  int num_of_groups = clusterer.AssignGroupsToStore(store, &groups);
+  for (int64_t i = 0; i < store.num_of_rows(); i++) {
+    const oc::FeatureStoreRow &row = store.row(i);
+    fprintf(output, "%" PRId64 "\t%d\t%d\t%d\t%d\t%d\n", row.frame_id,
+            row.x, row.y, row.width, row.height, groups[i]);
+  }
+  if (output != stdout) fclose(output);
+  double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "%" PRId64 " objects, %d groups, %.2f s \n",
+          store.num_of_rows(), num_of_groups, seconds);
+  return 0;
+}
+// Processes the pairs of a manifest or a directory; every pair gets a record,
+// even if it fails:
+int ProcessBatch(const Options &options) {
+  const std::string &source = options.arguments[0];
+  std::vector<oc::BatchItem> items;
+  struct stat source_stat;
+  bool is_directory = (stat(source.c_str(), &source_stat) == 0) &&
+                      S_ISDIR(source_stat.st_mode);
+  bool read = is_directory ? oc::FindBatchPairsInDirectory(source, &items) :
+                             oc::ReadBatchManifest(source, &items);
+  if (!read) {
+    fprintf(stderr, "Could not read the batch %s \n", source.c_str());
+    return 1;
+  }
+  FILE *output = stdout;
+  if (!options.output_name.empty()) {
+    output = fopen(options.output_name.c_str(), "w");
+    if (output == NULL) {
+      fprintf(stderr, "Could not open %s \n", options.output_name.c_str());
+      return 1;
+    }
+  }
+  oc::ObjectDetector object_detector;
+  ConfigureDetector(options, &object_detector);
+  auto object_clusterer = CreateClusterer(options);
+  oc::BatchProcessor processor(object_detector,
+                               *object_clusterer,
+                               options.num_of_threads);
+  auto writer = CreateResultWriter(options);
+  processor.set_result_writer(writer.get());
+  oc::DecodedImageCache background_cache(options.background_cache_bytes);
+  processor.set_background_cache(&background_cache);
+  auto start = std::chrono::steady_clock::now();
+  auto results = processor.Process(items);
+  if (writer) writer->Close();
+  double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  int num_of_failures = 0;
+  for (const auto &result : results) {
+    oc::WriteBatchResult(result, output);
+    if (!result.succeeded) num_of_failures++;
+  }
+  if (output != stdout) fclose(output);
+  fprintf(stderr, "%d pairs, %d failed, %.2f s \n",
+          static_cast<int>(results.size()), num_of_failures, seconds);
+  bool failed = (num_of_failures > 0) ||
+                (writer && (writer->num_of_errors() > 0));
+  return failed ? 1 : 0;
+}
+}  // namespace
 
+int main(int argc, char **argv) {
+  try {
+    std::string mode = argc > 1 ? argv[1] : "";
+    bool is_stream = mode == "--stream";
+    bool is_batch = mode == "--batch";
+    bool is_pack = mode == "--pack";
+    bool is_cluster_store = mode == "--cluster-store";
+    bool has_mode = is_stream || is_batch || is_pack || is_cluster_store;
+    Options options;
+    bool parsed = ParseOptions(argc, argv, has_mode ? 2 : 1, &options);
+    int num_of_arguments = static_cast<int>(options.arguments.size());
+    if (parsed && is_stream && (num_of_arguments >= 2)) {
+      return ProcessStreams(options);
+    }
+    if (parsed && is_batch && (num_of_arguments == 1)) {
+      return ProcessBatch(options);
+    }
+    if (parsed && is_pack && (num_of_arguments == 2)) {
+      return PackFrames(options);
+    }
+    if (parsed && is_cluster_store && (num_of_arguments == 1)) {
+      return ClusterFeatureStore(options);
+    }
+    if (!parsed || has_mode || (num_of_arguments != 2)) {
+      PrintUsage();
+      std::exit(1);
+    }
+    return ProcessImage(options);
+  } catch (const std::exception &error) {
+    // the stack is unwound by now, so every result writer has been closed
+    // and its thread joined:
+    fprintf(stderr, "%s \n", error.what());
+    std::exit(1);
+  }
+}
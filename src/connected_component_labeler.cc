@@ -0,0 +1,240 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// connected_component_labeler.cc
+// Object Clustering
+
+#include <cassert>
+
+#include <vector>
+
+#include "connected_component_labeler.h"
+
+namespace object_clustering {
+namespace {
+// Union-find over the blobs of all the bands; the root of a set is its
+// smallest member:
+int FindRoot(std::vector<int> *parent, int blob) {
+  while ((*parent)[blob] != blob) {
+    (*parent)[blob] = (*parent)[(*parent)[blob]];  // path halving
+    blob = (*parent)[blob];
+  }
+  return blob;
+}
+
+void Unite(std::vector<int> *parent, const int &a, const int &b) {
+  int root_a = FindRoot(parent, a);
+  int root_b = FindRoot(parent, b);
+  if (root_a < root_b) {
+    (*parent)[root_b] = root_a;
+  } else if (root_b < root_a) {
+    (*parent)[root_a] = root_b;
+  }
+}
+}  // namespace
+// 1. Split every row into runs, joining them with the previous row's runs;
+// 2. Sum the runs of every set into the blob statistics.
+void ConnectedComponentLabeler::LabelBlobs(const cv::Mat &gray,
+                                           const int &threshold,
+                                           std::vector<BlobStats> *blobs) {
+  assert(gray.type() == CV_8UC1);
+  assert(blobs != nullptr);
+  LabelRows(gray, threshold, 0, gray.rows);
+  CollectBlobs(blobs);
+}
+// The blobs are collected as by LabelBlobs(..); then the runs of the first
+// and the last row are given the index of their blob.
+void ConnectedComponentLabeler::LabelBand(const cv::Mat &gray,
+                                          const int &threshold,
+                                          const int &row_begin,
+                                          const int &row_end,
+                                          BandBlobs *band) {
+  assert(gray.type() == CV_8UC1);
+  assert(band != nullptr);
+  assert((row_begin >= 0) && (row_begin <= row_end) &&
+         (row_end <= gray.rows));
+  LabelRows(gray, threshold, row_begin, row_end);
+  CollectBlobs(&band->blobs);
+  int num_of_blobs = static_cast<int>(band->blobs.size());
+  band->sums.resize(num_of_blobs);
+  band->first_row.clear();
+  band->last_row.clear();
+  for (int i = 0; i < num_of_blobs; i++) {
+    band->sums[i] = cv::Point2d(sum_x_[i], sum_y_[i]);
+  }
+  for (int i = 0; i < static_cast<int>(runs_.size()); i++) {
+    const Run &run = runs_[i];
+    if ((run.y != row_begin) && (run.y != row_end - 1)) continue;
+    BandBlobs::SeamRun seam_run = {run.x_begin, run.x_end,
+                                   blob_of_root_[FindRoot(i)]};
+    if (run.y == row_begin) band->first_row.push_back(seam_run);
+    if (run.y == row_end - 1) band->last_row.push_back(seam_run);
+  }
+}
+
+void ConnectedComponentLabeler::LabelRows(const cv::Mat &gray,
+                                          const int &threshold,
+                                          const int &row_begin,
+                                          const int &row_end) {
+  runs_.clear();
+  parent_.clear();
+  int previous_row_begin = 0;
+  for (int y = row_begin; y < row_end; y++) {
+    int current_row_begin = static_cast<int>(runs_.size());
+    LabelRow(gray.ptr<uchar>(y), y, gray.cols, threshold, previous_row_begin);
+    previous_row_begin = current_row_begin;
+  }
+}
+// Two runs of neighbouring rows are 8-connected if they overlap when one of
+// them is widened by a pixel on each side. Both rows are sorted by x, so one
+// forward pass over the previous row is enough.
+void ConnectedComponentLabeler::LabelRow(const uchar *row,
+                                         const int &y,
+                                         const int &cols,
+                                         const int &threshold,
+                                         const int &previous_row_begin) {
+  int previous_row_end = static_cast<int>(runs_.size());
+  int previous = previous_row_begin;
+  int x = 0;
+  while (x < cols) {
+    if (row[x] <= threshold) {
+      x++;
+      continue;
+    }
+    Run run;
+    run.y = y;
+    run.x_begin = x;
+    while ((x < cols) && (row[x] > threshold)) {
+      x++;
+    }
+    run.x_end = x;
+    int index = static_cast<int>(runs_.size());
+    runs_.push_back(run);
+    parent_.push_back(index);
+    // skip the runs of the previous row which end too far on the left:
+    while ((previous < previous_row_end) &&
+           (runs_[previous].x_end < run.x_begin)) {
+      previous++;
+    }
+    // the ones which start early enough touch this run. previous is not moved
+    // past them, since the next run may touch the last of them as well:
+    for (int i = previous;
+         (i < previous_row_end) && (runs_[i].x_begin <= run.x_end);
+         i++) {
+      Unite(i, index);
+    }
+  }
+}
+
+int ConnectedComponentLabeler::FindRoot(int run) {
+  while (parent_[run] != run) {
+    parent_[run] = parent_[parent_[run]];  // path halving
+    run = parent_[run];
+  }
+  return run;
+}
+// The root of a set is always its first run, so the blobs come out in raster
+// order of their first pixel:
+void ConnectedComponentLabeler::Unite(const int &a, const int &b) {
+  int root_a = FindRoot(a);
+  int root_b = FindRoot(b);
+  if (root_a < root_b) {
+    parent_[root_b] = root_a;
+  } else if (root_b < root_a) {
+    parent_[root_a] = root_b;
+  }
+}
+
+void ConnectedComponentLabeler::CollectBlobs(std::vector<BlobStats> *blobs) {
+  blobs->clear();
+  sum_x_.clear();
+  sum_y_.clear();
+  blob_of_root_.assign(runs_.size(), -1);
+  for (size_t i = 0; i < runs_.size(); i++) {
+    const Run &run = runs_[i];
+    cv::Rect run_rect(run.x_begin, run.y, run.x_end - run.x_begin, 1);
+    int root = FindRoot(static_cast<int>(i));
+    if (blob_of_root_[root] < 0) {
+      blob_of_root_[root] = static_cast<int>(blobs->size());
+      BlobStats blob;
+      blob.bounding_rect = run_rect;
+      blobs->push_back(blob);
+      sum_x_.push_back(0);
+      sum_y_.push_back(0);
+    }
+    int index = blob_of_root_[root];
+    BlobStats &blob = (*blobs)[index];
+    int length = run.x_end - run.x_begin;
+    blob.area += length;
+    blob.bounding_rect |= run_rect;
+    // sum of x_begin, x_begin + 1, ..., x_end - 1:
+    sum_x_[index] += (run.x_begin + run.x_end - 1) * 0.5 * length;
+    sum_y_[index] += static_cast<double>(run.y) * length;
+  }
+  for (size_t i = 0; i < blobs->size(); i++) {
+    BlobStats &blob = (*blobs)[i];
+    blob.centroid = cv::Point2d(sum_x_[i] / blob.area, sum_y_[i] / blob.area);
+  }
+}
+// 1. Join the blobs which touch across the seam of every two bands, with the
+// same test LabelRow(..) uses for two rows;
+// 2. sum the statistics of every set. The bands come from top to bottom and
+// their blobs are in raster order, so the first member of a set met holds its
+// first pixel, and the sets come out in raster order as well.
+void MergeBands(const std::vector<BandBlobs> &bands,
+                std::vector<BlobStats> *blobs) {
+  assert(blobs != nullptr);
+  // 1:
+  std::vector<int> band_offsets(bands.size() + 1, 0);
+  for (size_t b = 0; b < bands.size(); b++) {
+    band_offsets[b + 1] = band_offsets[b] +
+                          static_cast<int>(bands[b].blobs.size());
+  }
+  std::vector<int> parent(band_offsets.back());
+  for (int i = 0; i < static_cast<int>(parent.size()); i++) {
+    parent[i] = i;
+  }
+  for (size_t b = 1; b < bands.size(); b++) {
+    const auto &upper = bands[b - 1].last_row;
+    const auto &lower = bands[b].first_row;
+    size_t previous = 0;
+    for (const auto &run : lower) {
+      while ((previous < upper.size()) &&
+             (upper[previous].x_end < run.x_begin)) {
+        previous++;
+      }
+      for (size_t i = previous;
+           (i < upper.size()) && (upper[i].x_begin <= run.x_end);
+           i++) {
+        Unite(&parent, band_offsets[b - 1] + upper[i].blob,
+              band_offsets[b] + run.blob);
+      }
+    }
+  }
+  // 2:
+  blobs->clear();
+  std::vector<int> blob_of_root(parent.size(), -1);
+  std::vector<cv::Point2d> sums;
+  for (size_t b = 0; b < bands.size(); b++) {
+    const BandBlobs &band = bands[b];
+    for (int i = 0; i < static_cast<int>(band.blobs.size()); i++) {
+      int root = FindRoot(&parent, band_offsets[b] + i);
+      const BlobStats &part = band.blobs[i];
+      if (blob_of_root[root] < 0) {
+        blob_of_root[root] = static_cast<int>(blobs->size());
+        BlobStats blob;
+        blob.bounding_rect = part.bounding_rect;
+        blobs->push_back(blob);
+        sums.push_back(cv::Point2d(0, 0));
+      }
+      int index = blob_of_root[root];
+      BlobStats &blob = (*blobs)[index];
+      blob.area += part.area;
+      blob.bounding_rect |= part.bounding_rect;
+      sums[index] += band.sums[i];
+    }
+  }
+  for (int i = 0; i < static_cast<int>(blobs->size()); i++) {
+    BlobStats &blob = (*blobs)[i];
+    blob.centroid = cv::Point2d(sums[i].x / blob.area, sums[i].y / blob.area);
+  }
+}
+}  // namespace object_clustering
@@ -0,0 +1,50 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// detector_workspace.cc
+// Object Clustering
+
+#include <cassert>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "detector_workspace.h"
+
+namespace object_clustering {
+// Every matrix is pooled, so that the allocator sees all of them:
+DetectorWorkspace::DetectorWorkspace():
+  rect_index_(std::vector<cv::Rect>()) {
+  raw_mask_.allocator = &allocator_;
+  gray_.allocator = &allocator_;
+  threshold_output_.allocator = &allocator_;
+  for (auto &level : levels_) {
+    level.allocator = &allocator_;
+  }
+  coarse_mask_.allocator = &allocator_;
+  coarse_gray_.allocator = &allocator_;
+  region_mask_.allocator = &allocator_;
+  region_gray_.allocator = &allocator_;
+}
+// A new scratch is made only when every one is held, so there are never more
+// than the tasks which ran at once.
+DetectorWorkspace::TaskLease::TaskLease(DetectorWorkspace *workspace):
+  workspace_(workspace) {
+  assert(workspace != nullptr);
+  std::lock_guard<std::mutex> lock(workspace->task_mutex_);
+  if (workspace->free_tasks_.empty()) {
+    workspace->tasks_.push_back(
+        std::unique_ptr<TaskScratch>(new TaskScratch()));
+    scratch_ = workspace->tasks_.back().get();
+    scratch_->binary.allocator = &workspace->allocator_;
+    workspace->free_tasks_.reserve(workspace->tasks_.size());
+  } else {
+    scratch_ = workspace->free_tasks_.back();
+    workspace->free_tasks_.pop_back();
+  }
+}
+
+DetectorWorkspace::TaskLease::~TaskLease() {
+  std::lock_guard<std::mutex> lock(workspace_->task_mutex_);
+  workspace_->free_tasks_.push_back(scratch_);
+}
+}  // namespace object_clustering
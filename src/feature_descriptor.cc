@@ -0,0 +1,141 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// feature_descriptor.cc
+// Object Clustering
+
+#include <cassert>
+#include <cstdlib>
+
+#include <vector>
+
+#include "feature_descriptor.h"
+
+namespace object_clustering {
+// the definitions of the widths, for the callers which take their address:
+constexpr int SizeFeatures::kWidth;
+constexpr int RegionColorFeatures::kNumberOfRegions;
+constexpr int RegionColorFeatures::kWidth;
+constexpr int ShapeFeatures::kWidth;
+
+FeatureSource::FeatureSource(const cv::Mat &matrix,
+                             const IntegralColorImage *integral):
+    matrix_(&matrix),
+    integral_(integral) {
+  if (integral_ != nullptr) {
+    cv::Size frame_size;
+    matrix.locateROI(frame_size, offset_);
+    assert(integral_->Contains(cv::Rect(offset_, matrix.size())));
+  }
+}
+
+cv::Scalar FeatureSource::Mean(const cv::Rect &rect) const {
+  if (integral_ == nullptr) return cv::mean(cv::Mat(*matrix_, rect));
+  return integral_->Mean(rect + offset_);
+}
+
+void SizeFeatures::Extract(const FeatureSource &source, float *features) {
+  assert(features != nullptr);
+  const cv::Mat &matrix = source.matrix();
+  features[0] = matrix.cols;  // width
+  features[1] = matrix.rows;  // height
+}
+
+void RegionColorFeatures::Regions(const cv::Size &size,
+                                  cv::Rect regions[kNumberOfRegions]) {
+  int i = 0;
+  // the whole image:
+  regions[i++] = cv::Rect(0, 0, size.width, size.height);
+
+  // the center of the image:
+  int x = size.width * 0.2;
+  int y = size.height * 0.2;
+  int width = size.width - 2*x > 0 ? size.width - 2*x : 1;
+  int height = size.height - 2*y > 0 ? size.height - 2*y : 1;
+  assert((x > 0) && (y > 0) && (width > 0) && (height > 0));
+  regions[i++] = cv::Rect(x, y, width, height);
+  // 4 subregions:
+  width = size.width;
+  height = size.height;
+  regions[i++] = cv::Rect(0, 0, width/2, height/2);
+  regions[i++] = cv::Rect(width/2, 0, width/2, height/2);
+  regions[i++] = cv::Rect(0, height/2, width/2, height/2);
+  regions[i++] = cv::Rect(width/2, height/2, width/2, height/2);
+  assert(i == kNumberOfRegions);
+}
+
+void RegionColorFeatures::Extract(const FeatureSource &source,
+                                  float *features) {
+  assert(features != nullptr);
+  cv::Rect regions[kNumberOfRegions];
+  Regions(source.matrix().size(), regions);
+  int j = 0;
+  for (const auto &region : regions) {
+    cv::Scalar color = source.Mean(region);
+    features[j++] = color[0];  // avg blue
+    features[j++] = color[1];  // avg green
+    features[j++] = color[2];  // avg red
+  }
+  assert(j == kWidth);
+}
+
+void ShapeFeatures::Extract(const FeatureSource &source, float *features) {
+  assert(features != nullptr);
+  const cv::Mat &matrix = source.matrix();
+  features[0] = abs(matrix.cols - matrix.rows);
+  features[1] = matrix.cols*matrix.cols;
+}
+
+FeatureVector ExtractFeatures(const Image &image) {
+  FeatureVector features;
+  ObjectFeatures::Extract(FeatureSource(image.matrix()), features.data());
+  return features;
+}
+// The images of the objects of a frame are regions of the frame, so they
+// share its buffer; locateROI(..) tells where in the frame each one is. The
+// images which are not CV_8UC3 are averaged by cv::mean(..).
+void ExtractFeatures(const std::vector<Object> &objects,
+                     FeatureMatrix *features) {
+  assert(features != nullptr);
+  assert(features->rows() == static_cast<int>(objects.size()));
+  assert(features->cols() == kNumberOfFeatures);
+  // 1. Find the frames and the part of each one the objects cover:
+  std::vector<cv::Mat> frames;
+  std::vector<cv::Rect> covered;
+  std::vector<int> frame_of_object(objects.size());
+  for (size_t i = 0; i < objects.size(); i++) {
+    const cv::Mat &matrix = objects[i].image().matrix();
+    frame_of_object[i] = -1;
+    if (matrix.type() != CV_8UC3) continue;
+    cv::Size frame_size;
+    cv::Point offset;
+    matrix.locateROI(frame_size, offset);
+    cv::Rect rect(offset, matrix.size());
+    size_t frame = 0;
+    while ((frame < frames.size()) &&
+           (frames[frame].datastart != matrix.datastart)) {
+      frame++;
+    }
+    if (frame == frames.size()) {
+      cv::Mat whole = matrix;
+      whole.adjustROI(offset.y, frame_size.height - rect.br().y,
+                      offset.x, frame_size.width - rect.br().x);
+      frames.push_back(whole);
+      covered.push_back(rect);
+    } else {
+      covered[frame] |= rect;
+    }
+    frame_of_object[i] = static_cast<int>(frame);
+  }
+  // 2. One integral image per frame:
+  std::vector<IntegralColorImage> integrals;
+  for (size_t frame = 0; frame < frames.size(); frame++) {
+    integrals.push_back(IntegralColorImage(frames[frame], covered[frame]));
+  }
+  // 3. The features, straight into the rows:
+  for (size_t i = 0; i < objects.size(); i++) {
+    int frame = frame_of_object[i];
+    FeatureSource source(objects[i].image().matrix(),
+                         frame < 0 ? nullptr : &integrals[frame]);
+    ObjectFeatures::Extract(source, features->row(static_cast<int>(i)));
+  }
+}
+}  // namespace object_clustering
@@ -0,0 +1,140 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// feature_matrix.cc
+// Object Clustering
+
+#include <cassert>
+#include <cfloat>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "feature_matrix.h"
+
+namespace object_clustering {
+namespace {
+bool IsAligned(const float *pointer) {
+  return reinterpret_cast<std::uintptr_t>(pointer) % kFeatureAlignment == 0;
+}
+}  // namespace
+
+void FeatureMatrix::Create(const int &num_of_rows, const int &num_of_columns) {
+  assert((num_of_rows >= 0) && (num_of_columns >= 0));
+  rows_ = num_of_rows;
+  cols_ = num_of_columns;
+  stride_ = (num_of_columns + kFeaturesPerVector - 1) / kFeaturesPerVector *
+            kFeaturesPerVector;
+  // cv::Mat allocates 16-byte aligned buffers, and a row takes a multiple of
+  // 16 bytes, so every row is aligned:
+  buffer_.create(rows_, stride_, CV_32FC1);
+  SetZero();
+}
+
+void FeatureMatrix::SetZero() {
+  buffer_.setTo(cv::Scalar::all(0));
+}
+// Every kernel works on kFeaturesPerVector floats at a time when SSE2 is
+// available; the padding being zero, it does not change the result.
+float SquaredDistance(const float *a, const float *b, const int &stride) {
+  assert(IsAligned(a) && IsAligned(b));
+  assert(stride % kFeaturesPerVector == 0);
+#if defined(__SSE2__)
+  __m128 sum = _mm_setzero_ps();
+  for (int i = 0; i < stride; i += kFeaturesPerVector) {
+    __m128 difference = _mm_sub_ps(_mm_load_ps(a + i), _mm_load_ps(b + i));
+    sum = _mm_add_ps(sum, _mm_mul_ps(difference, difference));
+  }
+  // add the four partial sums:
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+#else
+  float sum = 0;
+  for (int i = 0; i < stride; i++) {
+    float difference = a[i] - b[i];
+    sum += difference * difference;
+  }
+  return sum;
+#endif
+}
+
+int NearestRow(const float *sample,
+               const FeatureMatrix &centers,
+               float *distance) {
+  assert(distance != nullptr);
+  assert(!centers.empty());
+  int nearest = 0;
+  float nearest_distance = FLT_MAX;
+  for (int i = 0; i < centers.rows(); i++) {
+    float current = SquaredDistance(sample, centers.row(i), centers.stride());
+    if (current < nearest_distance) {
+      nearest_distance = current;
+      nearest = i;
+    }
+  }
+  *distance = nearest_distance;
+  return nearest;
+}
+
+void AddRow(const float *source, const int &stride, float *destination) {
+  assert(IsAligned(source) && IsAligned(destination));
+  int i = 0;
+#if defined(__SSE2__)
+  for (; i < stride; i += kFeaturesPerVector) {
+    _mm_store_ps(destination + i, _mm_add_ps(_mm_load_ps(destination + i),
+                                             _mm_load_ps(source + i)));
+  }
+#endif
+  for (; i < stride; i++) {
+    destination[i] += source[i];
+  }
+}
+
+void SubtractRow(const float *source, const int &stride, float *destination) {
+  assert(IsAligned(source) && IsAligned(destination));
+  int i = 0;
+#if defined(__SSE2__)
+  for (; i < stride; i += kFeaturesPerVector) {
+    _mm_store_ps(destination + i, _mm_sub_ps(_mm_load_ps(destination + i),
+                                             _mm_load_ps(source + i)));
+  }
+#endif
+  for (; i < stride; i++) {
+    destination[i] -= source[i];
+  }
+}
+
+void AddScaledRow(const float *source,
+                  const float &factor,
+                  const int &stride,
+                  float *destination) {
+  assert(IsAligned(source) && IsAligned(destination));
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128 multiplier = _mm_set1_ps(factor);
+  for (; i < stride; i += kFeaturesPerVector) {
+    _mm_store_ps(destination + i, _mm_add_ps(
+        _mm_load_ps(destination + i),
+        _mm_mul_ps(_mm_load_ps(source + i), multiplier)));
+  }
+#endif
+  for (; i < stride; i++) {
+    destination[i] += factor * source[i];
+  }
+}
+
+void ScaleRow(const float &factor, const int &stride, float *row) {
+  assert(IsAligned(row));
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128 multiplier = _mm_set1_ps(factor);
+  for (; i < stride; i += kFeaturesPerVector) {
+    _mm_store_ps(row + i, _mm_mul_ps(_mm_load_ps(row + i), multiplier));
+  }
+#endif
+  for (; i < stride; i++) {
+    row[i] *= factor;
+  }
+}
+}  // namespace object_clustering
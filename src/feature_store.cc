@@ -0,0 +1,221 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// feature_store.cc
+// Object Clustering
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <string>
+#include <vector>
+
+#include "feature_store.h"
+
+namespace object_clustering {
+namespace {
+// The header every store of this build starts with:
+FeatureStoreHeader CurrentHeader() {
+  FeatureStoreHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kFeatureStoreMagic, sizeof(header.magic));
+  header.version = kFeatureStoreVersion;
+  header.num_of_features = kNumberOfFeatures;
+  header.row_size = sizeof(FeatureStoreRow);
+  return header;
+}
+// Returns true if the header is the one of the stores of this build:
+bool IsCurrentHeader(const FeatureStoreHeader &header) {
+  FeatureStoreHeader current = CurrentHeader();
+  return (memcmp(header.magic, current.magic, sizeof(header.magic)) == 0) &&
+         (header.version == current.version) &&
+         (header.num_of_features == current.num_of_features) &&
+         (header.row_size == current.row_size);
+}
+}  // namespace
+// 1. Open the file, or create it with a header;
+// 2. check the header of an existing store;
+// 3. drop a row which was cut short, so that the rows appended stay whole.
+FeatureStoreWriter::FeatureStoreWriter(const std::string &filename) {
+  // 1:
+  file_ = fopen(filename.c_str(), "r+b");
+  if (file_ == NULL) {
+    file_ = fopen(filename.c_str(), "w+b");
+    if (file_ == NULL) return;
+  }
+  struct stat file_stat;
+  if (fstat(fileno(file_), &file_stat) != 0) {
+    fclose(file_);
+    file_ = NULL;
+    return;
+  }
+  size_t size = static_cast<size_t>(file_stat.st_size);
+  if (size == 0) {
+    FeatureStoreHeader header = CurrentHeader();
+    if (fwrite(&header, sizeof(header), 1, file_) != 1) failed_ = true;
+    return;
+  }
+  // 2:
+  FeatureStoreHeader header;
+  if ((size < sizeof(header)) ||
+      (fread(&header, sizeof(header), 1, file_) != 1) ||
+      !IsCurrentHeader(header)) {
+    fclose(file_);
+    file_ = NULL;
+    return;
+  }
+  // 3:
+  size_t whole_size = sizeof(header) + (size - sizeof(header)) /
+                      sizeof(FeatureStoreRow) * sizeof(FeatureStoreRow);
+  if ((whole_size != size) &&
+      (ftruncate(fileno(file_), static_cast<off_t>(whole_size)) != 0)) {
+    failed_ = true;
+  }
+  if (fseek(file_, 0, SEEK_END) != 0) failed_ = true;
+}
+
+FeatureStoreWriter::~FeatureStoreWriter() {
+  if (file_ != NULL) Close();
+}
+
+bool FeatureStoreWriter::Append(const int64_t &frame_id,
+                                const cv::Rect &rect,
+                                const FeatureVector &features) {
+  FeatureStoreRow row;
+  memset(&row, 0, sizeof(row));
+  row.frame_id = frame_id;
+  row.x = rect.x;
+  row.y = rect.y;
+  row.width = rect.width;
+  row.height = rect.height;
+  std::copy(features.begin(), features.end(), row.features);
+  std::lock_guard<std::mutex> lock(mutex_);
+  return AppendRows(&row, 1);
+}
+// The features are extracted before the lock is taken, so the threads which
+// append at the same time only wait for each other's writes.
+bool FeatureStoreWriter::Append(const int64_t &frame_id,
+                                const std::vector<Object> &objects) {
+  if (objects.empty()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (file_ != NULL) && !failed_;
+  }
+  int num_of_objects = static_cast<int>(objects.size());
+  FeatureMatrix features(num_of_objects, kNumberOfFeatures);
+  ExtractFeatures(objects, &features);
+  std::vector<FeatureStoreRow> rows(num_of_objects);
+  memset(&rows[0], 0, rows.size() * sizeof(rows[0]));
+  for (int i = 0; i < num_of_objects; i++) {
+    const cv::Rect &rect = objects[i].image().bounding_rect();
+    rows[i].frame_id = frame_id;
+    rows[i].x = rect.x;
+    rows[i].y = rect.y;
+    rows[i].width = rect.width;
+    rows[i].height = rect.height;
+    std::copy(features.row(i), features.row(i) + kNumberOfFeatures,
+              rows[i].features);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  return AppendRows(&rows[0], rows.size());
+}
+
+bool FeatureStoreWriter::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ == NULL) return false;
+  if (fflush(file_) != 0) failed_ = true;
+  return !failed_;
+}
+
+bool FeatureStoreWriter::Close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ == NULL) return false;
+  if (fclose(file_) != 0) failed_ = true;
+  file_ = NULL;
+  return !failed_;
+}
+
+int64_t FeatureStoreWriter::num_of_rows() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_of_rows_;
+}
+
+bool FeatureStoreWriter::AppendRows(const FeatureStoreRow *rows,
+                                    const size_t &num_of_rows) {
+  assert(rows != nullptr);
+  if (file_ == NULL) return false;
+  if (fwrite(rows, sizeof(rows[0]), num_of_rows, file_) != num_of_rows) {
+    failed_ = true;
+    return false;
+  }
+  num_of_rows_ += num_of_rows;
+  return !failed_;
+}
+// The file descriptor is not needed once the file is mapped. The rows are
+// read in order by the chunked passes, which the system is told about.
+MappedFeatureStore::MappedFeatureStore(const std::string &filename) {
+  int file = open(filename.c_str(), O_RDONLY);
+  if (file < 0) return;
+  struct stat file_stat;
+  if ((fstat(file, &file_stat) == 0) &&
+      (file_stat.st_size >= static_cast<off_t>(sizeof(FeatureStoreHeader)))) {
+    size_ = static_cast<size_t>(file_stat.st_size);
+    void *data = mmap(NULL, size_, PROT_READ, MAP_SHARED, file, 0);
+    if (data != MAP_FAILED) data_ = data;
+  }
+  close(file);
+  if (data_ == nullptr) return;
+  FeatureStoreHeader header;
+  memcpy(&header, data_, sizeof(header));
+  if (!IsCurrentHeader(header)) {
+    munmap(data_, size_);
+    data_ = nullptr;
+    return;
+  }
+  madvise(data_, size_, MADV_SEQUENTIAL);
+  rows_ = reinterpret_cast<const FeatureStoreRow*>(
+      static_cast<const char*>(data_) + sizeof(header));
+  // a row cut short is not counted:
+  num_of_rows_ = static_cast<int64_t>((size_ - sizeof(header)) /
+                                      sizeof(FeatureStoreRow));
+  opened_ = true;
+}
+
+MappedFeatureStore::~MappedFeatureStore() {
+  if (data_ != nullptr) munmap(data_, size_);
+}
+
+const FeatureStoreRow& MappedFeatureStore::row(const int64_t &index) const {
+  assert(IsOpened());
+  assert((index >= 0) && (index < num_of_rows_));
+  return rows_[index];
+}
+
+int MappedFeatureStore::ReadChunk(const int64_t &begin,
+                                  const int &num_of_rows,
+                                  FeatureMatrix *chunk) const {
+  assert(chunk != nullptr);
+  assert((begin >= 0) && (begin < num_of_rows_));
+  assert(num_of_rows > 0);
+  int num_read = static_cast<int>(std::min<int64_t>(num_of_rows,
+                                                    num_of_rows_ - begin));
+  if ((chunk->rows() != num_read) || (chunk->cols() != kNumberOfFeatures)) {
+    chunk->Create(num_read, kNumberOfFeatures);
+  }
+  for (int i = 0; i < num_read; i++) {
+    const float *features = rows_[begin + i].features;
+    std::copy(features, features + kNumberOfFeatures, chunk->row(i));
+  }
+  return num_read;
+}
+
+bool IsFeatureStoreName(const std::string &filename) {
+  size_t length = strlen(kFeatureStoreExtension);
+  return (filename.size() > length) &&
+         (filename.compare(filename.size() - length, length,
+                           kFeatureStoreExtension) == 0);
+}
+}  // namespace object_clustering
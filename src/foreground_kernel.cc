@@ -0,0 +1,180 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// foreground_kernel.cc
+// Object Clustering
+
+#include <cassert>
+
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include "foreground_kernel.h"
+
+namespace object_clustering {
+namespace {
+const int kBoxSize = 9;  // pixels in the 3x3 neighbourhood
+// The box filter divides the sum of 0..9 white pixels (255 each) by 9, and
+// (count * 1813 + 32) >> 6 rounds it exactly the same way for every count:
+const int kBoxScaleMultiplier = 1813;
+const int kBoxScaleShift = 6;
+
+// The gray value of the blurred pixel with count white neighbours, computed
+// as the box filter does it:
+uchar BoxValue(const int &count) {
+  return cv::saturate_cast<uchar>(count * 255 * (1. / kBoxSize));
+}
+// Writes 1 for the pixels of the row which end up white after recoloring and
+// 0 for the others, into binary[1..cols]. binary[0] and binary[cols + 1] are
+// filled with the reflected neighbours, as the default border does.
+void BinarizeRow(const uchar *mask, const uchar *bgr, const int &cols,
+                 uchar *binary) {
+  for (int x = 0; x < cols; x++, bgr += 3) {
+    // the pixel is black after the masked copy when the mask is 0 or shadow,
+    // and it may be black in the image itself:
+    bool black = (mask[x] == 0) || (mask[x] == kShadowIntensity) ||
+                 ((bgr[0] | bgr[1] | bgr[2]) == 0);
+    binary[x + 1] = black ? 1 : 0;
+  }
+  binary[0] = binary[1 + cv::borderInterpolate(-1, cols,
+                                               cv::BORDER_REFLECT_101)];
+  binary[cols + 1] = binary[1 + cv::borderInterpolate(cols, cols,
+                                                      cv::BORDER_REFLECT_101)];
+}
+// Keeps the last three binarized rows, so that every row is binarized once.
+// buffer should hold 3 * (image.cols + 2) bytes.
+class BinaryRowCache {
+ public:
+  BinaryRowCache(const cv::Mat &mask, const cv::Mat &image, uchar *buffer):
+    mask_(mask),
+    image_(image),
+    padded_cols_(image.cols + 2),
+    buffer_(buffer) {
+    for (int i = 0; i < 3; i++) {
+      cached_rows_[i] = -1;
+    }
+  }
+
+  const uchar* Row(const int &y) {
+    for (int i = 0; i < 3; i++) {
+      if (cached_rows_[i] == y) {
+        return &buffer_[i * padded_cols_];
+      }
+    }
+    // rows are requested in increasing order, so the smallest is the oldest:
+    int oldest = 0;
+    for (int i = 1; i < 3; i++) {
+      if (cached_rows_[i] < cached_rows_[oldest]) {
+        oldest = i;
+      }
+    }
+    cached_rows_[oldest] = y;
+    uchar *binary = &buffer_[oldest * padded_cols_];
+    BinarizeRow(mask_.ptr<uchar>(y), image_.ptr<uchar>(y), image_.cols,
+                binary);
+    return binary;
+  }
+
+ private:
+  const cv::Mat &mask_;
+  const cv::Mat &image_;
+  int padded_cols_;
+  uchar *buffer_;
+  int cached_rows_[3];
+};
+}  // namespace
+
+void ForegroundToBlurredGray(const cv::Mat &raw_mask,
+                             const cv::Mat &image,
+                             cv::Mat *blurred_gray,
+                             std::vector<uchar> *row_buffer) {
+  assert(blurred_gray != nullptr);
+  blurred_gray->create(image.rows, image.cols, CV_8UC1);
+  ForegroundToBlurredGrayRows(raw_mask, image, 0, image.rows, blurred_gray,
+                              row_buffer);
+}
+// For every output row:
+// 1. binarize the three source rows (or take them from the cache);
+// 2. sum them vertically;
+// 3. sum three neighbouring vertical sums and scale the count to gray.
+// Steps 2 and 3 work on 16 pixels at a time when SSE2 is available. The three
+// cached rows and the vertical sums share the row buffer.
+void ForegroundToBlurredGrayRows(const cv::Mat &raw_mask,
+                                 const cv::Mat &image,
+                                 const int &row_begin,
+                                 const int &row_end,
+                                 cv::Mat *blurred_gray,
+                                 std::vector<uchar> *row_buffer) {
+  assert(blurred_gray != nullptr);
+  assert(raw_mask.type() == CV_8UC1);
+  assert(image.type() == CV_8UC3);
+  assert((raw_mask.rows == image.rows) && (raw_mask.cols == image.cols));
+  assert((blurred_gray->rows == image.rows) &&
+         (blurred_gray->cols == image.cols));
+  assert((row_begin >= 0) && (row_end <= image.rows));
+  int cols = image.cols;
+  int padded_cols = cols + 2;
+  std::vector<uchar> local_buffer;
+  if (row_buffer == nullptr) row_buffer = &local_buffer;
+  if (row_buffer->size() < 4 * static_cast<size_t>(padded_cols)) {
+    row_buffer->resize(4 * padded_cols);
+  }
+  BinaryRowCache cache(raw_mask, image, row_buffer->data());
+  uchar *vertical_sum = row_buffer->data() + 3 * padded_cols;
+  uchar lut[kBoxSize + 1];
+  for (int i = 0; i <= kBoxSize; i++) {
+    lut[i] = BoxValue(i);
+  }
+  for (int y = row_begin; y < row_end; y++) {
+    const uchar *above = cache.Row(cv::borderInterpolate(
+        y - 1, image.rows, cv::BORDER_REFLECT_101));
+    const uchar *middle = cache.Row(y);
+    const uchar *below = cache.Row(cv::borderInterpolate(
+        y + 1, image.rows, cv::BORDER_REFLECT_101));
+    uchar *sum = vertical_sum;
+    uchar *dst = blurred_gray->ptr<uchar>(y);
+    int x = 0;
+#if defined(__SSE2__)
+    for (; x + 16 <= padded_cols; x += 16) {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(above + x));
+      __m128i b = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(middle + x));
+      __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(below + x));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(sum + x),
+                       _mm_add_epi8(_mm_add_epi8(a, b), c));
+    }
+#endif
+    for (; x < padded_cols; x++) {
+      sum[x] = above[x] + middle[x] + below[x];
+    }
+    x = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i multiplier = _mm_set1_epi16(kBoxScaleMultiplier);
+    const __m128i rounding = _mm_set1_epi16(1 << (kBoxScaleShift - 1));
+    for (; x + 16 <= cols; x += 16) {
+      __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sum + x));
+      __m128i center = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(sum + x + 1));
+      __m128i right = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(sum + x + 2));
+      __m128i count = _mm_add_epi8(_mm_add_epi8(left, center), right);
+      __m128i low = _mm_unpacklo_epi8(count, zero);
+      __m128i high = _mm_unpackhi_epi8(count, zero);
+      low = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(low, multiplier),
+                                         rounding), kBoxScaleShift);
+      high = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(high, multiplier),
+                                          rounding), kBoxScaleShift);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                       _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; x < cols; x++) {
+      dst[x] = lut[sum[x] + sum[x + 1] + sum[x + 2]];
+    }
+  }
+}
+}  // namespace object_clustering
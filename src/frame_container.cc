@@ -0,0 +1,181 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// frame_container.cc
+// Object Clustering
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>
+
+#include <string>
+
+#include "frame_container.h"
+
+namespace object_clustering {
+namespace {
+// The zeros written between the frames, to align the next one:
+const char kPadding[kFrameAlignment] = {0};
+}  // namespace
+// The header is written with no frames yet, and rewritten by Close():
+FrameContainerWriter::FrameContainerWriter(const std::string &filename):
+  file_(fopen(filename.c_str(), "wb")) {
+  if (file_ == NULL) return;
+  FrameContainerHeader header;
+  memset(&header, 0, sizeof(header));
+  if (fwrite(&header, sizeof(header), 1, file_) != 1) failed_ = true;
+  size_ = sizeof(header);
+}
+
+FrameContainerWriter::~FrameContainerWriter() {
+  if (file_ != NULL) Close();
+}
+// The rows of frame are written one by one, since it may be a region of a
+// bigger matrix; the rows in the container have no gaps.
+bool FrameContainerWriter::Append(const cv::Mat &frame) {
+  if ((file_ == NULL) || (frame.type() != CV_8UC3) || frame.empty()) {
+    failed_ = true;
+    return false;
+  }
+  size_t padding = (kFrameAlignment - size_ % kFrameAlignment) %
+                   kFrameAlignment;
+  if (fwrite(kPadding, 1, padding, file_) != padding) failed_ = true;
+  size_ += padding;
+  FrameContainerEntry entry;
+  entry.rows = frame.rows;
+  entry.cols = frame.cols;
+  entry.step = static_cast<uint64_t>(frame.cols) * frame.elemSize();
+  entry.offset = size_;
+  for (int y = 0; y < frame.rows; y++) {
+    if (fwrite(frame.ptr<uchar>(y), 1, entry.step, file_) != entry.step) {
+      failed_ = true;
+    }
+  }
+  size_ += entry.step * entry.rows;
+  index_.push_back(entry);
+  return !failed_;
+}
+
+bool FrameContainerWriter::Close() {
+  if (file_ == NULL) return false;
+  FrameContainerHeader header;
+  memcpy(header.magic, kFrameContainerMagic, sizeof(header.magic));
+  header.version = kFrameContainerVersion;
+  header.num_of_frames = static_cast<uint32_t>(index_.size());
+  header.index_offset = size_;
+  if (!index_.empty() &&
+      (fwrite(&index_[0], sizeof(index_[0]), index_.size(), file_) !=
+       index_.size())) {
+    failed_ = true;
+  }
+  if ((fseek(file_, 0, SEEK_SET) != 0) ||
+      (fwrite(&header, sizeof(header), 1, file_) != 1)) {
+    failed_ = true;
+  }
+  if (fclose(file_) != 0) failed_ = true;
+  file_ = NULL;
+  return !failed_;
+}
+// The file descriptor is not needed once the file is mapped.
+MappedFrameContainer::MappedFrameContainer(const std::string &filename) {
+  int file = open(filename.c_str(), O_RDONLY);
+  if (file < 0) return;
+  struct stat file_stat;
+  if ((fstat(file, &file_stat) == 0) &&
+      (file_stat.st_size >= static_cast<off_t>(sizeof(FrameContainerHeader)))) {
+    size_ = static_cast<size_t>(file_stat.st_size);
+    void *data = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                      file, 0);
+    if (data != MAP_FAILED) data_ = static_cast<uchar*>(data);
+  }
+  close(file);
+  if ((data_ != nullptr) && !ReadIndex()) {
+    munmap(data_, size_);
+    data_ = nullptr;
+  }
+}
+
+MappedFrameContainer::~MappedFrameContainer() {
+  if (data_ != nullptr) munmap(data_, size_);
+}
+
+Image MappedFrameContainer::frame(const int &index) const {
+  assert(IsOpened());
+  assert((index >= 0) && (index < num_of_frames()));
+  const FrameContainerEntry &entry = index_[index];
+  return Image(cv::Mat(entry.rows, entry.cols, CV_8UC3,
+                       data_ + entry.offset, entry.step));
+}
+// Every size is checked against the size of the file before it is used, so
+// a truncated or a foreign file is rejected rather than read out of bounds.
+bool MappedFrameContainer::ReadIndex() {
+  FrameContainerHeader header;
+  memcpy(&header, data_, sizeof(header));
+  if ((memcmp(header.magic, kFrameContainerMagic, sizeof(header.magic)) != 0) ||
+      (header.version != kFrameContainerVersion) ||
+      (header.index_offset > size_) ||
+      ((size_ - header.index_offset) / sizeof(FrameContainerEntry) <
+       header.num_of_frames)) {
+    return false;
+  }
+  index_.resize(header.num_of_frames);
+  if (!index_.empty()) {
+    memcpy(&index_[0], data_ + header.index_offset,
+           index_.size() * sizeof(index_[0]));
+  }
+  for (const auto &entry : index_) {
+    if ((entry.rows <= 0) || (entry.cols <= 0) ||
+        (entry.step < static_cast<uint64_t>(entry.cols) * 3) ||
+        (entry.offset > size_) ||
+        ((size_ - entry.offset) / entry.step < static_cast<uint64_t>(
+            entry.rows))) {
+      index_.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+ContainerFrameSource::ContainerFrameSource(const std::string &filename):
+  container_(filename) {
+  set_name(filename);
+}
+
+// The frame is copied rather than given as a view into the mapping, because
+// it outlives the source: StreamProcessor hands it on with the results, and
+// the ResultWriter of the streaming mode queues it and may draw it after the
+// stream has ended and the source has unmapped the file. A cv::Mat over
+// external pixels holds no reference to them, so nothing would keep the
+// mapping alive. Code which knows the mapping outlives its frames, like the
+// frame container benchmarks, uses MappedFrameContainer::frame(..) instead.
+bool ContainerFrameSource::NextFrame(cv::Mat *frame) {
+  assert(frame != nullptr);
+  if (!IsOpened() || (next_frame_ >= container_.num_of_frames())) {
+    return false;
+  }
+  container_.frame(next_frame_++).matrix().copyTo(*frame);
+  return true;
+}
+
+bool IsFrameContainerName(const std::string &filename) {
+  size_t length = strlen(kFrameContainerExtension);
+  return (filename.size() > length) &&
+         (filename.compare(filename.size() - length, length,
+                           kFrameContainerExtension) == 0);
+}
+
+int ConvertToFrameContainer(AbstractFrameSource *source,
+                            const std::string &filename) {
+  assert(source != nullptr);
+  FrameContainerWriter writer(filename);
+  if (!writer.IsOpened()) return -1;
+  cv::Mat frame;
+  while (source->NextFrame(&frame)) {
+    if (!writer.Append(frame)) break;
+  }
+  int num_of_frames = writer.num_of_frames();
+  return writer.Close() ? num_of_frames : -1;
+}
+}  // namespace object_clustering
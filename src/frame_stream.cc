@@ -0,0 +1,157 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// frame_stream.cc
+// Object Clustering
+
+#include <cassert>
+#include <cstdio>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "bounded_queue.h"
+#include "detector_workspace.h"
+#include "frame_stream.h"
+#include "object_tracker.h"
+
+namespace object_clustering {
+namespace {
+typedef std::chrono::steady_clock Clock;
+// A frame waiting in the queue:
+struct PendingFrame {
+  int index;
+  int sequence;  // the order in the queue, the skipped frames not counted
+  cv::Mat frame;
+  Clock::time_point read_time;
+};
+
+double MillisecondsSince(const Clock::time_point &start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+         .count();
+}
+}  // namespace
+
+VideoFrameSource::VideoFrameSource(const std::string &path):
+  capture_(path) {
+  set_name(path);
+}
+// VideoCapture reuses its buffer for the next frame, so the frame is cloned:
+bool VideoFrameSource::NextFrame(cv::Mat *frame) {
+  assert(frame != nullptr);
+  cv::Mat buffer;
+  if (!capture_.read(buffer) || buffer.empty()) return false;
+  *frame = buffer.clone();
+  return true;
+}
+
+StreamProcessor::StreamProcessor(const ObjectDetector &detector,
+                                 const BackgroundModel &background,
+                                 const AbstractClusterAlgorithm &clusterer,
+                                 const int &queue_capacity,
+                                 const int &num_of_workers):
+  detector_(detector),
+  background_(background),
+  clusterer_(clusterer),
+  queue_capacity_(queue_capacity),
+  num_of_workers_(num_of_workers) {
+  assert(queue_capacity > 0);
+  assert(num_of_workers > 0);
+}
+// 1. Start the workers, which take the frames from the queue; with tracking,
+// a worker waits for the previous frame to be tracked before tracking its
+// own;
+// 2. Read the frames into the queue in this thread;
+// 3. Close the queue and wait for the workers to finish the rest.
+StreamStatistics StreamProcessor::Process(
+    AbstractFrameSource *source,
+    const std::function<void(const FrameResult&)> &on_result) const {
+  assert(source != nullptr);
+  StreamStatistics statistics;
+  std::mutex result_mutex;  // guards statistics and on_result
+  double total_latency_ms = 0;
+  BoundedQueue<PendingFrame> queue(queue_capacity_);
+  ObjectTracker tracker;
+  std::mutex tracker_mutex;  // guards tracker and next_tracked
+  std::condition_variable tracker_turn;  // signaled after every frame
+  int next_tracked = 0;  // the sequence of the frame to track next
+  Clock::time_point start = Clock::now();
+  // 1:
+  std::vector<std::thread> workers;
+  for (int i = 0; i < num_of_workers_; i++) {
+    workers.push_back(std::thread([&]() {
+      // the frames of a stream have the same size, so after the first one the
+      // worker detects in the buffers of the previous frames:
+      DetectorWorkspace workspace;
+      PendingFrame pending;
+      while (queue.Pop(&pending)) {
+        FrameResult result;
+        result.frame_index = pending.index;
+        result.frame = pending.frame;
+        detector_.DetectObjectsFromImage(Image(pending.frame), background_,
+                                         &workspace, &result.objects);
+        if (tracking_) {
+          std::unique_lock<std::mutex> lock(tracker_mutex);
+          tracker_turn.wait(lock, [&]() {
+            return next_tracked == pending.sequence;
+          });
+          result.num_of_groups = tracker.AssignGroupsToObjects(
+              clusterer_, &result.objects);
+          next_tracked++;
+          tracker_turn.notify_all();
+        } else {
+          result.num_of_groups = clusterer_.AssignGroupsToObjects(
+              &result.objects);
+        }
+        result.latency_ms = MillisecondsSince(pending.read_time);
+
+        std::lock_guard<std::mutex> lock(result_mutex);
+        statistics.num_of_frames++;
+        statistics.num_of_objects += result.objects.size();
+        total_latency_ms += result.latency_ms;
+        statistics.max_latency_ms = std::max(statistics.max_latency_ms,
+                                             result.latency_ms);
+        on_result(result);
+      }
+    }));
+  }
+  // 2:
+  int index = 0;
+  int sequence = 0;
+  cv::Mat frame;
+  while (source->NextFrame(&frame)) {
+    if (frame.size() != background_.frame_size()) {
+      fprintf(stderr, "%s: frame %d is not of the background size, skipped\n",
+              source->get_name().c_str(), index);
+      std::lock_guard<std::mutex> lock(result_mutex);
+      statistics.num_of_skipped_frames++;
+    } else {
+      PendingFrame pending;
+      pending.index = index;
+      pending.sequence = sequence++;
+      pending.frame = frame;
+      pending.read_time = Clock::now();
+      queue.Push(std::move(pending));
+    }
+    index++;
+    frame = cv::Mat();  // the next frame gets new pixels
+  }
+  // 3:
+  queue.Close();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  statistics.num_of_tracked_objects = tracker.num_of_hits();
+  statistics.seconds = MillisecondsSince(start) / 1000;
+  if (statistics.num_of_frames > 0) {
+    statistics.mean_latency_ms = total_latency_ms / statistics.num_of_frames;
+  }
+  if (statistics.seconds > 0) {
+    statistics.frames_per_second = statistics.num_of_frames /
+                                   statistics.seconds;
+  }
+  return statistics;
+}
+}  // namespace object_clustering
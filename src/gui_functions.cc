@@ -11,6 +11,7 @@
 #include "image.h"
 #include "object.h"
 #include "gui_functions.h"
+#include "result_writer.h"
 
 namespace object_clustering {
 void ShowImage(const Image &image) {
@@ -25,22 +26,6 @@ void ShowResult(const Image &image,
                 const int &num_of_groups) {
   assert(objects.size() > 0);
   assert(num_of_groups > 0);
-  cv::Mat image_matrix = image.matrix();
-  for (int i = 0; i < num_of_groups; i++) {
-    cv::Scalar color = cvScalar(rand() % 255, rand() % 255, rand() % 255);
-    for (int j = 0; j < objects.size(); j++) {
-      if (objects[j].group() == i) {
-        rectangle(image_matrix,
-                  objects[j].image().bounding_rect().tl(),
-                  objects[j].image().bounding_rect().br(),
-                  color,
-                  5,
-                  8,
-                  0);
-      }
-    }
-  }
-  ShowImage(Image(image_matrix));
+  ShowImage(Image(AnnotateResult(image.matrix(), objects)));
 }
 }  // namespace object_clustering
-
@@ -0,0 +1,145 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// image_source.cc
+// Object Clustering
+
+#include <sys/stat.h>
+
+#include <cassert>
+
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include "opencv2/highgui/highgui.hpp"
+
+#include "image_source.h"
+
+namespace object_clustering {
+namespace {
+// The error Image(filename) gives:
+std::runtime_error ReadError(const std::string &filename) {
+  return std::runtime_error("Could not read the image from file " + filename);
+}
+// The modification time of a file in nanoseconds, so a file rewritten within
+// the same second is told apart:
+int64_t ModificationTime(const struct stat &file_stat) {
+#ifdef __APPLE__
+  const struct timespec &time = file_stat.st_mtimespec;
+#else
+  const struct timespec &time = file_stat.st_mtim;
+#endif
+  return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+}  // namespace
+
+DecodedImageCache::DecodedImageCache(const size_t &capacity_bytes):
+  capacity_bytes_(capacity_bytes) {}
+// 1. Find a fresh entry of the file, and wait for it outside the lock;
+// 2. otherwise add an entry which is being decoded, so the other threads
+// wait for it instead of decoding the file again;
+// 3. decode outside the lock; an image bigger than the whole cache is not
+// kept, otherwise count its pixels and evict the least recently used entries,
+// unless the entry has been evicted meanwhile.
+Image DecodedImageCache::Get(const std::string &filename) {
+  struct stat file_stat;
+  if (stat(filename.c_str(), &file_stat) != 0) throw ReadError(filename);
+  std::unique_lock<std::mutex> lock(mutex_);
+  // 1:
+  auto found = entries_.find(filename);
+  if (found != entries_.end()) {
+    Entry &entry = found->second;
+    if ((entry.modification_time == ModificationTime(file_stat)) &&
+        (entry.file_size == file_stat.st_size)) {
+      recency_.splice(recency_.begin(), recency_, entry.position);
+      std::shared_future<cv::Mat> matrix = entry.matrix;
+      lock.unlock();
+      return Image(matrix.get());
+    }
+    Erase(found);
+  }
+  // 2:
+  std::promise<cv::Mat> promise;
+  Entry entry;
+  entry.modification_time = ModificationTime(file_stat);
+  entry.file_size = file_stat.st_size;
+  entry.id = next_id_++;
+  entry.matrix = promise.get_future().share();
+  recency_.push_front(filename);
+  entry.position = recency_.begin();
+  uint64_t id = entry.id;
+  entries_.insert(std::make_pair(filename, entry));
+  num_of_decodes_++;
+  lock.unlock();
+  // 3:
+  cv::Mat matrix;
+  try {
+    matrix = cv::imread(filename, CV_LOAD_IMAGE_COLOR);
+  } catch (const cv::Exception &error) {
+    // a broken file is a file which cannot be read, see below
+  }
+  lock.lock();
+  found = entries_.find(filename);
+  bool kept = (found != entries_.end()) && (found->second.id == id);
+  if (matrix.data == NULL) {
+    if (kept) Erase(found);
+    promise.set_exception(std::make_exception_ptr(ReadError(filename)));
+    throw ReadError(filename);
+  }
+  promise.set_value(matrix);
+  size_t bytes = matrix.total() * matrix.elemSize();
+  if (kept && (bytes > capacity_bytes_)) {
+    Erase(found);  // before it could evict the others
+  } else if (kept) {
+    found->second.bytes = bytes;
+    size_bytes_ += found->second.bytes;
+    while ((size_bytes_ > capacity_bytes_) && !recency_.empty()) {
+      Erase(entries_.find(recency_.back()));
+    }
+  }
+  return Image(matrix);
+}
+
+size_t DecodedImageCache::size_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_bytes_;
+}
+
+int DecodedImageCache::num_of_decodes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_of_decodes_;
+}
+// The threads waiting for an entry which is being decoded hold their own copy
+// of its future, so it can be erased at any time.
+void DecodedImageCache::Erase(
+    std::unordered_map<std::string, Entry>::iterator entry) {
+  assert(entry != entries_.end());
+  size_bytes_ -= entry->second.bytes;
+  recency_.erase(entry->second.position);
+  entries_.erase(entry);
+}
+
+ImageSource::ImageSource(const std::string &filename,
+                         DecodedImageCache *cache):
+  filename_(filename),
+  cache_(cache) {}
+
+void ImageSource::Prefetch() {
+  Start(std::launch::async);
+}
+// A deferred decoding runs in the first thread which waits for it:
+const Image& ImageSource::image() {
+  Start(std::launch::deferred);
+  return image_.get();
+}
+
+void ImageSource::Start(const std::launch &policy) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (image_.valid()) return;
+  image_ = std::async(policy, [this]() { return Decode(); }).share();
+}
+
+Image ImageSource::Decode() const {
+  if (cache_ != nullptr) return cache_->Get(filename_);
+  return Image(filename_);
+}
+}  // namespace object_clustering
@@ -0,0 +1,148 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// incremental_cluster_algorithm.cc
+// Object Clustering
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "incremental_cluster_algorithm.h"
+
+namespace object_clustering {
+IncrementalClusterAlgorithm::IncrementalClusterAlgorithm(
+    const KMeansClusteringAlgorithm &trainer):
+  trainer_(trainer),
+  model_(std::make_shared<const ClusterModel>()),
+  latest_features_(kDriftWindow, kNumberOfFeatures) {
+  set_name("incremental");
+}
+// 1. Extract the features, outside the lock;
+// 2. if there is no model yet, train it on these objects, or wait for the
+// thread which is training it;
+// 3. label the objects by the model, outside the lock;
+// 4. keep the features and the distances, and train again if the objects
+// drifted. The distances to a model which was replaced meanwhile do not
+// count.
+int IncrementalClusterAlgorithm::AssignGroupsToObjects(
+    std::vector<Object> *objects) const {
+  assert(objects != nullptr);
+  if (objects->empty()) return 0;
+  int num_of_objects = static_cast<int>(objects->size());
+  // 1:
+  FeatureMatrix features(num_of_objects, kNumberOfFeatures);
+  ExtractFeatures(*objects, &features);
+  // 2:
+  std::unique_lock<std::mutex> lock(mutex_);
+  bool recorded = false;
+  while (model_->empty()) {
+    if (training_) {
+      trained_.wait(lock);
+    } else {
+      for (int i = 0; i < num_of_objects; i++) {
+        RecordFeatures(features.row(i));
+      }
+      recorded = true;
+      Retrain(&lock);
+    }
+  }
+  std::shared_ptr<const ClusterModel> model = model_;
+  lock.unlock();
+  // 3:
+  std::vector<float> distances(num_of_objects);
+  FeatureVector object_features;
+  for (int i = 0; i < num_of_objects; i++) {
+    const float *row = features.row(i);
+    std::copy(row, row + kNumberOfFeatures, object_features.begin());
+    (*objects)[i].set_group(model->Assign(object_features, &distances[i]));
+  }
+  // 4:
+  lock.lock();
+  for (int i = 0; i < num_of_objects; i++) {
+    if (!recorded) RecordFeatures(features.row(i));
+    if (model == model_) AddDistance(distances[i]);
+  }
+  if (!training_ && (DriftLocked() > drift_threshold_)) Retrain(&lock);
+  return model->num_of_clusters();
+}
+
+ClusterModel IncrementalClusterAlgorithm::model() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return *model_;
+}
+
+void IncrementalClusterAlgorithm::set_model(const ClusterModel &model) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  model_ = std::make_shared<const ClusterModel>(model);
+  recent_error_ = 0;
+  num_of_recent_objects_ = 0;
+  trained_.notify_all();
+}
+
+float IncrementalClusterAlgorithm::drift() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return DriftLocked();
+}
+
+int IncrementalClusterAlgorithm::num_of_trainings() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_of_trainings_;
+}
+// The other threads keep labeling by the old model while the new one is
+// trained; an error leaves the old model in place.
+void IncrementalClusterAlgorithm::Retrain(
+    std::unique_lock<std::mutex> *lock) const {
+  assert(lock != nullptr);
+  assert(!training_);
+  training_ = true;
+  FeatureMatrix features(num_of_latest_, kNumberOfFeatures);
+  for (int i = 0; i < num_of_latest_; i++) {
+    std::copy(latest_features_.row(i),
+              latest_features_.row(i) + latest_features_.stride(),
+              features.row(i));
+  }
+  std::shared_ptr<const ClusterModel> previous = model_;
+  lock->unlock();
+  ClusterModel model;
+  try {
+    trainer_.TrainModel(features, &model);
+    model.AlignTo(*previous);
+  } catch (...) {
+    lock->lock();
+    training_ = false;
+    trained_.notify_all();
+    throw;
+  }
+  lock->lock();
+  model_ = std::make_shared<const ClusterModel>(std::move(model));
+  recent_error_ = 0;
+  num_of_recent_objects_ = 0;
+  training_ = false;
+  num_of_trainings_++;
+  trained_.notify_all();
+}
+
+void IncrementalClusterAlgorithm::RecordFeatures(const float *features) const {
+  assert(features != nullptr);
+  std::copy(features, features + latest_features_.stride(),
+            latest_features_.row(next_latest_));
+  next_latest_ = (next_latest_ + 1) % kDriftWindow;
+  num_of_latest_ = std::min(num_of_latest_ + 1, kDriftWindow);
+}
+// The mean of the first kDriftWindow distances, then a moving average over
+// about as many.
+void IncrementalClusterAlgorithm::AddDistance(const float &distance) const {
+  if (num_of_recent_objects_ < kDriftWindow) num_of_recent_objects_++;
+  recent_error_ += (distance - recent_error_) / num_of_recent_objects_;
+}
+
+float IncrementalClusterAlgorithm::DriftLocked() const {
+  if (model_->empty() || (num_of_recent_objects_ < kMinDriftObjects)) {
+    return 0;
+  }
+  return static_cast<float>(recent_error_) /
+         std::max(model_->training_error(), kMinTrainingError);
+}
+}  // namespace object_clustering
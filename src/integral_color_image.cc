@@ -0,0 +1,58 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// integral_color_image.cc
+// Object Clustering
+
+#include <cassert>
+#include <climits>
+
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include "integral_color_image.h"
+
+namespace object_clustering {
+namespace {
+// The sum of rect of the table sums, whose elements are Vector:
+template <typename Vector>
+cv::Scalar SumOfTable(const cv::Mat &sums, const cv::Rect &rect) {
+  const Vector &top_left = sums.at<Vector>(rect.y, rect.x);
+  const Vector &top_right = sums.at<Vector>(rect.y, rect.x + rect.width);
+  const Vector &bottom_left = sums.at<Vector>(rect.y + rect.height, rect.x);
+  const Vector &bottom_right = sums.at<Vector>(rect.y + rect.height,
+                                               rect.x + rect.width);
+  cv::Scalar sum;
+  for (int channel = 0; channel < 3; channel++) {
+    sum[channel] = static_cast<double>(bottom_right[channel]) -
+                   top_right[channel] - bottom_left[channel] +
+                   top_left[channel];
+  }
+  return sum;
+}
+}  // namespace
+// An int holds the sum of the whole region, as long as every pixel fits into
+// a byte and the region has no more than INT_MAX / 255 pixels.
+IntegralColorImage::IntegralColorImage(const cv::Mat &frame,
+                                       const cv::Rect &region):
+    region_(region) {
+  assert(frame.type() == CV_8UC3);
+  assert((region & cv::Rect(0, 0, frame.cols, frame.rows)) == region);
+  int depth = region.area() <= INT_MAX / 255 ? CV_32S : CV_64F;
+  cv::integral(cv::Mat(frame, region), sums_, depth);
+}
+
+cv::Scalar IntegralColorImage::Sum(const cv::Rect &rect) const {
+  assert(Contains(rect));
+  // the table starts with a row and a column of zeros:
+  cv::Rect table_rect(rect.x - region_.x, rect.y - region_.y,
+                      rect.width, rect.height);
+  if (sums_.depth() == CV_32S) {
+    return SumOfTable<cv::Vec3i>(sums_, table_rect);
+  }
+  return SumOfTable<cv::Vec3d>(sums_, table_rect);
+}
+
+cv::Scalar IntegralColorImage::Mean(const cv::Rect &rect) const {
+  if (rect.area() == 0) return cv::Scalar();
+  cv::Scalar sum = Sum(rect);
+  return sum * (1. / rect.area());
+}
+}  // namespace object_clustering
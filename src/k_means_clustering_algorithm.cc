@@ -4,97 +4,46 @@
 
 #include <cassert>
 #include <cfloat>
+#include <cmath>
 #include <cstdlib>
 #include <ctime>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "opencv2/highgui/highgui.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
 
+#include "cluster_metrics.h"
 #include "k_means_clustering_algorithm.h"
 #include "gui_functions.h"
 
 namespace object_clustering {
-// Here are the features taken into consideration by clustering algorithm:
-//    // Features:
-//    // matrix.cols;
-//    // matrix.rows;
-// each mean color has 3 components:
-//    // mean[0];
-//    // mean[1];
-//    // mean[2];
-// 6 such "means" are taken into consideration:
-// 1. the whole image;
-// 2. the center of the image;
-// 3,4,5,6. the corresponding subimages.
-// abs(matrix.cols - matrix.rows);
-// matrix.cols*matrix.cols;
+// The features taken into consideration by the clustering algorithm are the
+// ObjectFeatures, see feature_descriptor.h.
 
 int KMeansClusteringAlgorithm:: AssignGroupsToObjects(
     std::vector<Object> *objects) const {
   assert(objects != nullptr);
-  assert(objects->size() > 0);
+  // a frame without objects has no groups:
+  if (objects->empty()) return 0;
   // create the training set; extract the features:
   auto training_set = AssignFeaturesFromObjects(*objects);
   // perform the clustering:
   return KMeansClusteringOpenCVImplementation(training_set, objects);
 }
 
-std::vector<cv::Scalar> KMeansClusteringAlgorithm:: ColorFeaturesFromImage(
-    const Image &image) const {
-  cv::Mat matrix = image.matrix();
-  std::vector<cv::Scalar> result;
-  // the main color:
-  result.push_back(mean(matrix));
-
-  // the color of the center of the image:
-  int x = matrix.cols * 0.2;
-  int y = matrix.rows * 0.2;
-  int width = matrix.cols - 2*x > 0 ? matrix.cols - 2*x : 1;
-  int height = matrix.rows - 2*y > 0 ? matrix.rows - 2*y : 1;
-  assert((x > 0) && (y > 0) && (width > 0) && (height > 0));
-  cv::Mat inside_mat(matrix, cv::Rect(x, y, width, height));
-  result.push_back(mean(inside_mat));
-  // 4 subregions:
-  width = matrix.cols;
-  height = matrix.rows;
-  cv::Mat m1(matrix, cv::Rect(0, 0, width/2, height/2));
-  cv::Mat m2(matrix, cv::Rect(width/2, 0, width/2, height/2));
-  cv::Mat m3(matrix, cv::Rect(0, height/2, width/2, height/2));
-  cv::Mat m4(matrix, cv::Rect(width/2, height/2, width/2, height/2));
-  result.push_back(mean(m1));
-  result.push_back(mean(m2));
-  result.push_back(mean(m3));
-  result.push_back(mean(m4));
-
-  return result;
-}
 // We just form a training_set of values gathered from the data contained in
 // each object. These values are later normalized, so that each feature has the
 // same weight.
-std::vector<std::vector<float>> KMeansClusteringAlgorithm::
-AssignFeaturesFromObjects(const std::vector<Object> &objects) const {
+FeatureMatrix KMeansClusteringAlgorithm:: AssignFeaturesFromObjects(
+    const std::vector<Object> &objects) const {
   assert(objects.size() > 0);
   int num_of_training_examples = static_cast<int>(objects.size());
-  std::vector<std::vector<float>> training_set(num_of_training_examples);
-  // Extract features:
-  for (int i = 0; i < num_of_training_examples; i++) {
-    Image image = objects[i].image();
-    cv::Mat matrix = image.matrix();
-
-    training_set[i].push_back(matrix.cols);  // width
-    training_set[i].push_back(matrix.rows);  // height
-
-    auto colors = ColorFeaturesFromImage(image);
-    for (auto color : colors) {
-      training_set[i].push_back(color[0]);  // avg blue
-      training_set[i].push_back(color[1]);  // avg green
-      training_set[i].push_back(color[2]);  // avg red
-    }
-
-    // how "square" is the image:
-    training_set[i].push_back(abs(matrix.cols - matrix.rows));
-    training_set[i].push_back(matrix.cols*matrix.cols);  // how big is the image
-  }
+  FeatureMatrix training_set(num_of_training_examples, kNumberOfFeatures);
+  // Extract features, straight into the rows:
+  ExtractFeatures(objects, &training_set);
 
   NormalizeFeatures(&training_set);
 
@@ -106,68 +55,146 @@ AssignFeaturesFromObjects(const std::vector<Object> &objects) const {
 // from its value and divide by max value. In such a way we get a value
 // between (-1; 1)
 void KMeansClusteringAlgorithm:: NormalizeFeatures(
-    std::vector<std::vector<float>> *training_set) const {
+    FeatureMatrix *training_set) const {
   assert(training_set != nullptr);
-  assert(training_set->size() > 0);
-  int num_of_training_examples = static_cast<int>(training_set->size());
+  assert(!training_set->empty());
+  FeatureVector max_feature_value;
+  FeatureVector avg_feature_value;
+  ComputeNormalization(*training_set, &max_feature_value, &avg_feature_value);
+  // Normalize features using max and avg feature values:
+  for (int i = 0; i < training_set->rows(); i++) {
+    NormalizeExample(max_feature_value, avg_feature_value,
+                     training_set->row(i));
+  }
+}
+
+void KMeansClusteringAlgorithm:: ComputeNormalization(
+    const FeatureMatrix &training_set,
+    FeatureVector *max_feature_value,
+    FeatureVector *avg_feature_value) const {
+  assert(!training_set.empty());
+  assert(max_feature_value != nullptr);
+  assert(avg_feature_value != nullptr);
+  int num_of_training_examples = training_set.rows();
   // Compute the avg and max:
   // For normalization and feature scaling:
-  std::vector<float> max_feature_value(kNumberOfFeatures, -FLT_MAX);
-  std::vector<float> avg_feature_value(kNumberOfFeatures, 0);
+  max_feature_value->fill(-FLT_MAX);
+  avg_feature_value->fill(0);
 
   for (int i = 0; i < num_of_training_examples; i++) {
     // Find max and avg feature values:
+    const float *features = training_set.row(i);
     for (int j = 0; j < kNumberOfFeatures; j++) {
-      if (max_feature_value[j] < (*training_set)[i][j]) {
-        max_feature_value[j] = (*training_set)[i][j];
+      if ((*max_feature_value)[j] < features[j]) {
+        (*max_feature_value)[j] = features[j];
       }
-      avg_feature_value[j] += (*training_set)[i][j];
+      (*avg_feature_value)[j] += features[j];
     }
   }
-  for (auto& element : avg_feature_value) {
+  for (auto& element : *avg_feature_value) {
     element /= static_cast<float>(num_of_training_examples);
   }
-  // Normalize features using max and avg feature values:
-  for (int i = 0; i < num_of_training_examples; i++) {
-    for (int j = 0; j < kNumberOfFeatures; j++) {
-      if (max_feature_value[j] == 0) {
-        (*training_set)[i][j] = 0.99;
-      } else {
-        (*training_set)[i][j] =
-        ((*training_set)[i][j] - avg_feature_value[j]) /
-                                 max_feature_value[j];
-      }
+}
 
-      // This should not happen:
-      assert(((*training_set)[i][j] > -1) && ((*training_set)[i][j] < 1));
-    }
+void KMeansClusteringAlgorithm:: NormalizeExample(
+    const FeatureVector &max_feature_value,
+    const FeatureVector &avg_feature_value,
+    float *features) {
+  NormalizeFeatureRow(max_feature_value, avg_feature_value, features);
+  for (int j = 0; j < kNumberOfFeatures; j++) {
+    // This should not happen:
+    assert((features[j] > -1) && (features[j] < 1));
   }
 }
+
+int KMeansClusteringAlgorithm:: TrainModel(
+    const std::vector<Object> &objects,
+    ClusterModel *model) const {
+  assert(model != nullptr);
+  if (objects.empty()) {
+    *model = ClusterModel();
+    return 0;
+  }
+  FeatureMatrix features(static_cast<int>(objects.size()), kNumberOfFeatures);
+  ExtractFeatures(objects, &features);
+  return TrainModel(features, model);
+}
+// Normalizes the features, as AssignGroupsToObjects(..) does, and trains the
+// model on them.
+int KMeansClusteringAlgorithm:: TrainModel(
+    const FeatureMatrix &features,
+    ClusterModel *model) const {
+  assert(model != nullptr);
+  if (features.empty()) {
+    *model = ClusterModel();
+    return 0;
+  }
+  assert(features.cols() == kNumberOfFeatures);
+  FeatureMatrix training_set = features;
+  FeatureVector max_feature_value;
+  FeatureVector avg_feature_value;
+  ComputeNormalization(training_set, &max_feature_value, &avg_feature_value);
+  for (int i = 0; i < training_set.rows(); i++) {
+    NormalizeExample(max_feature_value, avg_feature_value,
+                     training_set.row(i));
+  }
+  return TrainNormalizedModel(training_set, max_feature_value,
+                              avg_feature_value, model);
+}
+// 1. Search the clusters;
+// 2. keep the normalization, the centers and the mean distance from the
+// examples to their centers, against which the drift is measured.
+int KMeansClusteringAlgorithm:: TrainNormalizedModel(
+    const FeatureMatrix &training_set,
+    const FeatureVector &max_feature_value,
+    const FeatureVector &avg_feature_value,
+    ClusterModel *model) const {
+  assert(!training_set.empty());
+  assert(model != nullptr);
+  // 1:
+  std::vector<int> labels;
+  FeatureMatrix centers;
+  int num_of_clusters = ClusterTrainingSet(training_set, &labels, &centers);
+  // 2:
+  double training_error = 0;
+  for (int i = 0; i < training_set.rows(); i++) {
+    training_error += std::sqrt(SquaredDistance(training_set.row(i),
+                                                centers.row(labels[i]),
+                                                training_set.stride()));
+  }
+  training_error /= training_set.rows();
+  *model = ClusterModel(max_feature_value, avg_feature_value, centers,
+                        static_cast<float>(training_error));
+  return num_of_clusters;
+}
 // We compute the error using the Euclidean distance formula - the difference
-// between the exemples assigned to a centroid and the centroid itself.
+// between the exemples assigned to a centroid and the centroid itself. It is
+// the mean distance, not the compactness cv::kmeans(..) returns (the sum of
+// the squared distances), and the Elbow method depends on it.
 float KMeansClusteringAlgorithm:: ComputeError(
     const std::vector<int> &clusters,
-    const std::vector<std::vector<float>> &training_set,
-    const std::vector<std::vector<float>> &centroids,
-    const int &n,  // num_of_training_examples
-    const int &K) const {  // K - num_of_clusters
-  assert(n >= 0);
-  assert(K >= 0);
+    const FeatureMatrix &training_set,
+    const FeatureMatrix &centroids) const {
   assert(clusters.size() > 0);
-  assert(training_set.size() > 0);
-  assert(centroids.size() > 0);
+  assert(!training_set.empty());
+  assert(!centroids.empty());
+  int n = training_set.rows();  // num_of_training_examples
+  int K = centroids.rows();  // num_of_clusters
   float error = 0;
+  // every example contributes the distance to its own centroid only. The
+  // distance is computed by cv::norm(..), as it always was, so that the Elbow
+  // method takes exactly the same decisions:
+  float difference[kNumberOfFeatures];
+  cv::Mat difference_header(1, kNumberOfFeatures, CV_32FC1, difference);
   for (int i = 0 ; i < n; i++) {
-    for (int j = 0; j < K; j++) {
-      if (clusters[i] == j) {
-        std::vector<float> v;
-        for (int l = 0; l < kNumberOfFeatures; l++) {
-          float a = training_set[i][l] - centroids[j][l];
-          v.push_back(a);
-        }
-        error += cv::norm(v);
-      }
+    int j = clusters[i];
+    assert((j >= 0) && (j < K));
+    const float *example = training_set.row(i);
+    const float *centroid = centroids.row(j);
+    for (int l = 0; l < kNumberOfFeatures; l++) {
+      difference[l] = example[l] - centroid[l];
     }
+    error += cv::norm(difference_header);
   }
   error /= n;
   assert(error >= 0);
@@ -175,26 +202,34 @@ float KMeansClusteringAlgorithm:: ComputeError(
 }
 
 int KMeansClusteringAlgorithm:: KMeansClusteringOpenCVImplementation(
-    const std::vector<std::vector<float>> &training_set,
+    const FeatureMatrix &training_set,
     std::vector<Object> *objects) const {
-  assert(training_set.size() > 0);
+  assert(!training_set.empty());
   assert(objects != nullptr);
-  assert(objects->size() > 0);
+  assert(static_cast<int>(objects->size()) == training_set.rows());
+  std::vector<int> best_labeling;
+  FeatureMatrix best_centers;
+  int resulting_num_of_clusters = ClusterTrainingSet(training_set,
+                                                     &best_labeling,
+                                                     &best_centers);
+  // Label the objects:
+  LabelObjects(best_labeling, objects);
+
+  return resulting_num_of_clusters;
+}
+
+int KMeansClusteringAlgorithm:: ClusterTrainingSet(
+    const FeatureMatrix &training_set,
+    std::vector<int> *best_labeling,
+    FeatureMatrix *best_centers) const {
+  assert(!training_set.empty());
+  assert(best_labeling != nullptr);
+  assert(best_centers != nullptr);
   // 1. Prepare the data:
-  int num_of_training_examples = static_cast<int>(objects->size());
-  std::vector<int> best_labeling(num_of_training_examples);
-  // the computed error cannot be negative. this assignment is to show that
-  // there is no previous_error:
-  float previous_error = -1;
-  float previous_error_ratio = 1;
+  int num_of_training_examples = training_set.rows();
+  best_labeling->resize(num_of_training_examples);
+  KSearchState state;
   int resulting_num_of_clusters = 1;
-  // 1.2 Create an input matrix of data for kmeans() function:
-  cv::Mat data(num_of_training_examples, kNumberOfFeatures, CV_32FC1);
-  for (int i = 0; i < num_of_training_examples; i++) {
-    for (int j = 0; j < kNumberOfFeatures; j++) {
-      data.at<float>(i, j) = training_set[i][j];
-    }
-  }
 
   // 2. We iteratively try to group objects in different number of groups.
   // By Elbow method, the error decreases as the number of clusters increases.
@@ -205,79 +240,295 @@ int KMeansClusteringAlgorithm:: KMeansClusteringOpenCVImplementation(
   // number of clusters, that is why Elbow method is used.
   // So we iteratively run kmeans, compute the error, compare it with
   // previous_error and decide whether to stop.
+  // At most max_k_ clusters are tried:
+  int max_num_of_clusters = num_of_training_examples;
+  if ((max_k_ != kUnboundedNumberOfClusters) &&
+      (max_k_ < max_num_of_clusters)) {
+    max_num_of_clusters = max_k_;
+  }
+  FeatureMatrix previous_centers;
+  // kParallelKSearch runs K-Means for a window of K values ahead of the
+  // decisions below:
+  std::vector<KCandidate> window;
+  int window_start = 1;
   for (int num_of_clusters = 1;
-       num_of_clusters <= num_of_training_examples;
+       num_of_clusters <= max_num_of_clusters;
        num_of_clusters++) {
-    // 2.1 Some setup before we run kmeans:
-    cv::Mat labels;
-    cv::TermCriteria criteria =
-    cv::TermCriteria(CV_TERMCRIT_EPS+CV_TERMCRIT_ITER, 10, 1.0);
-    int attempts = kNumberOfIterationsPerOneRun;
-    int flags = cv::KMEANS_PP_CENTERS;
-    cv::Mat centers(num_of_clusters, 1, data.type());
-    // 2.2 OpenCV kmeans: finds centers of clusters and groups the input samples
-    // around the clusters.
-    cv::kmeans(data,
-               num_of_clusters,
-               labels,
-               criteria,
-               attempts,
-               flags,
-               centers);
-    if (num_of_training_examples == 1) {
-      assert(labels.at<int>(0) == 0);
-      // Strange enough, when there is just one object,
-      // the group assigned to it is 8;
-      // Let's correct that:
-      // labels.at<int>(0) = 0;
-    }
-    // 2.3 Copy the output labels into a vector:
-    std::vector<int> clusters(num_of_training_examples);
-
-    for (int i = 0; i < num_of_training_examples; i++) {
-      clusters[i] = labels.at<int>(i);
-    }
-    // 2.4 Similar here:
-    std::vector<std::vector<float>> centroids(num_of_clusters);
-    for (int i = 0; i < num_of_clusters; i++) {
-      centroids[i] = std::vector<float>(kNumberOfFeatures);
-      for (int j = 0; j < kNumberOfFeatures; j++) {
-        centroids[i][j] = centers.at<float>(i, j);
+    // 2.1, 2.2 K-Means: finds centers of clusters and groups the input samples
+    // around the clusters, see RunKMeans(..):
+    KCandidate candidate;
+    if (k_search_mode_ == kParallelKSearch) {
+      if (num_of_clusters - window_start >= static_cast<int>(window.size())) {
+        window_start = num_of_clusters;
+        RunKWindow(training_set,
+                   num_of_clusters,
+                   std::min(num_of_clusters + k_window_ - 1,
+                            max_num_of_clusters),
+                   &window);
       }
+      candidate = std::move(window[num_of_clusters - window_start]);
+    } else {
+      candidate.compactness = RunKMeans(training_set,
+                                        num_of_clusters,
+                                        previous_centers,
+                                        &candidate.labels,
+                                        &candidate.centers);
     }
-    // 2.5 Compute error and check if it is time to stop:
-    float error = ComputeError(clusters,
-                               training_set,
-                               centroids,
-                               num_of_training_examples,
-                               num_of_clusters);
-
-    if (error == 0) {
+    if (num_of_training_examples == 1) {
+      assert(candidate.labels[0] == 0);
+    }
+    // 2.5 Check if it is time to stop:
+    bool perfect;
+    bool better = IsBetterClustering(candidate, training_set, &state,
+                                     &perfect);
+    if (better) {
       resulting_num_of_clusters = num_of_clusters;
       for (int i = 0; i < num_of_training_examples; i++) {
-        best_labeling[i] = labels.at<int>(i);
+        (*best_labeling)[i] = candidate.labels[i];
       }
-
-      break;
+      *best_centers = candidate.centers;
     }
+    if (perfect || !better) break;
+    previous_centers = std::move(candidate.centers);
+  }
+  return resulting_num_of_clusters;
+}
+// A zero compactness means every example sits on its centroid, which cannot
+// be improved.
+bool KMeansClusteringAlgorithm:: IsBetterClustering(
+    const KCandidate &candidate,
+    const FeatureMatrix &training_set,
+    KSearchState *state,
+    bool *perfect) const {
+  assert(state != nullptr);
+  assert(perfect != nullptr);
+  int num_of_clusters = candidate.centers.rows();
+  *perfect = candidate.compactness == 0;
+  if (*perfect) return true;
+  if ((k_selection_criterion_ == kMeanDistanceCriterion) ||
+      (k_selection_criterion_ == kInertiaCriterion)) {
+    float error = ElbowError(candidate.labels, training_set, candidate.centers,
+                             candidate.compactness);
+    *perfect = error == 0;
+    if (*perfect) return true;
     // if this is the first time:
-    if (previous_error < 0) previous_error = error;
+    if (state->previous_error < 0) state->previous_error = error;
     // "Elbow" method: the error is going down slowly:
-    if (previous_error_ratio > previous_error/error) {
-      break;
-    } else {
-      resulting_num_of_clusters = num_of_clusters;
-      previous_error_ratio = previous_error/error;
-      for (int i = 0; i < num_of_training_examples; i++) {
-        best_labeling[i] = labels.at<int>(i);
-      }
+    float ratio = state->previous_error / error;
+    bool better = !(state->previous_error_ratio > ratio);
+    if (better) state->previous_error_ratio = ratio;
+    state->previous_error = error;
+    return better;
+  }
+  // a single cluster is only kept if there is nothing else to try:
+  if (num_of_clusters == 1) return true;
+  double score = ClusteringScore(candidate.labels, training_set,
+                                 candidate.centers);
+  bool better = score > state->best_score;
+  state->best_score = score;
+  return better;
+}
+// The attempts are independent tasks, so a pool of 32 threads keeps busy with
+// a window of 4 values of K. Each attempt has its own seed and the best one is
+// chosen in the order of the attempts, so the order in which they finish does
+// not matter.
+void KMeansClusteringAlgorithm:: RunKWindow(
+    const FeatureMatrix &training_set,
+    const int &first_k,
+    const int &last_k,
+    std::vector<KCandidate> *window) const {
+  assert(window != nullptr);
+  assert((first_k > 0) && (first_k <= last_k));
+  int num_of_ks = last_k - first_k + 1;
+  int attempts = kNumberOfIterationsPerOneRun;
+  std::vector<KCandidate> results(num_of_ks * attempts);
+  auto run_attempt = [&](int task) {
+    int num_of_clusters = first_k + task / attempts;
+    int attempt = task % attempts;
+    uint64_t seed = kParallelKSearchSeed +
+                    static_cast<uint64_t>(num_of_clusters) * attempts + attempt;
+    KCandidate &result = results[task];
+    result.compactness = RunKMeansAttempt(training_set,
+                                          num_of_clusters,
+                                          seed,
+                                          &result.labels,
+                                          &result.centers);
+  };
+  int num_of_tasks = static_cast<int>(results.size());
+  // without a pool, the window runs on this thread rather than starting and
+  // joining a pool of threads for every window:
+  if (pool_) {
+    pool_->ParallelFor(0, num_of_tasks, run_attempt);
+  } else {
+    for (int task = 0; task < num_of_tasks; task++) run_attempt(task);
+  }
+  window->resize(num_of_ks);
+  for (int k = 0; k < num_of_ks; k++) {
+    int best = k * attempts;
+    for (int task = best + 1; task < (k + 1) * attempts; task++) {
+      if (results[task].compactness < results[best].compactness) best = task;
     }
-    previous_error = error;
+    (*window)[k] = std::move(results[best]);
   }
-  // 2.6 Label the objects:
-  LabelObjects(best_labeling, objects);
+}
 
-  return resulting_num_of_clusters;
+float KMeansClusteringAlgorithm:: ElbowError(
+    const std::vector<int> &clusters,
+    const FeatureMatrix &training_set,
+    const FeatureMatrix &centroids,
+    const double &compactness) const {
+  if (k_selection_criterion_ == kInertiaCriterion) return compactness;
+  return ComputeError(clusters, training_set, centroids);
+}
+
+double KMeansClusteringAlgorithm:: ClusteringScore(
+    const std::vector<int> &clusters,
+    const FeatureMatrix &training_set,
+    const FeatureMatrix &centroids) const {
+  bool silhouette = k_selection_criterion_ == kSilhouetteCriterion;
+  ClusterMetrics metrics;
+  ComputeClusterMetrics(training_set,
+                        clusters,
+                        centroids,
+                        silhouette ? kSilhouetteSampleSize : 0,
+                        &metrics);
+  return silhouette ? metrics.silhouette : -metrics.davies_bouldin;
+}
+
+double KMeansClusteringAlgorithm:: RunKMeans(
+    const FeatureMatrix &data,
+    const int &num_of_clusters,
+    const FeatureMatrix &previous_centers,
+    std::vector<int> *labels,
+    FeatureMatrix *centers) const {
+  assert(labels != nullptr);
+  assert(centers != nullptr);
+  assert(num_of_clusters > 0);
+  cv::TermCriteria criteria =
+  cv::TermCriteria(CV_TERMCRIT_EPS+CV_TERMCRIT_ITER, 10, 1.0);
+  // cv::kmeans(..) reads the rows through the header, without a copy:
+  cv::Mat data_header = data.matrix();
+  cv::Mat label_matrix;
+  cv::Mat center_matrix;
+  double compactness = 0;
+  if (k_search_mode_ == kWarmStartedKSearch) {
+    SeedLabelsFromCenters(data, previous_centers, labels);
+    label_matrix = cv::Mat(*labels, true);
+    compactness = cv::kmeans(data_header,
+                             num_of_clusters,
+                             label_matrix,
+                             criteria,
+                             1,
+                             cv::KMEANS_USE_INITIAL_LABELS,
+                             center_matrix);
+  } else {
+    int attempts = kNumberOfIterationsPerOneRun;
+    int flags = cv::KMEANS_PP_CENTERS;
+    compactness = cv::kmeans(data_header,
+                             num_of_clusters,
+                             label_matrix,
+                             criteria,
+                             attempts,
+                             flags,
+                             center_matrix);
+  }
+  CopyKMeansResult(label_matrix, center_matrix, data.cols(), labels,
+                   centers);
+  return compactness;
+}
+// cv::kmeans(..) draws the k-means++ centers from cv::theRNG(), which every
+// thread has its own copy of; it is reseeded before the call.
+double KMeansClusteringAlgorithm:: RunKMeansAttempt(
+    const FeatureMatrix &data,
+    const int &num_of_clusters,
+    const uint64_t &seed,
+    std::vector<int> *labels,
+    FeatureMatrix *centers) const {
+  assert(labels != nullptr);
+  assert(centers != nullptr);
+  assert(num_of_clusters > 0);
+  cv::TermCriteria criteria =
+  cv::TermCriteria(CV_TERMCRIT_EPS+CV_TERMCRIT_ITER, 10, 1.0);
+  cv::Mat label_matrix;
+  cv::Mat center_matrix;
+  cv::theRNG() = cv::RNG(seed);
+  double compactness = cv::kmeans(data.matrix(),
+                                  num_of_clusters,
+                                  label_matrix,
+                                  criteria,
+                                  1,
+                                  cv::KMEANS_PP_CENTERS,
+                                  center_matrix);
+  CopyKMeansResult(label_matrix, center_matrix, data.cols(), labels,
+                   centers);
+  return compactness;
+}
+
+void KMeansClusteringAlgorithm:: CopyKMeansResult(
+    const cv::Mat &label_matrix,
+    const cv::Mat &center_matrix,
+    const int &num_of_columns,
+    std::vector<int> *labels,
+    FeatureMatrix *centers) const {
+  assert(labels != nullptr);
+  assert(centers != nullptr);
+  labels->resize(label_matrix.rows);
+  for (int i = 0; i < label_matrix.rows; i++) {
+    (*labels)[i] = label_matrix.at<int>(i);
+  }
+  centers->Create(center_matrix.rows, num_of_columns);
+  for (int i = 0; i < center_matrix.rows; i++) {
+    for (int j = 0; j < num_of_columns; j++) {
+      centers->at(i, j) = center_matrix.at<float>(i, j);
+    }
+  }
+}
+// The K - 1 solution is kept and one center is added where it is needed the
+// most, as k-means++ does, but deterministically: at the example which is the
+// farthest from its nearest center.
+void KMeansClusteringAlgorithm:: SeedCentersFromPrevious(
+    const FeatureMatrix &data,
+    const FeatureMatrix &previous_centers,
+    FeatureMatrix *centers) const {
+  assert(centers != nullptr);
+  assert(!data.empty());
+  assert(previous_centers.empty() ||
+         (previous_centers.stride() == data.stride()));
+  int farthest = 0;
+  float farthest_distance = -1;
+  if (!previous_centers.empty()) {
+    for (int i = 0; i < data.rows(); i++) {
+      float distance;
+      NearestRow(data.row(i), previous_centers, &distance);
+      if (distance > farthest_distance) {
+        farthest_distance = distance;
+        farthest = i;
+      }
+    }
+  }
+  centers->Create(previous_centers.rows() + 1, data.cols());
+  for (int i = 0; i < previous_centers.rows(); i++) {
+    const float *center = previous_centers.row(i);
+    std::copy(center, center + data.stride(), centers->row(i));
+  }
+  const float *new_center = data.row(farthest);
+  std::copy(new_center, new_center + data.stride(),
+            centers->row(previous_centers.rows()));
+}
+// The new center comes last, so the examples as far from it as from their
+// nearest previous center stay with the previous one.
+void KMeansClusteringAlgorithm:: SeedLabelsFromCenters(
+    const FeatureMatrix &data,
+    const FeatureMatrix &previous_centers,
+    std::vector<int> *labels) const {
+  assert(labels != nullptr);
+  FeatureMatrix centers;
+  SeedCentersFromPrevious(data, previous_centers, &centers);
+  labels->resize(data.rows());
+  for (int i = 0; i < data.rows(); i++) {
+    float distance;
+    (*labels)[i] = NearestRow(data.row(i), centers, &distance);
+  }
 }
 
 void KMeansClusteringAlgorithm:: LabelObjects(
@@ -0,0 +1,214 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// mini_batch_k_means_clustering_algorithm.cc
+// Object Clustering
+
+#include <cassert>
+#include <cfloat>
+#include <cstdint>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "mini_batch_k_means_clustering_algorithm.h"
+
+namespace object_clustering {
+double MiniBatchKMeansClusteringAlgorithm:: RunKMeans(
+    const FeatureMatrix &data,
+    const int &num_of_clusters,
+    const FeatureMatrix &previous_centers,
+    std::vector<int> *labels,
+    FeatureMatrix *centers) const {
+  cv::RNG rng(kNativeKMeansSeed);
+  return RunMiniBatch(data, num_of_clusters, previous_centers, &rng, labels,
+                      centers);
+}
+
+double MiniBatchKMeansClusteringAlgorithm:: RunKMeansAttempt(
+    const FeatureMatrix &data,
+    const int &num_of_clusters,
+    const uint64_t &seed,
+    std::vector<int> *labels,
+    FeatureMatrix *centers) const {
+  cv::RNG rng(seed);
+  return RunMiniBatch(data, num_of_clusters, FeatureMatrix(), &rng, labels,
+                      centers);
+}
+// 1. Seed the centers;
+// 2. move them batch by batch until they settle;
+// 3. label every row and sum the compactness.
+double MiniBatchKMeansClusteringAlgorithm:: RunMiniBatch(
+    const FeatureMatrix &data,
+    const int &num_of_clusters,
+    const FeatureMatrix &previous_centers,
+    cv::RNG *rng,
+    std::vector<int> *labels,
+    FeatureMatrix *centers) const {
+  assert(rng != nullptr);
+  assert(labels != nullptr);
+  assert(centers != nullptr);
+  assert((num_of_clusters > 0) && (num_of_clusters <= data.rows()));
+  int n = data.rows();
+  int stride = data.stride();
+  FeatureMatrix batch;
+  // 1:
+  if (k_search_mode() == kWarmStartedKSearch) {
+    assert(previous_centers.rows() == num_of_clusters - 1);
+    SeedCentersFromPrevious(data, previous_centers, centers);
+  } else {
+    // a small data set is its own batch:
+    bool whole_data = n <= batch_size_;
+    if (!whole_data) DrawBatch(data, rng, &batch);
+    const FeatureMatrix &seed_rows = whole_data ? data : batch;
+    Workspace workspace;
+    workspace.distances.resize(seed_rows.rows());
+    SeedCentersPlusPlus(seed_rows, num_of_clusters, rng, &workspace);
+    std::swap(*centers, workspace.centers);
+  }
+  // 2:
+  std::vector<int> counts(num_of_clusters, 0);
+  std::vector<int> batch_labels(batch_size_);
+  FeatureMatrix previous(num_of_clusters, data.cols());
+  for (int iteration = 0; iteration < kMiniBatchMaxIterations; iteration++) {
+    DrawBatch(data, rng, &batch);
+    // all the rows of the batch are assigned to the centers before any of
+    // the centers moves:
+    for (int b = 0; b < batch_size_; b++) {
+      float distance;
+      batch_labels[b] = NearestRow(batch.row(b), *centers, &distance);
+    }
+    std::copy(centers->row(0), centers->row(0) + num_of_clusters * stride,
+              previous.row(0));
+    for (int b = 0; b < batch_size_; b++) {
+      int k = batch_labels[b];
+      counts[k]++;
+      float step = 1.f / counts[k];
+      float *center = centers->row(k);
+      ScaleRow(1 - step, stride, center);
+      AddScaledRow(batch.row(b), step, stride, center);
+    }
+    float max_shift = 0;
+    for (int k = 0; k < num_of_clusters; k++) {
+      max_shift = std::max(max_shift, SquaredDistance(centers->row(k),
+                                                      previous.row(k),
+                                                      stride));
+    }
+    if (max_shift <= tolerance_ * tolerance_) break;
+  }
+  // 3:
+  labels->resize(n);
+  double compactness = 0;
+  for (int i = 0; i < n; i++) {
+    float distance;
+    (*labels)[i] = NearestRow(data.row(i), *centers, &distance);
+    compactness += distance;
+  }
+  return compactness;
+}
+// The rows are drawn with replacement. The batch is only allocated the first
+// time.
+void MiniBatchKMeansClusteringAlgorithm:: DrawBatch(
+    const FeatureMatrix &data,
+    cv::RNG *rng,
+    FeatureMatrix *batch) const {
+  assert(rng != nullptr);
+  assert(batch != nullptr);
+  assert(!data.empty());
+  if ((batch->rows() != batch_size_) || (batch->cols() != data.cols())) {
+    batch->Create(batch_size_, data.cols());
+  }
+  for (int b = 0; b < batch_size_; b++) {
+    const float *row = data.row(rng->uniform(0, data.rows()));
+    std::copy(row, row + data.stride(), batch->row(b));
+  }
+}
+
+int MiniBatchKMeansClusteringAlgorithm:: AssignGroupsToStore(
+    const MappedFeatureStore &store,
+    std::vector<int> *groups) const {
+  assert(store.IsOpened());
+  assert(groups != nullptr);
+  groups->resize(store.num_of_rows());
+  // 1, 2:
+  ClusterModel model;
+  int num_of_groups = TrainModelOnStore(store, &model);
+  if (num_of_groups == 0) return 0;
+  // 3:
+  FeatureMatrix chunk;
+  for (int64_t begin = 0; begin < store.num_of_rows();
+       begin += kFeatureStoreChunkRows) {
+    int num_read = store.ReadChunk(begin, kFeatureStoreChunkRows, &chunk);
+    for (int i = 0; i < num_read; i++) {
+      float *features = chunk.row(i);
+      model.Normalize(features);
+      float distance;
+      (*groups)[begin + i] = NearestRow(features, model.centers(), &distance);
+    }
+  }
+  return num_of_groups;
+}
+// The training error is the one of the sample.
+int MiniBatchKMeansClusteringAlgorithm:: TrainModelOnStore(
+    const MappedFeatureStore &store,
+    ClusterModel *model) const {
+  assert(store.IsOpened());
+  assert(model != nullptr);
+  if (store.num_of_rows() == 0) {
+    *model = ClusterModel();
+    return 0;
+  }
+  FeatureVector max_feature_value;
+  FeatureVector avg_feature_value;
+  FeatureMatrix sample;
+  ScanFeatureStore(store, &max_feature_value, &avg_feature_value, &sample);
+  for (int i = 0; i < sample.rows(); i++) {
+    NormalizeExample(max_feature_value, avg_feature_value, sample.row(i));
+  }
+  return TrainNormalizedModel(sample, max_feature_value, avg_feature_value,
+                              model);
+}
+// The sample is a reservoir: the first rows fill it, then row i replaces a
+// random one of them with probability sample_size_ / (i + 1), so that every
+// row is as likely to be in it. The sums are kept in double, since a store may
+// have far more rows than a float counts exactly.
+void MiniBatchKMeansClusteringAlgorithm:: ScanFeatureStore(
+    const MappedFeatureStore &store,
+    FeatureVector *max_feature_value,
+    FeatureVector *avg_feature_value,
+    FeatureMatrix *sample) const {
+  assert(max_feature_value != nullptr);
+  assert(avg_feature_value != nullptr);
+  assert(sample != nullptr);
+  int64_t n = store.num_of_rows();
+  sample->Create(static_cast<int>(std::min<int64_t>(n, sample_size_)),
+                 kNumberOfFeatures);
+  max_feature_value->fill(-FLT_MAX);
+  double sum_feature_value[kNumberOfFeatures] = {0};
+  cv::RNG rng(kNativeKMeansSeed);
+  FeatureMatrix chunk;
+  for (int64_t begin = 0; begin < n; begin += kFeatureStoreChunkRows) {
+    int num_read = store.ReadChunk(begin, kFeatureStoreChunkRows, &chunk);
+    for (int i = 0; i < num_read; i++) {
+      const float *features = chunk.row(i);
+      for (int j = 0; j < kNumberOfFeatures; j++) {
+        (*max_feature_value)[j] = std::max((*max_feature_value)[j],
+                                           features[j]);
+        sum_feature_value[j] += features[j];
+      }
+      int64_t index = begin + i;
+      if (index >= sample_size_) {
+        uint64_t random = (static_cast<uint64_t>(rng.next()) << 32) |
+                          rng.next();
+        index = static_cast<int64_t>(random %
+                                     static_cast<uint64_t>(index + 1));
+      }
+      if (index < sample->rows()) {
+        std::copy(features, features + chunk.stride(), sample->row(index));
+      }
+    }
+  }
+  for (int j = 0; j < kNumberOfFeatures; j++) {
+    (*avg_feature_value)[j] = static_cast<float>(sum_feature_value[j] / n);
+  }
+}
+}  // namespace object_clustering
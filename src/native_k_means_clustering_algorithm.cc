@@ -0,0 +1,195 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// native_k_means_clustering_algorithm.cc
+// Object Clustering
+
+#include <cassert>
+#include <cfloat>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "native_k_means_clustering_algorithm.h"
+
+namespace object_clustering {
+double NativeKMeansClusteringAlgorithm:: RunKMeans(
+    const FeatureMatrix &data,
+    const int &num_of_clusters,
+    const FeatureMatrix &previous_centers,
+    std::vector<int> *labels,
+    FeatureMatrix *centers) const {
+  assert(labels != nullptr);
+  assert(centers != nullptr);
+  assert((num_of_clusters > 0) && (num_of_clusters <= data.rows()));
+  int n = data.rows();
+  Workspace workspace;
+  CreateWorkspace(data, num_of_clusters, &workspace);
+  bool warm = k_search_mode() == kWarmStartedKSearch;
+  int attempts = warm ? 1 : kNumberOfIterationsPerOneRun;
+  cv::RNG rng(kNativeKMeansSeed);
+  double best_compactness = DBL_MAX;
+  for (int attempt = 0; attempt < attempts; attempt++) {
+    if (warm) {
+      assert(previous_centers.rows() == num_of_clusters - 1);
+      SeedCentersFromPrevious(data, previous_centers, &workspace.centers);
+    } else {
+      SeedCentersPlusPlus(data, num_of_clusters, &rng, &workspace);
+    }
+    double compactness = Lloyd(data, &workspace);
+    if (compactness < best_compactness) {
+      best_compactness = compactness;
+      // the buffers of the previous best are reused by the next attempt:
+      std::swap(*centers, workspace.centers);
+      labels->swap(workspace.labels);
+      workspace.labels.resize(n);
+    }
+  }
+  return best_compactness;
+}
+
+double NativeKMeansClusteringAlgorithm:: RunKMeansAttempt(
+    const FeatureMatrix &data,
+    const int &num_of_clusters,
+    const uint64_t &seed,
+    std::vector<int> *labels,
+    FeatureMatrix *centers) const {
+  assert(labels != nullptr);
+  assert(centers != nullptr);
+  assert((num_of_clusters > 0) && (num_of_clusters <= data.rows()));
+  Workspace workspace;
+  CreateWorkspace(data, num_of_clusters, &workspace);
+  cv::RNG rng(seed);
+  SeedCentersPlusPlus(data, num_of_clusters, &rng, &workspace);
+  double compactness = Lloyd(data, &workspace);
+  std::swap(*centers, workspace.centers);
+  labels->swap(workspace.labels);
+  return compactness;
+}
+
+void NativeKMeansClusteringAlgorithm:: CreateWorkspace(
+    const FeatureMatrix &data,
+    const int &num_of_clusters,
+    Workspace *workspace) const {
+  assert(workspace != nullptr);
+  workspace->sums.Create(num_of_clusters, data.cols());
+  workspace->labels.resize(data.rows());
+  workspace->counts.resize(num_of_clusters);
+  workspace->distances.resize(data.rows());
+}
+// The k-means++ seeding, as cv::kmeans(..) does it with KMEANS_PP_CENTERS,
+// with a single trial for every center.
+void NativeKMeansClusteringAlgorithm:: SeedCentersPlusPlus(
+    const FeatureMatrix &data,
+    const int &num_of_clusters,
+    cv::RNG *rng,
+    Workspace *workspace) const {
+  assert(rng != nullptr);
+  assert(workspace != nullptr);
+  int n = data.rows();
+  int stride = data.stride();
+  FeatureMatrix &centers = workspace->centers;
+  std::vector<float> &distances = workspace->distances;
+  centers.Create(num_of_clusters, data.cols());
+  const float *first = data.row(rng->uniform(0, n));
+  std::copy(first, first + stride, centers.row(0));
+  double sum = 0;
+  for (int i = 0; i < n; i++) {
+    distances[i] = SquaredDistance(data.row(i), centers.row(0), stride);
+    sum += distances[i];
+  }
+  for (int k = 1; k < num_of_clusters; k++) {
+    // the row which makes the sum of the distances pass a random point:
+    double target = rng->uniform(0., 1.) * sum;
+    int chosen = n - 1;
+    for (int i = 0; i < n; i++) {
+      target -= distances[i];
+      if (target <= 0) {
+        chosen = i;
+        break;
+      }
+    }
+    const float *center = data.row(chosen);
+    std::copy(center, center + stride, centers.row(k));
+    sum = 0;
+    for (int i = 0; i < n; i++) {
+      distances[i] = std::min(distances[i],
+                              SquaredDistance(data.row(i), center, stride));
+      sum += distances[i];
+    }
+  }
+}
+// Every iteration:
+// 1. assigns every row to its nearest center;
+// 2. moves every center to the mean of its rows.
+// The last assignment is made with the final centers, so the labels and the
+// compactness describe them.
+double NativeKMeansClusteringAlgorithm:: Lloyd(const FeatureMatrix &data,
+                                               Workspace *workspace) const {
+  assert(workspace != nullptr);
+  int n = data.rows();
+  int stride = data.stride();
+  int num_of_clusters = workspace->centers.rows();
+  std::vector<int> &labels = workspace->labels;
+  std::vector<int> &counts = workspace->counts;
+  std::vector<float> &distances = workspace->distances;
+  double compactness = 0;
+  bool converged = false;
+  for (int iteration = 0; ; iteration++) {
+    // 1:
+    compactness = 0;
+    for (int i = 0; i < n; i++) {
+      labels[i] = NearestRow(data.row(i), workspace->centers, &distances[i]);
+      compactness += distances[i];
+    }
+    if (converged || (iteration == kNativeKMeansMaxIterations)) break;
+    // 2:
+    workspace->sums.SetZero();
+    std::fill(counts.begin(), counts.end(), 0);
+    for (int i = 0; i < n; i++) {
+      AddRow(data.row(i), stride, workspace->sums.row(labels[i]));
+      counts[labels[i]]++;
+    }
+    FillEmptyClusters(data, workspace);
+    float max_shift = 0;
+    for (int k = 0; k < num_of_clusters; k++) {
+      float *center = workspace->sums.row(k);
+      ScaleRow(1.f / counts[k], stride, center);
+      max_shift = std::max(max_shift, SquaredDistance(
+          center, workspace->centers.row(k), stride));
+    }
+    std::swap(workspace->centers, workspace->sums);
+    converged = max_shift <= kNativeKMeansEpsilon * kNativeKMeansEpsilon;
+  }
+  return compactness;
+}
+
+void NativeKMeansClusteringAlgorithm:: FillEmptyClusters(
+    const FeatureMatrix &data,
+    Workspace *workspace) const {
+  assert(workspace != nullptr);
+  int n = data.rows();
+  int stride = data.stride();
+  std::vector<int> &labels = workspace->labels;
+  std::vector<int> &counts = workspace->counts;
+  std::vector<float> &distances = workspace->distances;
+  for (int k = 0; k < workspace->centers.rows(); k++) {
+    if (counts[k] > 0) continue;
+    // there are at least as many rows as clusters, so a donor exists:
+    int farthest = -1;
+    for (int i = 0; i < n; i++) {
+      if ((counts[labels[i]] > 1) &&
+          ((farthest < 0) || (distances[i] > distances[farthest]))) {
+        farthest = i;
+      }
+    }
+    assert(farthest >= 0);
+    int donor = labels[farthest];
+    SubtractRow(data.row(farthest), stride, workspace->sums.row(donor));
+    counts[donor]--;
+    AddRow(data.row(farthest), stride, workspace->sums.row(k));
+    counts[k] = 1;
+    labels[farthest] = k;
+    distances[farthest] = 0;
+  }
+}
+}  // namespace object_clustering
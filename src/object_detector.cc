@@ -2,17 +2,114 @@
 // object_detector.cc
 // Object Clustering
 
+#include <algorithm>
 #include <cassert>
 
+#include <utility>
+
 #include "opencv2/imgproc/imgproc.hpp"
 #include "opencv2/highgui/highgui.hpp"
 #include "opencv2/core/core.hpp"
 #include "opencv2/video/background_segm.hpp"
 #include "opencv2/opencv.hpp"
 
+#include "foreground_kernel.h"
 #include "object_detector.h"
+#include "rect_index.h"
 
 namespace object_clustering {
+namespace {
+// Finds the contours of the binary image of gray for threshold, in the
+// buffers given.
+void FindContoursAtThreshold(
+    const cv::Mat &gray,
+    const int &threshold,
+    cv::Mat *binary,
+    cv::vector<cv::vector<cv::Point>> *contours,
+    cv::vector<cv::Vec4i> *hierarchy) {
+  // applies a fixed-level threshold to each gray element:
+  cv::threshold(gray, *binary, threshold, 255, cv::THRESH_BINARY);
+  // finds contours in a binary image;
+  // here binary is the input image.
+  findContours(*binary,
+               *contours,
+               *hierarchy,
+               CV_RETR_TREE,
+               CV_CHAIN_APPROX_SIMPLE,
+               cv::Point(0, 0));
+}
+// The sides of a region which are inside the frame cut through the
+// background, whose contour or blob then runs along them; so a rect which
+// reaches within this many pixels of such a side is not an object. One pixel
+// more than the side itself, as OpenCV 2.4 findContours(..) skips the
+// outermost pixels of the image.
+const int kRegionSideTolerance = 2;
+// rect is in the coordinates of region, which is a part of frame:
+bool IsInsideRegion(const cv::Rect &rect,
+                    const cv::Rect &region,
+                    const cv::Rect &frame) {
+  if ((region.x > frame.x) && (rect.x < kRegionSideTolerance)) return false;
+  if ((region.y > frame.y) && (rect.y < kRegionSideTolerance)) return false;
+  if ((region.br().x < frame.br().x) &&
+      (rect.br().x > region.width - kRegionSideTolerance)) {
+    return false;
+  }
+  if ((region.br().y < frame.br().y) &&
+      (rect.br().y > region.height - kRegionSideTolerance)) {
+    return false;
+  }
+  return true;
+}
+
+int FindRegionRoot(std::vector<int> *parent, int i) {
+  while ((*parent)[i] != i) {
+    (*parent)[i] = (*parent)[(*parent)[i]];  // path halving
+    i = (*parent)[i];
+  }
+  return i;
+}
+// Replaces every group of overlapping regions by their bounding rect, in the
+// order of the first region of each group. A pass joins the groups found by
+// union-find over the pairs of regions; since a joined region may overlap one
+// which none of its parts did, the passes repeat until one joins nothing,
+// which is usually the second. parent holds the union-find forest.
+// regions and parent should not be NULL.
+void JoinOverlappingRegions(std::vector<cv::Rect> *regions,
+                            std::vector<int> *parent) {
+  assert(regions != nullptr);
+  assert(parent != nullptr);
+  bool joined = true;
+  while (joined) {
+    joined = false;
+    int num_of_regions = static_cast<int>(regions->size());
+    parent->resize(num_of_regions);
+    for (int i = 0; i < num_of_regions; i++) {
+      (*parent)[i] = i;
+    }
+    for (int i = 0; i < num_of_regions; i++) {
+      for (int j = i + 1; j < num_of_regions; j++) {
+        if (((*regions)[i] & (*regions)[j]).area() == 0) continue;
+        int root_i = FindRegionRoot(parent, i);
+        int root_j = FindRegionRoot(parent, j);
+        if (root_i == root_j) continue;
+        // the root is the first region of the group:
+        (*parent)[std::max(root_i, root_j)] = std::min(root_i, root_j);
+        joined = true;
+      }
+    }
+    if (!joined) return;
+    for (int i = 0; i < num_of_regions; i++) {
+      int root = FindRegionRoot(parent, i);
+      if (root != i) (*regions)[root] |= (*regions)[i];
+    }
+    int num_of_groups = 0;
+    for (int i = 0; i < num_of_regions; i++) {
+      if ((*parent)[i] == i) (*regions)[num_of_groups++] = (*regions)[i];
+    }
+    regions->resize(num_of_groups);
+  }
+}
+}  // namespace
 // This method:
 // 1. Extracts background and preprocesses the image;
 // 2. Detects contours of the objecst then approximates them to rects;
@@ -23,78 +120,65 @@ std::vector<Object> ObjectDetector::DetectObjectsFromImage(
   // image and background should have the same size:
   assert(image.matrix().rows == background.matrix().rows);
   assert(image.matrix().cols == background.matrix().cols);
-  // 1:
-  cv::Mat src_gray;
-  ExtractForegroundAndPreprocess(image, background).copyTo(src_gray);
-  // 2:
-  // Detect contours/edges using Threshold;
-  // Approximate contours to polygons + get bounding rects:
-  cv::Mat threshold_output;
-  cv::vector<cv::Rect> good_rects;
-  DetectBoundingRectsAndEdges(src_gray, &threshold_output, &good_rects);
-  // 3:
-  // Create the objects from those rects:
-  auto src = image.matrix();
-  std::vector<Object> detected_objects;
-  return GetObjectsFromRects(good_rects,
-                             threshold_output,
-                             src);
+  return DetectObjectsFromImage(image, BackgroundModel(background));
 }
 
-bool ObjectDetector::RectCenterInsideOtherRect(
-    const int &index,
-    const cv::vector<cv::Rect> &rectangles) const {
-  assert(rectangles.size() > 0);
-  assert(index >= 0);
-  assert(index < rectangles.size());
-  bool result = false;
-  auto current_rect = rectangles[index];
-  cv::Point2d center(current_rect.x + current_rect.width/2,
-                     current_rect.y + current_rect.height/2);
-  for (int i = 0; i < rectangles.size(); i++) {
-      if (i != index) {
-          if (rectangles[i].contains(center) &&
-              (current_rect.area() < rectangles[i].area())) {
-              result = true;
-              break;
-          }
-      }
+// A workspace used for one frame only:
+std::vector<Object> ObjectDetector::DetectObjectsFromImage(
+    const Image &image,
+    const BackgroundModel &background) const {
+  DetectorWorkspace workspace;
+  std::vector<Object> objects;
+  DetectObjectsFromImage(image, background, &workspace, &objects);
+  return objects;
+}
+
+void ObjectDetector::DetectObjectsFromImage(
+    const Image &image,
+    const BackgroundModel &background,
+    DetectorWorkspace *workspace,
+    std::vector<Object> *objects) const {
+  assert(workspace != nullptr);
+  assert(objects != nullptr);
+  cv::vector<cv::Rect> &good_rects = workspace->good_rects_;
+  good_rects.clear();
+  // 1, 2:
+  if (detection_resolution_ == kPyramidDetection) {
+    DetectRectsCoarseToFine(image, background, workspace, &good_rects);
+  } else {
+    DetectRectsAtFullResolution(image, background, workspace, &good_rects);
   }
-  return result;
+  // 3:
+  // Create the objects from those rects:
+  GetObjectsFromRects(good_rects, image.matrix(), workspace, objects);
 }
-// The mask is computed using the OpenCV BackgroundSubtractorMOG2 class.
-// It detects the shadows as well
+
+// The shadow is recolored to 0 (considered as background):
 cv::Mat ObjectDetector::ComputeForegroundMask(
     const Image &image,
     const Image &background) const {
   assert(image.matrix().rows == background.matrix().rows);
   assert(image.matrix().cols == background.matrix().cols);
-  // 1. Setup the subtractor:
-  cv::Mat mask;
-  int history = 2;
-  float var_threshold = 50;
-  bool shadow_detection = true;
-  cv::Ptr<cv::BackgroundSubtractor> subtractor =
-  new cv::BackgroundSubtractorMOG2(history,
-                                   var_threshold,
-                                   shadow_detection);
-  subtractor->set("fVarInit", 100);
-  subtractor->set("fTau", 0.05);
-  subtractor->operator()(background.matrix(), mask);
-  subtractor->operator()(image.matrix(), mask);
-  subtractor.release();
- // return mask;
-  // 2. Recolor the shadow to 0 (consider it as background):
-  // the subtractor recolors the shadow into 127 intensity;
-  // so to eliminate the shadow, just recolor these pixels:
+  cv::Mat mask = ComputeRawForegroundMask(image, BackgroundModel(background));
   for (int i = 0; i < mask.rows; i++) {
-      for (int j = 0; j < mask.cols; j++) {
-          if (mask.at<uchar>(i, j) == 127) {
-              mask.at<uchar>(i, j) = 0;
-          }
+    uchar *row = mask.ptr<uchar>(i);
+    for (int j = 0; j < mask.cols; j++) {
+      if (row[j] == kShadowIntensity) {
+        row[j] = 0;
       }
+    }
   }
-
+  return mask;
+}
+// The mask is computed using the OpenCV BackgroundSubtractorMOG2 class, see
+// BackgroundModel. It detects the shadows as well.
+cv::Mat ObjectDetector::ComputeRawForegroundMask(
+    const Image &image,
+    const BackgroundModel &background) const {
+  assert(image.matrix().size() == background.frame_size());
+  cv::Mat mask;
+  background.ComputeRawForegroundMask(image.matrix(), &mask);
+  // the subtractor recolors the shadow into kShadowIntensity:
   return mask;
 }
 
@@ -119,142 +203,512 @@ void ObjectDetector::RecolorDetectedPixels(cv::Mat *mat) const {
       }
   }
 }
-// Preprocessing done using the methods described above.
+// Preprocessing done using the methods described above: shadow removal,
+// masked copy, RecolorDetectedPixels(..), conversion to gray and a 3x3 blur.
+// All but the background subtraction are done by one fused kernel, which
+// gives exactly the same result without the intermediate matrices.
 cv::Mat ObjectDetector::ExtractForegroundAndPreprocess(
     const Image &image,
     const Image &background) const {
-  cv::Mat mask;
-  ComputeForegroundMask(image, background).copyTo(mask);
+  return ExtractForegroundAndPreprocess(image, BackgroundModel(background));
+}
 
-  auto src = image.matrix();
-  cv::Mat recolored_src;
-  src.copyTo(recolored_src, mask);  // copy using mask.
+// The gray matrix of the workspace is not pooled, so it outlives it:
+cv::Mat ObjectDetector::ExtractForegroundAndPreprocess(
+    const Image &image,
+    const BackgroundModel &background) const {
+  DetectorWorkspace workspace;
+  return ExtractForegroundAndPreprocess(image, background, &workspace);
+}
 
-  //  Recolor the detected pixels:
-  RecolorDetectedPixels(&recolored_src);
+const cv::Mat& ObjectDetector::ExtractForegroundAndPreprocess(
+    const Image &image,
+    const BackgroundModel &background,
+    DetectorWorkspace *workspace) const {
+  assert(workspace != nullptr);
+  assert(image.matrix().size() == background.frame_size());
+  const cv::Mat &raw_mask = workspace->raw_mask_;
+  background.ComputeRawForegroundMask(image.matrix(), &workspace->raw_mask_);
+  cv::Mat &src_gray = workspace->gray_;
+  int num_of_tiles = NumberOfTiles(raw_mask.rows);
+  if (num_of_tiles == 1) {
+    ForegroundToBlurredGray(raw_mask, image.matrix(), &src_gray,
+                            &workspace->row_buffer_);
+    return src_gray;
+  }
+  // every tile reads the rows around it, but writes only its own:
+  src_gray.create(raw_mask.size(), CV_8UC1);
+  RunTasks(num_of_tiles, [&](int tile) {
+    DetectorWorkspace::TaskLease task(workspace);
+    ForegroundToBlurredGrayRows(raw_mask,
+                                image.matrix(),
+                                tile * tile_height_,
+                                std::min((tile + 1) * tile_height_,
+                                         raw_mask.rows),
+                                &src_gray,
+                                &task->row_buffer);
+  });
+  return src_gray;
+}
 
-  cv::Mat src_gray;
-  // Convert image to gray and blur it
-  cvtColor(recolored_src, src_gray, CV_BGR2GRAY);
-  blur(src_gray,
-       src_gray,
-       cv::Size(3, 3));
+void ObjectDetector::DetectRectsAtFullResolution(
+    const Image &image,
+    const BackgroundModel &background,
+    DetectorWorkspace *workspace,
+    cv::vector<cv::Rect> *good_rects) const {
+  assert(workspace != nullptr);
+  assert(good_rects != nullptr);
+  // 1:
+  const cv::Mat &src_gray = ExtractForegroundAndPreprocess(image,
+                                                           background,
+                                                           workspace);
+  // 2:
+  // Detect contours/edges using Threshold;
+  // Approximate contours to polygons + get bounding rects:
+  DetectBoundingRectsAndEdges(src_gray,
+                              &workspace->threshold_output_,
+                              good_rects,
+                              0,
+                              workspace);
+}
+// 1. Search the whole downscaled frame, with the widened, scaled limits;
+// 2. if it has no object, or the foreground outside the objects could hold
+// one more, which the downscaling lost, search the whole frame at full
+// resolution instead;
+// 3. the regions around the objects found, scaled back, are joined while any
+// two of them overlap, so that no object is found twice;
+// 4. search each region at full resolution for the threshold which gives the
+// most objects in it. The regions are searched one after the other, since
+// each search runs its own tasks on the pool.
+void ObjectDetector::DetectRectsCoarseToFine(
+    const Image &image,
+    const BackgroundModel &background,
+    DetectorWorkspace *workspace,
+    cv::vector<cv::Rect> *good_rects) const {
+  assert(workspace != nullptr);
+  assert(good_rects != nullptr);
+  const cv::Mat &src = image.matrix();
+  assert(src.size() == background.frame_size());
+  // 1:
+  DownscaleFrameLevels(src, workspace->levels_);
+  const cv::Mat &coarse_image = workspace->levels_[kCoarseLevels - 1];
+  background.ComputeCoarseRawForegroundMask(coarse_image,
+                                            &workspace->coarse_mask_);
+  ForegroundToBlurredGray(workspace->coarse_mask_, coarse_image,
+                          &workspace->coarse_gray_, &workspace->row_buffer_);
+  cv::vector<cv::Rect> &coarse_rects = workspace->region_rects_;
+  coarse_rects.clear();
+  DetectBoundingRectsAndEdges(workspace->coarse_gray_,
+                              &workspace->threshold_output_,
+                              &coarse_rects,
+                              kCoarseLevels,
+                              workspace);
+  // 2. The margin is kept around the coarse rects as well:
+  const int scale = 1 << kCoarseLevels;
+  const int coarse_margin = kPyramidMargin / scale;
+  const cv::Rect coarse_frame(0, 0, coarse_image.cols, coarse_image.rows);
+  std::vector<cv::Rect> &regions = workspace->regions_;
+  regions.clear();
+  for (const auto &rect : coarse_rects) {
+    regions.push_back(cv::Rect(rect.x - coarse_margin,
+                               rect.y - coarse_margin,
+                               rect.width + 2 * coarse_margin,
+                               rect.height + 2 * coarse_margin) &
+                      coarse_frame);
+  }
+  float coarse_object_area = kMinimalAreaForObjectIdentification /
+                             (scale * scale) / kPyramidAreaSlack;
+  if (regions.empty() ||
+      (CountForegroundOutside(workspace->coarse_mask_, regions) >
+       coarse_object_area)) {
+    DetectRectsAtFullResolution(image, background, workspace, good_rects);
+    return;
+  }
+  // 3:
+  const cv::Rect frame(0, 0, src.cols, src.rows);
+  for (auto &region : regions) {
+    region = cv::Rect(region.x * scale, region.y * scale,
+                      region.width * scale, region.height * scale) & frame;
+  }
+  JoinOverlappingRegions(&regions, &workspace->region_parents_);
+  // 4:
+  cv::vector<cv::Rect> &region_rects = workspace->region_rects_;
+  for (const auto &region : regions) {
+    // the blur reads a pixel beyond the region, so a region one pixel wider
+    // is blurred and its inside taken, which is what the whole frame gives:
+    cv::Rect padded = cv::Rect(region.x - 1, region.y - 1,
+                               region.width + 2, region.height + 2) & frame;
+    background.ComputeRawForegroundMask(src(padded), padded,
+                                        &workspace->region_mask_);
+    ForegroundToBlurredGray(workspace->region_mask_, src(padded),
+                            &workspace->region_gray_,
+                            &workspace->row_buffer_);
+    region_rects.clear();
+    DetectBoundingRectsAndEdges(workspace->region_gray_(region - padded.tl()),
+                                &workspace->threshold_output_,
+                                &region_rects,
+                                0,
+                                workspace);
+    for (const auto &rect : region_rects) {
+      if (IsInsideRegion(rect, region, frame)) {
+        good_rects->push_back(rect + region.tl());
+      }
+    }
+  }
+}
+// Only the foreground pixels are checked against the rects, which are few.
+int ObjectDetector::CountForegroundOutside(
+    const cv::Mat &mask,
+    const cv::vector<cv::Rect> &rects) const {
+  assert(mask.type() == CV_8UC1);
+  int num_of_pixels = 0;
+  for (int y = 0; y < mask.rows; y++) {
+    const uchar *row = mask.ptr<uchar>(y);
+    for (int x = 0; x < mask.cols; x++) {
+      if ((row[x] == 0) || (row[x] == kShadowIntensity)) continue;
+      cv::Point point(x, y);
+      bool outside = true;
+      for (const auto &rect : rects) {
+        if (rect.contains(point)) {
+          outside = false;
+          break;
+        }
+      }
+      if (outside) num_of_pixels++;
+    }
+  }
+  return num_of_pixels;
+}
 
-  return src_gray;
+bool ObjectDetector::HasObjectArea(const float &area, const int &level) const {
+  if (level == 0) {
+    return (area > kMinimalAreaForObjectIdentification) &&
+           (area < kMaximalAreaForObjectIdentification);
+  }
+  // the area shrinks 4 times with every level:
+  float scale = 1.0f / (1 << (2 * level));
+  return (area > kMinimalAreaForObjectIdentification * scale /
+                 kPyramidAreaSlack) &&
+         (area < kMaximalAreaForObjectIdentification * scale *
+                 kPyramidAreaSlack);
 }
 
 void ObjectDetector::DetectBoundingRectsAndEdges(
     const cv::Mat &src_gray,
     cv::Mat *threshold_output,
-    cv::vector<cv::Rect> *good_rects) const {
+    cv::vector<cv::Rect> *good_rects,
+    const int &level) const {
+  DetectorWorkspace workspace;
+  DetectBoundingRectsAndEdges(src_gray, threshold_output, good_rects, level,
+                              &workspace);
+}
+// The contours of the best threshold are found once more, instead of being
+// kept for every threshold in case it is the best.
+void ObjectDetector::DetectBoundingRectsAndEdges(
+    const cv::Mat &src_gray,
+    cv::Mat *threshold_output,
+    cv::vector<cv::Rect> *good_rects,
+    const int &level,
+    DetectorWorkspace *workspace) const {
     assert(threshold_output != nullptr);
     assert(good_rects != nullptr);
+    assert(workspace != nullptr);
+    if (detection_backend_ == kConnectedComponentsBackend) {
+      // The blobs already carry their bounding rects:
+      DetectBlobsInMatrixWithThresholdOutput(src_gray,
+                                             good_rects,
+                                             threshold_output,
+                                             level,
+                                             workspace);
+      return;
+    }
     // Detect contours/edges using Threshold
-    cv::vector<cv::vector<cv::Point>> best_contours;
-    DetectContoursInMatrixWithThresholdOutput(src_gray,
-                                              &best_contours,
-                                              threshold_output);
-
-  cv::vector<cv::vector<cv::Point>> contours;
-  contours = best_contours;
+    int best_threshold = FindBestContourThreshold(src_gray, level, workspace);
+    threshold(src_gray, *threshold_output, workspace->thresholds_.back(), 255,
+              cv::THRESH_BINARY);
+    if (best_threshold < 0) return;
+    DetectBoundingRectsAtThreshold(src_gray, best_threshold, level, workspace,
+                                   good_rects);
+}
 
+void ObjectDetector::DetectBoundingRectsAtThreshold(
+    const cv::Mat &src_gray,
+    const int &threshold,
+    const int &level,
+    DetectorWorkspace *workspace,
+    cv::vector<cv::Rect> *good_rects) const {
+  assert(workspace != nullptr);
+  assert(good_rects != nullptr);
+  DetectorWorkspace::TaskLease task(workspace);
+  if (detection_backend_ == kConnectedComponentsBackend) {
+    task->labeler.LabelBlobs(src_gray, threshold, &task->blobs);
+    for (const auto &blob : task->blobs) {
+      if (HasObjectArea(blob.area, level)) {
+        good_rects->push_back(blob.bounding_rect);
+      }
+    }
+    return;
+  }
+  FindContoursAtThreshold(src_gray, threshold, &task->binary,
+                          &task->contours, &task->hierarchy);
   // Approximate contours to polygons + get bounding rects:
-  GetGoodBoundingRectsOfContours(contours, good_rects);
+  GetGoodBoundingRectsOfContours(task->contours, good_rects, level,
+                                 &task->polygon);
 }
 
 // Using the functionality form OpenCV, we can find contours adjusting different
 // threshold. We try every possible threshold and select the one which gives the
 // most contours which pass the area conditions - they are neither too small nor
 // too big.
+// threshold_output is left with the binary image of the last threshold, which
+// is what trying them one by one leaves.
 void ObjectDetector::DetectContoursInMatrixWithThresholdOutput(
     const cv::Mat &gray,
     cv::vector<cv::vector<cv::Point>> *best_contours,
-    cv::Mat *threshold_output) const {
+    cv::Mat *threshold_output,
+    const int &level) const {
   assert(best_contours != nullptr);
   assert(threshold_output != nullptr);
-  cv::vector<cv::Vec4i> hierarchy;
-  int max_num_of_contours = 0;
-  for (int i = 0; i < 256; i++) {
-    // applies a fixed-level threshold i to each gray element:
-    threshold(gray, *threshold_output, i, 255, cv::THRESH_BINARY);
+  DetectorWorkspace workspace;
+  int best_threshold = FindBestContourThreshold(gray, level, &workspace);
+  if (best_threshold >= 0) {
+    cv::Mat binary;
     cv::vector<cv::vector<cv::Point>> contours;
-    cv::vector<cv::vector<cv::Point>> candidate_contours;
-    // finds contours in a binary image;
-    // here threshold_output is the input image.
-    findContours(*threshold_output,
-                 contours,
-                 hierarchy,
-                 CV_RETR_TREE,
-                 CV_CHAIN_APPROX_SIMPLE,
-                 cv::Point(0, 0));
+    cv::vector<cv::Vec4i> hierarchy;
+    FindContoursAtThreshold(gray, best_threshold, &binary, &contours,
+                            &hierarchy);
+    best_contours->clear();
+    for (const auto &contour : contours) {
+      if (HasObjectArea(contourArea(contour), level)) {
+        best_contours->push_back(contour);
+      }
+    }
+  }
+  threshold(gray, *threshold_output, workspace.thresholds_.back(), 255,
+            cv::THRESH_BINARY);
+}
+// The thresholds are independent, so they are tried as separate tasks; the
+// first threshold with the most contours wins, as if they were tried in
+// increasing order.
+int ObjectDetector::FindBestContourThreshold(
+    const cv::Mat &gray,
+    const int &level,
+    DetectorWorkspace *workspace) const {
+  assert(workspace != nullptr);
+  std::vector<int> &thresholds = workspace->thresholds_;
+  CandidateThresholds(gray, &thresholds);
+  int num_of_thresholds = static_cast<int>(thresholds.size());
+  std::vector<int> &num_of_contours = workspace->num_of_candidates_;
+  num_of_contours.resize(num_of_thresholds);
+  RunTasks(num_of_thresholds, [&](int t) {
+    DetectorWorkspace::TaskLease task(workspace);
+    FindContoursAtThreshold(gray, thresholds[t], &task->binary,
+                            &task->contours, &task->hierarchy);
+    num_of_contours[t] = 0;
+    for (const auto &contour : task->contours) {
+      if (HasObjectArea(contourArea(contour), level)) {
+        num_of_contours[t]++;
+      }
+    }
+  });
+  int best_threshold = -1;
+  int max_num_of_contours = 0;
+  for (int t = 0; t < num_of_thresholds; t++) {
+    if (num_of_contours[t] > max_num_of_contours) {
+      max_num_of_contours = num_of_contours[t];
+      best_threshold = thresholds[t];
+    }
+  }
+  return best_threshold;
+}
 
-    int current_num_of_contours = 0;
-    for (int j = 0; j < contours.size(); j++) {
-      float area = contourArea(contours[j]);
-      if ((area > kMinimalAreaForObjectIdentification) &&
-          (area < kMaximalAreaForObjectIdentification)) {
-        current_num_of_contours++;
-        candidate_contours.push_back(contours[j]);
+void ObjectDetector::DetectBlobsInMatrixWithThresholdOutput(
+    const cv::Mat &gray,
+    cv::vector<cv::Rect> *good_rects,
+    cv::Mat *threshold_output,
+    const int &level) const {
+  DetectorWorkspace workspace;
+  DetectBlobsInMatrixWithThresholdOutput(gray, good_rects, threshold_output,
+                                         level, &workspace);
+}
+// The same search as above, but the blobs are labeled right from the gray
+// matrix, so neither the binary image nor the contours are built for every
+// threshold. Every threshold is a task of its own; with several tiles, every
+// tile of every threshold is, and then the tiles of every threshold are
+// merged, see MergeBands(..). The good rects and the tiles of every threshold
+// are kept in the workspace, whose vectors are only ever grown.
+void ObjectDetector::DetectBlobsInMatrixWithThresholdOutput(
+    const cv::Mat &gray,
+    cv::vector<cv::Rect> *good_rects,
+    cv::Mat *threshold_output,
+    const int &level,
+    DetectorWorkspace *workspace) const {
+  assert(good_rects != nullptr);
+  assert(threshold_output != nullptr);
+  assert(workspace != nullptr);
+  std::vector<int> &thresholds = workspace->thresholds_;
+  CandidateThresholds(gray, &thresholds);
+  int num_of_thresholds = static_cast<int>(thresholds.size());
+  int num_of_tiles = NumberOfTiles(gray.rows);
+  auto &candidate_rects = workspace->candidate_rects_;
+  if (candidate_rects.size() < thresholds.size()) {
+    candidate_rects.resize(thresholds.size());
+  }
+  // Keeps the good blobs of threshold t:
+  auto keep_good_blobs = [&](const std::vector<BlobStats> &blobs, int t) {
+    candidate_rects[t].clear();
+    for (const auto &blob : blobs) {
+      if (HasObjectArea(blob.area, level)) {
+        candidate_rects[t].push_back(blob.bounding_rect);
       }
     }
-    if (current_num_of_contours > max_num_of_contours) {
-      max_num_of_contours = current_num_of_contours;
-      *best_contours = candidate_contours;
+  };
+  if (num_of_tiles == 1) {
+    // 1, 2. Label the whole matrix:
+    RunTasks(num_of_thresholds, [&](int t) {
+      DetectorWorkspace::TaskLease task(workspace);
+      task->labeler.LabelBlobs(gray, thresholds[t], &task->blobs);
+      keep_good_blobs(task->blobs, t);
+    });
+  } else {
+    // 1. Label the tiles:
+    std::vector<BandBlobs> &bands = workspace->bands_;
+    if (bands.size() < thresholds.size() * num_of_tiles) {
+      bands.resize(thresholds.size() * num_of_tiles);
+    }
+    RunTasks(num_of_thresholds * num_of_tiles, [&](int task_index) {
+      int tile = task_index % num_of_tiles;
+      DetectorWorkspace::TaskLease task(workspace);
+      task->labeler.LabelBand(gray,
+                              thresholds[task_index / num_of_tiles],
+                              std::min(tile * tile_height_, gray.rows),
+                              std::min((tile + 1) * tile_height_, gray.rows),
+                              &bands[task_index]);
+    });
+    // 2. Merge them and keep the good blobs. The tiles of a threshold are
+    // swapped into the scratch of its task, so both keep their capacity:
+    RunTasks(num_of_thresholds, [&](int t) {
+      DetectorWorkspace::TaskLease task(workspace);
+      task->bands.resize(num_of_tiles);
+      for (int tile = 0; tile < num_of_tiles; tile++) {
+        std::swap(task->bands[tile], bands[t * num_of_tiles + tile]);
+      }
+      MergeBands(task->bands, &task->blobs);
+      keep_good_blobs(task->blobs, t);
+    });
+  }
+  // 3. The first threshold with the most of them:
+  int max_num_of_blobs = 0;
+  int best_threshold = kNumberOfGrayLevels - 1;
+  for (int t = 0; t < num_of_thresholds; t++) {
+    if (static_cast<int>(candidate_rects[t].size()) > max_num_of_blobs) {
+      max_num_of_blobs = static_cast<int>(candidate_rects[t].size());
+      best_threshold = thresholds[t];
+      good_rects->assign(candidate_rects[t].begin(),
+                         candidate_rects[t].end());
     }
   }
+  threshold(gray, *threshold_output, best_threshold, 255, cv::THRESH_BINARY);
+}
+// THRESH_BINARY keeps the pixels with value > i. So the binary images for
+// thresholds i - 1 and i differ only if some pixel has exactly the value i.
+// Thresholds between two occurring levels give the same image as the first of
+// them, and since only a strictly better threshold replaces the best one, the
+// first of them is the only one worth trying. The last candidate gives an empty
+// image, exactly as the threshold 255 does.
+std::vector<int> ObjectDetector::CandidateThresholds(
+    const cv::Mat &gray) const {
+  std::vector<int> thresholds;
+  CandidateThresholds(gray, &thresholds);
+  return thresholds;
+}
+
+void ObjectDetector::CandidateThresholds(const cv::Mat &gray,
+                                         std::vector<int> *thresholds) const {
+  assert(thresholds != nullptr);
+  thresholds->clear();
+  if (threshold_search_mode_ == kExhaustiveThresholdSearch) {
+    for (int i = 0; i < kNumberOfGrayLevels; i++) {
+      thresholds->push_back(i);
+    }
+    return;
+  }
+  assert(gray.type() == CV_8UC1);
+  // 1. Build the histogram in one pass:
+  int histogram[kNumberOfGrayLevels] = {0};
+  for (int y = 0; y < gray.rows; y++) {
+    const uchar *row = gray.ptr<uchar>(y);
+    for (int x = 0; x < gray.cols; x++) {
+      histogram[row[x]]++;
+    }
+  }
+  // 2. Every occurring level starts a new binarization:
+  thresholds->push_back(0);
+  for (int i = 1; i < kNumberOfGrayLevels; i++) {
+    if (histogram[i] > 0) {
+      thresholds->push_back(i);
+    }
+  }
+}
+
+int ObjectDetector::NumberOfTiles(const int &num_of_rows) const {
+  if (!pool_) return 1;
+  return std::max(1, (num_of_rows + tile_height_ - 1) / tile_height_);
 }
 // Approximates contours to polygons, polygons to other polygons with less
 // vertices, then finally generates rectangles each of which encloses a set of
 // points (a polygon). From those rectangles only the ones with good size are
-// taken.
+// taken, so only their polygons are approximated.
 void ObjectDetector::GetGoodBoundingRectsOfContours(
     const cv::vector<cv::vector<cv::Point>> &contours,
-    cv::vector<cv::Rect> *good_rects) const {
-  assert(contours.size() > 0);
+    cv::vector<cv::Rect> *good_rects,
+    const int &level,
+    cv::vector<cv::Point> *polygon) const {
   assert(good_rects != nullptr);
-  // Approximate contours to polygons + get bounding rects
-  cv::vector<cv::vector<cv::Point>> contours_poly(contours.size());
-  cv::vector<cv::Rect> bound_rect(contours.size());
-
+  cv::vector<cv::Point> local_polygon;
+  if (polygon == nullptr) polygon = &local_polygon;
   for (int i = 0; i < contours.size(); i++) {
+    // check the size:
+    if (!HasObjectArea(contourArea(contours[i]), level)) continue;
     // approximate a curve/poly to another curve/poly with less vertices:
     approxPolyDP(cv::Mat(contours[i]),
-                 contours_poly[i],
+                 *polygon,
                  3,
                  true);
     // computes the bounding rect for a set of points:
-    bound_rect[i] = boundingRect(cv::Mat(contours_poly[i]));
-  }
-  // check the size:
-  for (int i = 0; i < contours.size(); i++) {
-    float area = contourArea(contours[i]);
-    if ((area > kMinimalAreaForObjectIdentification) &&
-        (area < kMaximalAreaForObjectIdentification)) {
-      good_rects->push_back(bound_rect[i]);
-    }
+    good_rects->push_back(boundingRect(cv::Mat(*polygon)));
   }
 }
 // "Cut" the rectangles from the original image and pass them as images to
-// Object class constructors, thus creating objects.
+// Object class constructors, thus creating objects. The pixels are not copied:
+// every object's image is a view into src.
 std::vector<Object> ObjectDetector::GetObjectsFromRects(
   const cv::vector<cv::Rect> &good_rects,
-  const cv::Mat &threshold_output,
   const cv::Mat &src) const {
-  assert(good_rects.size() > 0);
   std::vector<Object> detected_objects;
-  for (int i = 0; i < good_rects.size(); i++) {
-    if (!RectCenterInsideOtherRect(i, good_rects)) {
-     // Create an object out of this:
-      cv::Mat object_mat;
-      src(good_rects[i]).copyTo(object_mat);
-      Image object_image(object_mat);
-      object_image.set_bounding_rect(good_rects[i]);
-      Object detected_object(object_image);
-      detected_objects.push_back(detected_object);
-    }
+  // the rects which are not inside a bigger one, see SuppressNestedRects(..):
+  for (int i : SuppressNestedRects(good_rects)) {
+    // Create an object out of this:
+    Image object_image(src(good_rects[i]), good_rects[i]);
+    detected_objects.push_back(Object(std::move(object_image)));
   }
   return detected_objects;
 }
 
+void ObjectDetector::GetObjectsFromRects(
+    const cv::vector<cv::Rect> &good_rects,
+    const cv::Mat &src,
+    DetectorWorkspace *workspace,
+    std::vector<Object> *objects) const {
+  assert(workspace != nullptr);
+  assert(objects != nullptr);
+  SuppressNestedRects(good_rects, &workspace->rect_index_,
+                      &workspace->kept_rects_);
+  objects->clear();
+  for (int i : workspace->kept_rects_) {
+    objects->push_back(Object(Image(src(good_rects[i]), good_rects[i])));
+  }
+}
+
 }  // namespace object_clustering
 
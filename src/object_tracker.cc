@@ -0,0 +1,239 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// object_tracker.cc
+// Object Clustering
+
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "feature_matrix.h"
+#include "object_tracker.h"
+#include "rect_index.h"
+
+namespace object_clustering {
+// 1. Match the objects to the previous frame, by their rects and mean colors;
+// a color is taken once per object, sampled, and kept with its track for the
+// next frame;
+// 2. the hits take the previous groups. The misses are clustered on their
+// own if the algorithm keeps its groups, else they get the group of their
+// nearest center of model_; without a hit, or without a model, the whole
+// frame is clustered;
+// 3. the objects become the previous frame, with their features if the
+// algorithm does not keep its groups: the hits carry theirs over, and a frame
+// clustered as a whole gives model_.
+int ObjectTracker::AssignGroupsToObjects(
+    const AbstractClusterAlgorithm &clusterer,
+    std::vector<Object> *objects) {
+  assert(objects != nullptr);
+  int num_of_objects = static_cast<int>(objects->size());
+  // 1:
+  std::vector<cv::Scalar> colors(num_of_objects);
+  for (int i = 0; i < num_of_objects; i++) {
+    colors[i] = MeanColor((*objects)[i].image().matrix());
+  }
+  std::vector<int> matches;
+  MatchObjects(*objects, colors, &matches);
+  // 2:
+  std::vector<int> misses;
+  for (int i = 0; i < num_of_objects; i++) {
+    if (matches[i] < 0) misses.push_back(i);
+  }
+  bool keeps_groups = clusterer.keeps_groups();
+  bool whole_frame = (misses.size() == objects->size()) ||
+                     (!misses.empty() && !keeps_groups && model_.empty());
+  std::vector<Track> tracks(num_of_objects);
+  if (whole_frame) {
+    misses.resize(num_of_objects);
+    for (int i = 0; i < num_of_objects; i++) {
+      misses[i] = i;
+    }
+    num_of_groups_ = clusterer.AssignGroupsToObjects(objects);
+  } else {
+    for (int i = 0; i < num_of_objects; i++) {
+      if (matches[i] >= 0) {
+        (*objects)[i].set_group(tracks_[matches[i]].group);
+        tracks[i].features = tracks_[matches[i]].features;
+      }
+    }
+    if (!misses.empty()) {
+      // the copies share the pixels:
+      std::vector<Object> new_objects;
+      new_objects.reserve(misses.size());
+      for (int i : misses) {
+        new_objects.push_back((*objects)[i]);
+      }
+      if (keeps_groups) {
+        num_of_groups_ = clusterer.AssignGroupsToObjects(&new_objects);
+        for (size_t j = 0; j < misses.size(); j++) {
+          (*objects)[misses[j]].set_group(new_objects[j].group());
+        }
+      } else {
+        FeatureMatrix features(static_cast<int>(misses.size()),
+                               kNumberOfFeatures);
+        ExtractFeatures(new_objects, &features);
+        for (size_t j = 0; j < misses.size(); j++) {
+          const float *row = features.row(static_cast<int>(j));
+          FeatureVector &object_features = tracks[misses[j]].features;
+          std::copy(row, row + kNumberOfFeatures, object_features.begin());
+          (*objects)[misses[j]].set_group(model_.Assign(object_features,
+                                                        nullptr));
+        }
+      }
+    }
+  }
+  num_of_misses_ += misses.size();
+  num_of_hits_ += num_of_objects - static_cast<int>(misses.size());
+  // 3:
+  for (int i = 0; i < num_of_objects; i++) {
+    tracks[i].rect = (*objects)[i].image().bounding_rect();
+    tracks[i].color = colors[i];
+    tracks[i].group = (*objects)[i].group();
+  }
+  tracks_.swap(tracks);
+  if (whole_frame && !keeps_groups) {
+    if (num_of_objects > 0) {
+      FeatureMatrix features(num_of_objects, kNumberOfFeatures);
+      ExtractFeatures(*objects, &features);
+      for (int i = 0; i < num_of_objects; i++) {
+        std::copy(features.row(i), features.row(i) + kNumberOfFeatures,
+                  tracks_[i].features.begin());
+      }
+    }
+    BuildModel();
+  }
+  return num_of_objects == 0 ? 0 : num_of_groups_;
+}
+
+void ObjectTracker::Reset() {
+  tracks_.clear();
+  model_ = ClusterModel();
+  num_of_groups_ = 0;
+}
+
+float ObjectTracker::Overlap(const cv::Rect &first, const cv::Rect &second) {
+  if ((first.area() <= 0) || (second.area() <= 0)) return 0;
+  float intersection = (first & second).area();
+  return intersection / (first.area() + second.area() - intersection);
+}
+cv::Scalar ObjectTracker::MeanColor(const cv::Mat &matrix) {
+  assert(matrix.depth() == CV_8U);
+  assert(matrix.channels() <= 4);
+  int num_of_channels = matrix.channels();
+  int64_t sums[4] = {0, 0, 0, 0};
+  int64_t num_of_pixels = 0;
+  for (int y = 0; y < matrix.rows; y += kTrackerColorStride) {
+    const uchar *row = matrix.ptr<uchar>(y);
+    for (int x = 0; x < matrix.cols; x += kTrackerColorStride) {
+      const uchar *pixel = row + x * num_of_channels;
+      for (int c = 0; c < num_of_channels; c++) {
+        sums[c] += pixel[c];
+      }
+      num_of_pixels++;
+    }
+  }
+  double means[4] = {0, 0, 0, 0};
+  for (int c = 0; (c < num_of_channels) && (num_of_pixels > 0); c++) {
+    means[c] = static_cast<double>(sums[c]) / num_of_pixels;
+  }
+  return cv::Scalar(means[0], means[1], means[2], means[3]);
+}
+// The previous objects whose rect holds the center of an object are found by
+// a RectIndex, so an object is compared to a few previous ones only. The
+// candidate pairs are then taken by decreasing overlap, the earlier objects
+// first among equal ones.
+void ObjectTracker::MatchObjects(const std::vector<Object> &objects,
+                                 const std::vector<cv::Scalar> &colors,
+                                 std::vector<int> *matches) const {
+  assert(matches != nullptr);
+  assert(colors.size() == objects.size());
+  matches->assign(objects.size(), -1);
+  if (tracks_.empty() || objects.empty()) return;
+  std::vector<cv::Rect> previous_rects(tracks_.size());
+  for (size_t t = 0; t < tracks_.size(); t++) {
+    previous_rects[t] = tracks_[t].rect;
+  }
+  RectIndex index(previous_rects);
+  // (overlap, object, track):
+  std::vector<std::tuple<float, int, int>> candidates;
+  std::vector<int> containing;
+  for (int i = 0; i < static_cast<int>(objects.size()); i++) {
+    const cv::Rect &rect = objects[i].image().bounding_rect();
+    cv::Point center(rect.x + rect.width / 2, rect.y + rect.height / 2);
+    index.FindContaining(center, &containing);
+    for (int t : containing) {
+      float overlap = Overlap(rect, tracks_[t].rect);
+      if (overlap < min_overlap_) continue;
+      bool same_color = true;
+      for (int c = 0; c < 4; c++) {
+        if (std::abs(colors[i][c] - tracks_[t].color[c]) > max_color_shift_) {
+          same_color = false;
+        }
+      }
+      if (same_color) candidates.push_back(std::make_tuple(overlap, i, t));
+    }
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const std::tuple<float, int, int> &first,
+                      const std::tuple<float, int, int> &second) {
+    return std::get<0>(first) > std::get<0>(second);
+  });
+  std::vector<bool> track_taken(tracks_.size(), false);
+  for (const auto &candidate : candidates) {
+    int i = std::get<1>(candidate);
+    int t = std::get<2>(candidate);
+    if (((*matches)[i] < 0) && !track_taken[t]) {
+      (*matches)[i] = t;
+      track_taken[t] = true;
+    }
+  }
+}
+// 1. The max and avg value of every feature, as
+// KMeansClusteringAlgorithm::NormalizeFeatures(..) takes them;
+// 2. the sum of the normalized features of every group, then their mean.
+void ObjectTracker::BuildModel() {
+  model_ = ClusterModel();
+  if (tracks_.empty() || (num_of_groups_ <= 0)) return;
+  // 1:
+  FeatureVector max_feature_value;
+  FeatureVector avg_feature_value;
+  max_feature_value.fill(-FLT_MAX);
+  avg_feature_value.fill(0);
+  for (const auto &track : tracks_) {
+    for (int j = 0; j < kNumberOfFeatures; j++) {
+      max_feature_value[j] = std::max(max_feature_value[j],
+                                      track.features[j]);
+      avg_feature_value[j] += track.features[j];
+    }
+  }
+  for (auto &value : avg_feature_value) {
+    value /= static_cast<float>(tracks_.size());
+  }
+  // 2:
+  FeatureMatrix centers(num_of_groups_, kNumberOfFeatures);
+  centers.SetZero();
+  std::vector<int> group_sizes(num_of_groups_, 0);
+  for (const auto &track : tracks_) {
+    if ((track.group < 0) || (track.group >= num_of_groups_)) return;
+    FeatureVector features = track.features;
+    NormalizeFeatureRow(max_feature_value, avg_feature_value,
+                        features.data());
+    float *center = centers.row(track.group);
+    for (int j = 0; j < kNumberOfFeatures; j++) {
+      center[j] += features[j];
+    }
+    group_sizes[track.group]++;
+  }
+  for (int group = 0; group < num_of_groups_; group++) {
+    if (group_sizes[group] == 0) return;
+    float *center = centers.row(group);
+    for (int j = 0; j < kNumberOfFeatures; j++) {
+      center[j] /= group_sizes[group];
+    }
+  }
+  model_ = ClusterModel(max_feature_value, avg_feature_value, centers, 0);
+}
+}  // namespace object_clustering
@@ -0,0 +1,112 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// pooling_mat_allocator.cc
+// Object Clustering
+
+#include <cassert>
+
+#include <mutex>
+#include <vector>
+
+#include "pooling_mat_allocator.h"
+
+namespace object_clustering {
+namespace {
+// Size classes per doubling of the size:
+const int kClassesPerDoubling = 4;
+// The bytes of the buffers of a size class:
+size_t BytesOfSizeClass(const int &size_class) {
+  size_t base = kMinPooledBlockBytes << (size_class / kClassesPerDoubling);
+  return base + base / kClassesPerDoubling *
+                (size_class % kClassesPerDoubling);
+}
+}  // namespace
+
+PoolingMatAllocator::~PoolingMatAllocator() {
+  Trim();
+}
+// A buffer is laid out as OpenCV lays out its own: the pixels, then the
+// reference counter. The size class goes into the int after the counter, so
+// that deallocate(..) knows the free list of the buffer.
+void PoolingMatAllocator::allocate(int dims, const int *sizes, int type,
+                                   int *&refcount, uchar *&datastart,
+                                   uchar *&data, size_t *step) {
+  assert((dims > 0) && (sizes != nullptr) && (step != nullptr));
+  step[dims - 1] = CV_ELEM_SIZE(type);
+  for (int i = dims - 2; i >= 0; i--) {
+    step[i] = step[i + 1] * sizes[i + 1];
+  }
+  size_t pixel_bytes = cv::alignSize(step[0] * sizes[0], sizeof(int));
+  size_t class_bytes;
+  int size_class = SizeClassOf(pixel_bytes + 2 * sizeof(int), &class_bytes);
+  uchar *block = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if ((size_class < static_cast<int>(free_blocks_.size())) &&
+        !free_blocks_[size_class].empty()) {
+      block = free_blocks_[size_class].back();
+      free_blocks_[size_class].pop_back();
+      pooled_bytes_ -= class_bytes;
+      num_of_reuses_++;
+    } else {
+      num_of_allocations_++;
+    }
+  }
+  if (block == nullptr) {
+    block = static_cast<uchar*>(cv::fastMalloc(class_bytes));
+  }
+  datastart = data = block;
+  refcount = reinterpret_cast<int*>(block + pixel_bytes);
+  refcount[0] = 1;
+  refcount[1] = size_class;
+}
+// The free list grows only while the pool does, so giving a buffer back
+// allocates nothing once the loop is warm.
+void PoolingMatAllocator::deallocate(int *refcount, uchar *datastart,
+                                     uchar * /* data */) {
+  assert((refcount != nullptr) && (datastart != nullptr));
+  int size_class = refcount[1];
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (size_class >= static_cast<int>(free_blocks_.size())) {
+    free_blocks_.resize(size_class + 1);
+  }
+  free_blocks_[size_class].push_back(datastart);
+  pooled_bytes_ += BytesOfSizeClass(size_class);
+}
+
+void PoolingMatAllocator::Trim() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &blocks : free_blocks_) {
+    for (uchar *block : blocks) {
+      cv::fastFree(block);
+    }
+    blocks.clear();
+  }
+  pooled_bytes_ = 0;
+}
+
+int64_t PoolingMatAllocator::num_of_allocations() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_of_allocations_;
+}
+
+int64_t PoolingMatAllocator::num_of_reuses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_of_reuses_;
+}
+
+size_t PoolingMatAllocator::pooled_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pooled_bytes_;
+}
+
+int PoolingMatAllocator::SizeClassOf(const size_t &bytes,
+                                     size_t *class_bytes) {
+  assert(class_bytes != nullptr);
+  int size_class = 0;
+  while (BytesOfSizeClass(size_class) < bytes) {
+    size_class++;
+  }
+  *class_bytes = BytesOfSizeClass(size_class);
+  return size_class;
+}
+}  // namespace object_clustering
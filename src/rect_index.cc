@@ -0,0 +1,144 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// rect_index.cc
+// Object Clustering
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <vector>
+
+#include "rect_index.h"
+
+namespace object_clustering {
+namespace {
+// The grid has at most this many cells per rectangle, however sparse the
+// rectangles are:
+const int kMaxCellsPerRect = 4;
+
+bool IsEmpty(const cv::Rect &rect) {
+  return (rect.width <= 0) || (rect.height <= 0);
+}
+// SuppressNestedRects(..) over the rectangles already in index; only the
+// rectangles of the cell of the center are checked.
+// kept should not be NULL.
+void KeepOuterRects(const RectIndex &index, std::vector<int> *kept) {
+  assert(kept != nullptr);
+  kept->clear();
+  for (int i = 0; i < index.size(); i++) {
+    const cv::Rect &rect = index.rect(i);
+    cv::Point center(rect.x + rect.width/2, rect.y + rect.height/2);
+    bool nested = false;
+    index.ForEachContaining(center, [&](int j) {
+      if ((j != i) && (rect.area() < index.rect(j).area())) nested = true;
+    });
+    if (!nested) kept->push_back(i);
+  }
+}
+}  // namespace
+RectIndex::RectIndex(const std::vector<cv::Rect> &rectangles) {
+  Build(rectangles);
+}
+// 1. Find the bounds and the mean area of the rectangles;
+// 2. choose the cell side;
+// 3. list the rectangles of every cell, by counting them first, so that all
+// the lists share one buffer. Every rectangle is put at the start of its
+// cells, which moves the starts one cell ahead; they are moved back at the
+// end.
+void RectIndex::Build(const std::vector<cv::Rect> &rectangles) {
+  rectangles_ = rectangles;
+  bounds_ = cv::Rect();
+  cell_side_ = 1;
+  num_of_columns_ = 0;
+  num_of_rows_ = 0;
+  cell_starts_.clear();
+  cell_members_.clear();
+  // 1:
+  int num_of_rectangles = 0;
+  double total_area = 0;
+  for (const auto &rect : rectangles_) {
+    if (IsEmpty(rect)) continue;
+    bounds_ = num_of_rectangles == 0 ? rect : (bounds_ | rect);
+    total_area += rect.area();
+    num_of_rectangles++;
+  }
+  if (num_of_rectangles == 0) return;
+  // 2:
+  double cell_area = std::max(
+      total_area / num_of_rectangles,
+      static_cast<double>(bounds_.area()) /
+      (kMaxCellsPerRect * num_of_rectangles));
+  cell_side_ = std::max(1, static_cast<int>(std::ceil(std::sqrt(cell_area))));
+  num_of_columns_ = (bounds_.width + cell_side_ - 1) / cell_side_;
+  num_of_rows_ = (bounds_.height + cell_side_ - 1) / cell_side_;
+  // 3:
+  // the first and the last cell, in each direction, the rectangle overlaps:
+  auto cell_range = [this](const cv::Rect &rect, cv::Rect *range) {
+    range->x = (rect.x - bounds_.x) / cell_side_;
+    range->y = (rect.y - bounds_.y) / cell_side_;
+    range->width = (rect.x + rect.width - 1 - bounds_.x) / cell_side_ -
+                   range->x + 1;
+    range->height = (rect.y + rect.height - 1 - bounds_.y) / cell_side_ -
+                    range->y + 1;
+  };
+  cell_starts_.assign(num_of_columns_ * num_of_rows_ + 1, 0);
+  cv::Rect range;
+  for (const auto &rect : rectangles_) {
+    if (IsEmpty(rect)) continue;
+    cell_range(rect, &range);
+    for (int row = range.y; row < range.y + range.height; row++) {
+      for (int column = range.x; column < range.x + range.width; column++) {
+        cell_starts_[row * num_of_columns_ + column + 1]++;
+      }
+    }
+  }
+  for (size_t cell = 1; cell < cell_starts_.size(); cell++) {
+    cell_starts_[cell] += cell_starts_[cell - 1];
+  }
+  cell_members_.resize(cell_starts_.back());
+  for (int i = 0; i < size(); i++) {
+    if (IsEmpty(rectangles_[i])) continue;
+    cell_range(rectangles_[i], &range);
+    for (int row = range.y; row < range.y + range.height; row++) {
+      for (int column = range.x; column < range.x + range.width; column++) {
+        cell_members_[cell_starts_[row * num_of_columns_ + column]++] = i;
+      }
+    }
+  }
+  for (size_t cell = cell_starts_.size() - 1; cell > 0; cell--) {
+    cell_starts_[cell] = cell_starts_[cell - 1];
+  }
+  cell_starts_[0] = 0;
+}
+
+void RectIndex::FindContaining(const cv::Point &point,
+                               std::vector<int> *indices) const {
+  assert(indices != nullptr);
+  indices->clear();
+  ForEachContaining(point, [indices](int index) {
+    indices->push_back(index);
+  });
+}
+
+int RectIndex::CellOf(const cv::Point &point) const {
+  if ((num_of_columns_ == 0) || !bounds_.contains(point)) return -1;
+  int column = (point.x - bounds_.x) / cell_side_;
+  int row = (point.y - bounds_.y) / cell_side_;
+  return row * num_of_columns_ + column;
+}
+std::vector<int> SuppressNestedRects(const std::vector<cv::Rect> &rectangles) {
+  RectIndex index(rectangles);
+  std::vector<int> kept;
+  KeepOuterRects(index, &kept);
+  return kept;
+}
+
+void SuppressNestedRects(const std::vector<cv::Rect> &rectangles,
+                         RectIndex *index,
+                         std::vector<int> *kept) {
+  assert(index != nullptr);
+  assert(kept != nullptr);
+  index->Build(rectangles);
+  KeepOuterRects(*index, kept);
+}
+}  // namespace object_clustering
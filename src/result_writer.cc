@@ -0,0 +1,181 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// result_writer.cc
+// Object Clustering
+
+#include <cassert>
+#include <cstdint>
+
+#include <utility>
+
+#include "opencv2/highgui/highgui.hpp"
+
+#include "result_writer.h"
+
+namespace object_clustering {
+namespace {
+const int kRecordsBufferSize = 1 << 20;  // bytes
+// Well distinguishable BGR colors:
+const int kPaletteSize = 12;
+const unsigned char kPalette[kPaletteSize][3] = {
+  {0, 0, 255}, {0, 255, 0}, {255, 0, 0}, {0, 255, 255},
+  {255, 0, 255}, {255, 255, 0}, {0, 128, 255}, {255, 0, 128},
+  {128, 255, 0}, {128, 0, 255}, {0, 128, 128}, {128, 128, 0}
+};
+const cv::Scalar kNoGroupColor(128, 128, 128);
+
+cv::Scalar GroupColor(const int &group) {
+  if (group < 0) return kNoGroupColor;
+  const unsigned char *color = kPalette[group % kPaletteSize];
+  return cv::Scalar(color[0], color[1], color[2]);
+}
+
+std::string JsonEscape(const std::string &text) {
+  std::string result;
+  for (char c : text) {
+    if ((c == '"') || (c == '\\')) {
+      result += '\\';
+      result += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      result += escaped;
+    } else {
+      result += c;
+    }
+  }
+  return result;
+}
+}  // namespace
+
+cv::Mat AnnotateResult(const cv::Mat &image,
+                       const std::vector<Object> &objects) {
+  std::vector<cv::Rect> rects;
+  std::vector<int> groups;
+  for (const auto &object : objects) {
+    rects.push_back(object.image().bounding_rect());
+    groups.push_back(object.group());
+  }
+  return AnnotateResult(image, rects, groups);
+}
+// The objects may be views into the image, so the drawing is done on a copy:
+cv::Mat AnnotateResult(const cv::Mat &image,
+                       const std::vector<cv::Rect> &rects,
+                       const std::vector<int> &groups) {
+  assert(rects.size() == groups.size());
+  cv::Mat annotated = image.clone();
+  for (size_t i = 0; i < rects.size(); i++) {
+    rectangle(annotated,
+              rects[i].tl(),
+              rects[i].br(),
+              GroupColor(groups[i]),
+              kResultRectThickness,
+              8,
+              0);
+  }
+  return annotated;
+}
+
+ResultWriter::ResultWriter(const std::string &directory,
+                           const bool &write_images,
+                           const RecordFormat &format):
+  directory_(directory),
+  write_images_(write_images),
+  format_(format),
+  num_of_errors_(0),
+  queue_(kResultQueueCapacity) {
+  if (format_ != kNoRecords) {
+    std::string filename = directory_ + (format_ == kJsonRecords ?
+                                         "/results.json" : "/results.bin");
+    records_ = fopen(filename.c_str(), format_ == kJsonRecords ? "w" : "wb");
+    if (records_ != NULL) {
+      records_buffer_.resize(kRecordsBufferSize);
+      setvbuf(records_, &records_buffer_[0], _IOFBF, records_buffer_.size());
+    }
+  }
+  thread_ = std::thread(&ResultWriter::WriterLoop, this);
+}
+
+ResultWriter::~ResultWriter() {
+  Close();
+}
+// Only the rectangles and the groups are kept; the image is shared, not
+// copied:
+void ResultWriter::Write(const std::string &name,
+                         const cv::Mat &image,
+                         const std::vector<Object> &objects,
+                         const int &num_of_groups) {
+  Job job;
+  job.name = name;
+  job.image = image;
+  for (const auto &object : objects) {
+    job.rects.push_back(object.image().bounding_rect());
+    job.groups.push_back(object.group());
+  }
+  job.num_of_groups = num_of_groups;
+  queue_.Push(std::move(job));
+}
+
+void ResultWriter::Close() {
+  if (closed_) return;
+  closed_ = true;
+  queue_.Close();
+  thread_.join();
+  if (records_ != NULL) {
+    if (fclose(records_) != 0) num_of_errors_++;
+    records_ = NULL;
+  }
+}
+
+void ResultWriter::WriterLoop() {
+  Job job;
+  while (queue_.Pop(&job)) {
+    if (write_images_) {
+      cv::Mat annotated = AnnotateResult(job.image, job.rects, job.groups);
+      if (!cv::imwrite(directory_ + "/" + job.name + ".png", annotated)) {
+        num_of_errors_++;
+      }
+    }
+    if (records_ == NULL) continue;
+    if (format_ == kJsonRecords) {
+      WriteJsonRecord(job);
+    } else if (format_ == kBinaryRecords) {
+      WriteBinaryRecord(job);
+    }
+    if (ferror(records_)) {
+      num_of_errors_++;
+      clearerr(records_);
+    }
+  }
+}
+
+void ResultWriter::WriteJsonRecord(const Job &job) {
+  fprintf(records_, "{\"name\": \"%s\", \"num_of_groups\": %d, \"objects\": [",
+          JsonEscape(job.name).c_str(), job.num_of_groups);
+  for (size_t i = 0; i < job.rects.size(); i++) {
+    const cv::Rect &rect = job.rects[i];
+    fprintf(records_,
+            "%s{\"x\": %d, \"y\": %d, \"width\": %d, \"height\": %d, "
+            "\"group\": %d}",
+            i > 0 ? ", " : "",
+            rect.x, rect.y, rect.width, rect.height, job.groups[i]);
+  }
+  fprintf(records_, "]}\n");
+}
+
+void ResultWriter::WriteBinaryRecord(const Job &job) {
+  int32_t name_length = static_cast<int32_t>(job.name.size());
+  fwrite(&name_length, sizeof(name_length), 1, records_);
+  fwrite(job.name.data(), 1, job.name.size(), records_);
+  std::vector<int32_t> values;
+  values.push_back(job.num_of_groups);
+  values.push_back(static_cast<int32_t>(job.rects.size()));
+  for (size_t i = 0; i < job.rects.size(); i++) {
+    values.push_back(job.rects[i].x);
+    values.push_back(job.rects[i].y);
+    values.push_back(job.rects[i].width);
+    values.push_back(job.rects[i].height);
+    values.push_back(job.groups[i]);
+  }
+  fwrite(&values[0], sizeof(int32_t), values.size(), records_);
+}
+}  // namespace object_clustering
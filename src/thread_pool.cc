@@ -0,0 +1,102 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// thread_pool.cc
+// Object Clustering
+
+#include <cassert>
+
+#include <exception>
+#include <utility>
+
+#include "thread_pool.h"
+
+namespace object_clustering {
+ThreadPool::ThreadPool(const int &num_of_threads) {
+  int count = num_of_threads;
+  if (count <= 0) {
+    count = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  if (count <= 0) count = 1;
+  for (int i = 0; i < count; i++) {
+    threads_.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  task_available_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(!stopping_);
+    tasks_.push_back(std::move(task));
+  }
+  task_available_.notify_one();
+}
+
+void ThreadPool::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  all_done_.wait(lock, [this] {
+    return tasks_.empty() && (num_of_running_tasks_ == 0);
+  });
+}
+// Only the tasks of this call are waited for, so several callers can share the
+// pool. Every index is a task of its own, which balances uneven work. A task
+// which throws still counts as finished, so the wait always ends, and the
+// first exception is rethrown here after it.
+void ThreadPool::ParallelFor(const int &begin, const int &end,
+                             const std::function<void(int)> &body) {
+  if (begin >= end) return;
+  std::mutex done_mutex;
+  std::condition_variable done;
+  int remaining = end - begin;
+  std::exception_ptr first_error;  // guarded by done_mutex
+  for (int i = begin; i < end; i++) {
+    Submit([&, i]() {
+      std::exception_ptr error;
+      try {
+        body(i);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(done_mutex);
+      if (error && !first_error) first_error = error;
+      if (--remaining == 0) done.notify_one();
+    });
+  }
+  std::unique_lock<std::mutex> lock(done_mutex);
+  done.wait(lock, [&remaining] { return remaining == 0; });
+  if (first_error) std::rethrow_exception(first_error);
+}
+// The remaining tasks are run before the thread stops:
+void ThreadPool::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_available_.wait(lock, [this] {
+        return stopping_ || !tasks_.empty();
+      });
+      if (tasks_.empty()) return;  // stopping
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+      num_of_running_tasks_++;
+    }
+    task();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      num_of_running_tasks_--;
+      if (tasks_.empty() && (num_of_running_tasks_ == 0)) {
+        all_done_.notify_all();
+      }
+    }
+  }
+}
+}  // namespace object_clustering
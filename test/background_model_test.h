@@ -0,0 +1,136 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// background_model_test.h
+// Object clustering
+// A test class for BackgroundModel class.
+#ifndef OBJECT_CLUSTERING_BACKGROUND_MODEL_TEST_H_
+#define OBJECT_CLUSTERING_BACKGROUND_MODEL_TEST_H_
+
+#include <cassert>
+
+#include <string>
+#include <vector>
+
+#include "opencv2/video/background_segm.hpp"
+
+#include "background_model.h"
+#include "image.h"
+
+namespace object_clustering {
+class BackgroundModelTest {
+ public:
+  static bool TestBackgroundModel() {
+    BackgroundModelTest model_test;
+    return model_test.TestSameAsFreshSubtractor() &&
+           model_test.TestManyBackgrounds() &&
+           model_test.TestReuse() &&
+           model_test.TestRegion() &&
+           model_test.TestCoarse();
+  }
+  // A subtractor built for every image, the way it was done before: it
+  // learns the backgrounds at its default rate, and then compares the image
+  // at learning rate 0, the default of cv::BackgroundSubtractor:
+  cv::Mat FreshSubtractorMask(const Image &image,
+                              const std::vector<Image> &backgrounds) {
+    cv::Mat mask;
+    cv::BackgroundSubtractorMOG2 subtractor(kBackgroundHistory,
+                                            kBackgroundVarThreshold,
+                                            true);
+    subtractor.set("fVarInit", kBackgroundVarInit);
+    subtractor.set("fTau", kShadowThreshold);
+    for (const auto &background : backgrounds) {
+      subtractor(background.matrix(), mask);
+    }
+    subtractor(image.matrix(), mask, 0);
+    return mask;
+  }
+
+  cv::Mat FreshSubtractorMask(const Image &image, const Image &background) {
+    return FreshSubtractorMask(image, std::vector<Image>(1, background));
+  }
+  bool TestSameAsFreshSubtractor() {
+    for (int i = 1; i <= 2; i++) {
+      Image img("images/" + std::to_string(i) + "-2.png");
+      Image background("images/" + std::to_string(i) + "-1.png");
+      BackgroundModel model(background);
+      cv::Mat mask;
+      model.ComputeRawForegroundMask(img.matrix(), &mask);
+      assert(cv::norm(mask, FreshSubtractorMask(img, background),
+                      cv::NORM_INF) == 0);
+    }
+    return true;
+  }
+  // Backgrounds which differ give the pixels mixtures of several modes:
+  bool TestManyBackgrounds() {
+    for (int i = 1; i <= 2; i++) {
+      Image img("images/" + std::to_string(i) + "-2.png");
+      Image background("images/" + std::to_string(i) + "-1.png");
+      cv::Mat brighter = background.matrix() + cv::Scalar(60, 60, 60);
+      cv::Mat flipped;
+      cv::flip(background.matrix(), flipped, 0);
+      std::vector<Image> backgrounds = {background, Image(brighter),
+                                        Image(flipped), background};
+      BackgroundModel model(backgrounds);
+      cv::Mat mask;
+      model.ComputeRawForegroundMask(img.matrix(), &mask);
+      assert(cv::norm(mask, FreshSubtractorMask(img, backgrounds),
+                      cv::NORM_INF) == 0);
+    }
+    return true;
+  }
+  bool TestReuse() {
+    Image img("images/1-2.png");
+    Image background("images/1-1.png");
+    BackgroundModel model(background);
+    BackgroundModel model_copy(model);
+    cv::Mat first, second, third;
+    model.ComputeRawForegroundMask(img.matrix(), &first);
+    // the frames in between do not change the model:
+    model.ComputeRawForegroundMask(background.matrix(), &second);
+    assert(cv::countNonZero(second) == 0);
+    model_copy.ComputeRawForegroundMask(img.matrix(), &third);
+    assert(cv::norm(first, third, cv::NORM_INF) == 0);
+    return true;
+  }
+  bool TestRegion() {
+    Image img("images/2-2.png");
+    Image background("images/2-1.png");
+    BackgroundModel model(background);
+    cv::Mat whole;
+    model.ComputeRawForegroundMask(img.matrix(), &whole);
+    const cv::Mat &src = img.matrix();
+    const cv::Rect regions[] = {cv::Rect(0, 0, src.cols, src.rows),
+                                cv::Rect(0, 0, 1, 1),
+                                cv::Rect(17, 33, 200, 101),
+                                cv::Rect(src.cols - 50, src.rows - 7, 50, 7)};
+    for (const auto &region : regions) {
+      cv::Mat mask;
+      model.ComputeRawForegroundMask(src(region), region, &mask);
+      assert(cv::norm(mask, whole(region), cv::NORM_INF) == 0);
+    }
+    return true;
+  }
+  bool TestCoarse() {
+    Image img("images/1-2.png");
+    Image background("images/1-1.png");
+    BackgroundModel model(background);
+    cv::Mat coarse_image, coarse_background;
+    DownscaleFrame(img.matrix(), &coarse_image);
+    DownscaleFrame(background.matrix(), &coarse_background);
+    assert(coarse_image.cols ==
+           (img.matrix().cols + (1 << kCoarseLevels) - 1) >> kCoarseLevels);
+    assert(model.coarse_frame_size() == coarse_image.size());
+    // the same as a model of the downscaled background:
+    cv::Mat mask;
+    model.ComputeCoarseRawForegroundMask(coarse_image, &mask);
+    assert(cv::norm(mask, FreshSubtractorMask(Image(coarse_image),
+                                              Image(coarse_background)),
+                    cv::NORM_INF) == 0);
+    // and the model at full resolution is left as it was:
+    model.ComputeRawForegroundMask(img.matrix(), &mask);
+    assert(cv::norm(mask, FreshSubtractorMask(img, background),
+                    cv::NORM_INF) == 0);
+    return true;
+  }
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_BACKGROUND_MODEL_TEST_H_
@@ -0,0 +1,58 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// batch_processor_test.h
+// Object clustering
+// A test class for BatchProcessor class.
+#ifndef OBJECT_CLUSTERING_BATCH_PROCESSOR_TEST_H_
+#define OBJECT_CLUSTERING_BATCH_PROCESSOR_TEST_H_
+
+#include <cassert>
+
+#include <vector>
+
+#include "batch_processor.h"
+#include "k_means_clustering_algorithm.h"
+#include "object_detector.h"
+
+namespace object_clustering {
+class BatchProcessorTest {
+ public:
+  static bool TestBatchProcessor() {
+    BatchProcessorTest batch_test;
+    return batch_test.TestFindPairs() &&
+           batch_test.TestFailuresAreIsolated();
+  }
+  bool TestFindPairs() {
+    std::vector<BatchItem> items;
+    assert(FindBatchPairsInDirectory("images", &items));
+    assert(items.size() == 2);
+    assert(items[0].background_path == "images/1-1.png");
+    assert(items[0].image_path == "images/1-2.png");
+    assert(items[1].background_path == "images/2-1.png");
+    assert(!FindBatchPairsInDirectory("no_such_directory", &items));
+    assert(!ReadBatchManifest("no_such_manifest.txt", &items));
+    return true;
+  }
+  bool TestFailuresAreIsolated() {
+    std::vector<BatchItem> items(3);
+    items[0].background_path = "images/1-1.png";
+    items[0].image_path = "images/1-2.png";
+    items[1].background_path = "images/1-1.png";
+    items[1].image_path = "images/no_such_image.png";
+    items[2].background_path = "images/2-1.png";
+    items[2].image_path = "images/2-2.png";
+    ObjectDetector detector;
+    KMeansClusteringAlgorithm clusterer;
+    BatchProcessor processor(detector, clusterer, 2);
+    auto results = processor.Process(items);
+    assert(results.size() == 3);
+    assert(results[0].succeeded);
+    assert(results[0].rects.size() == results[0].groups.size());
+    assert(!results[1].succeeded);
+    assert(!results[1].error.empty());
+    assert(results[2].succeeded);
+    assert(results[2].index == 2);
+    return true;
+  }
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_BATCH_PROCESSOR_TEST_H_
@@ -0,0 +1,147 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// bounded_queue_test.h
+// Object clustering
+// A test class for BoundedQueue class.
+#ifndef OBJECT_CLUSTERING_BOUNDED_QUEUE_TEST_H_
+#define OBJECT_CLUSTERING_BOUNDED_QUEUE_TEST_H_
+
+#include <cassert>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.h"
+
+namespace object_clustering {
+class BoundedQueueTest {
+ public:
+  static bool TestBoundedQueue() {
+    BoundedQueueTest queue_test;
+    return queue_test.TestOrder() &&
+           queue_test.TestBlockingWhenFull() &&
+           queue_test.TestCloseWhileWaiting() &&
+           queue_test.TestManyThreads();
+  }
+  // Long enough for a thread which is not blocked to get going:
+  void Wait() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  bool TestOrder() {
+    BoundedQueue<int> queue(3);
+    for (int i = 0; i < 3; i++) {
+      assert(queue.Push(i));
+    }
+    int item;
+    for (int i = 0; i < 3; i++) {
+      assert(queue.Pop(&item));
+      assert(item == i);
+    }
+    // the remaining items are taken after Close(), new ones are refused:
+    assert(queue.Push(3));
+    queue.Close();
+    assert(!queue.Push(4));
+    assert(queue.Pop(&item));
+    assert(item == 3);
+    assert(!queue.Pop(&item));
+    return true;
+  }
+  bool TestBlockingWhenFull() {
+    BoundedQueue<int> queue(2);
+    assert(queue.Push(0) && queue.Push(1));
+    std::atomic<bool> pushed(false);
+    std::thread producer([&]() {
+      assert(queue.Push(2));
+      pushed = true;
+    });
+    Wait();
+    assert(!pushed);  // the queue is full
+    int item;
+    assert(queue.Pop(&item));
+    assert(item == 0);
+    producer.join();
+    assert(pushed);
+    assert(queue.Pop(&item) && (item == 1));
+    assert(queue.Pop(&item) && (item == 2));
+    return true;
+  }
+  // Close() wakes the producer waiting on a full queue and the consumer
+  // waiting on an empty one:
+  bool TestCloseWhileWaiting() {
+    BoundedQueue<int> full(1);
+    assert(full.Push(0));
+    std::atomic<int> push_result(-1);
+    std::thread producer([&]() { push_result = full.Push(1) ? 1 : 0; });
+    Wait();
+    assert(push_result == -1);
+    full.Close();
+    producer.join();
+    assert(push_result == 0);
+    int item;
+    assert(full.Pop(&item) && (item == 0));
+    assert(!full.Pop(&item));
+
+    BoundedQueue<int> empty(1);
+    std::atomic<int> pop_result(-1);
+    std::thread consumer([&]() {
+      int popped;
+      pop_result = empty.Pop(&popped) ? 1 : 0;
+    });
+    Wait();
+    assert(pop_result == -1);
+    empty.Close();
+    consumer.join();
+    assert(pop_result == 0);
+    return true;
+  }
+  // Every item pushed by a producer comes out exactly once, and the ones of
+  // one producer in the order it pushed them:
+  bool TestManyThreads() {
+    const int kNumOfProducers = 3;
+    const int kNumOfConsumers = 3;
+    const int kNumOfItems = 2000;  // per producer
+    BoundedQueue<int> queue(4);
+    std::vector<std::vector<int>> popped(kNumOfConsumers);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kNumOfConsumers; i++) {
+      threads.push_back(std::thread([&, i]() {
+        int item;
+        while (queue.Pop(&item)) {
+          popped[i].push_back(item);
+        }
+      }));
+    }
+    std::vector<std::thread> producers;
+    for (int i = 0; i < kNumOfProducers; i++) {
+      producers.push_back(std::thread([&, i]() {
+        for (int j = 0; j < kNumOfItems; j++) {
+          assert(queue.Push(i * kNumOfItems + j));
+        }
+      }));
+    }
+    for (auto &producer : producers) {
+      producer.join();
+    }
+    queue.Close();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::vector<int> times_popped(kNumOfProducers * kNumOfItems, 0);
+    for (const auto &items : popped) {
+      std::vector<int> last(kNumOfProducers, -1);
+      for (int item : items) {
+        times_popped[item]++;
+        // a consumer sees the items of a producer in order:
+        assert(item > last[item / kNumOfItems]);
+        last[item / kNumOfItems] = item;
+      }
+    }
+    for (int times : times_popped) {
+      assert(times == 1);
+    }
+    return true;
+  }
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_BOUNDED_QUEUE_TEST_H_
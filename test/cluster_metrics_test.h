@@ -0,0 +1,79 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// cluster_metrics_test.h
+// Object clustering
+// A test class for ComputeClusterMetrics(..).
+#ifndef OBJECT_CLUSTERING_CLUSTER_METRICS_TEST_H_
+#define OBJECT_CLUSTERING_CLUSTER_METRICS_TEST_H_
+
+#include <cassert>
+#include <cmath>
+
+#include <vector>
+
+#include "cluster_metrics.h"
+#include "k_means_clustering_algorithm_test.h"
+
+namespace object_clustering {
+class ClusterMetricsTest {
+ public:
+  static bool TestClusterMetrics() {
+    ClusterMetricsTest metrics_test;
+    return metrics_test.TestTwoClusters() &&
+           metrics_test.TestSingleCluster() &&
+           metrics_test.TestCriteria();
+  }
+  // Rows 0 and 0.2 around 0.1, rows 1 and 1.2 around 1.1:
+  bool TestTwoClusters() {
+    FeatureMatrix data(4, 2);
+    data.at(1, 0) = 0.2;
+    data.at(2, 0) = 1;
+    data.at(3, 0) = 1.2;
+    FeatureMatrix centers(2, 2);
+    centers.at(0, 0) = 0.1;
+    centers.at(1, 0) = 1.1;
+    std::vector<int> labels = {0, 0, 1, 1};
+    ClusterMetrics metrics;
+    ComputeClusterMetrics(data, labels, centers, kSilhouetteSampleSize,
+                          &metrics);
+    assert(std::fabs(metrics.inertia - 0.04) < 1e-6);
+    assert(std::fabs(metrics.mean_distance - 0.1) < 1e-6);
+    assert(std::fabs(metrics.davies_bouldin - 0.2) < 1e-6);
+    // (0.9 / 1.1 + 0.7 / 0.9) / 2:
+    assert(std::fabs(metrics.silhouette - 0.79798) < 1e-4);
+    // without the silhouette:
+    ComputeClusterMetrics(data, labels, centers, 0, &metrics);
+    assert(metrics.silhouette == 0);
+    assert(std::fabs(metrics.davies_bouldin - 0.2) < 1e-6);
+    return true;
+  }
+  bool TestSingleCluster() {
+    FeatureMatrix data(3, 2);
+    data.at(1, 1) = 1;
+    FeatureMatrix centers(1, 2);
+    std::vector<int> labels(3, 0);
+    ClusterMetrics metrics;
+    ComputeClusterMetrics(data, labels, centers, kSilhouetteSampleSize,
+                          &metrics);
+    assert(std::fabs(metrics.inertia - 1) < 1e-6);
+    assert((metrics.davies_bouldin == 0) && (metrics.silhouette == 0));
+    return true;
+  }
+  // Every criterion finds the three groups:
+  bool TestCriteria() {
+    for (auto criterion : {kMeanDistanceCriterion, kInertiaCriterion,
+                           kDaviesBouldinCriterion, kSilhouetteCriterion}) {
+      KMeansClusteringAlgorithm k;
+      k.set_k_selection_criterion(criterion);
+      FeatureMatrix training_set;
+      std::vector<Object> objects;
+      KMeansClusteringAlgorithmTest::SeparatedTrainingSet(&training_set,
+                                                          &objects);
+      assert(KMeansClusteringAlgorithmTest::Cluster(k, training_set,
+                                                    &objects) == 3);
+    }
+    return true;
+  }
+};
+}  // namespace object_clustering
+
+#endif  // OBJECT_CLUSTERING_CLUSTER_METRICS_TEST_H_
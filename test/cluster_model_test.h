@@ -0,0 +1,158 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// cluster_model_test.h
+// Object clustering
+// A test class for ClusterModel class.
+#ifndef OBJECT_CLUSTERING_CLUSTER_MODEL_TEST_H_
+#define OBJECT_CLUSTERING_CLUSTER_MODEL_TEST_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "cluster_model.h"
+#include "feature_matrix.h"
+#include "native_k_means_clustering_algorithm.h"
+
+namespace object_clustering {
+class ClusterModelTest {
+ public:
+  static bool TestClusterModel() {
+    ClusterModelTest model_test;
+    return model_test.TestAssign() &&
+           model_test.TestSaveLoad() &&
+           model_test.TestAlign() &&
+           model_test.TestTrainModel();
+  }
+  // A model which does not scale the features, with center k at k on
+  // feature k:
+  ClusterModel SampleModel(const int &num_of_clusters) {
+    FeatureVector max_feature_value, avg_feature_value;
+    max_feature_value.fill(1);
+    avg_feature_value.fill(0);
+    FeatureMatrix centers(num_of_clusters, kNumberOfFeatures);
+    for (int k = 0; k < num_of_clusters; k++) {
+      centers.at(k, k) = k;
+    }
+    return ClusterModel(max_feature_value, avg_feature_value, centers, 0.5);
+  }
+  bool TestAssign() {
+    ClusterModel model = SampleModel(3);
+    assert(!model.empty());
+    assert(ClusterModel().empty());
+    FeatureVector features;
+    features.fill(0);
+    features[2] = 1.5;
+    float distance;
+    assert(model.Assign(features, &distance) == 2);
+    assert(std::abs(distance - 0.5) < 1e-6);
+    features[2] = 0.2;
+    assert(model.Assign(features, nullptr) == 0);
+    // the normalization is the one of the training set:
+    FeatureVector max_feature_value, avg_feature_value;
+    max_feature_value.fill(10);
+    max_feature_value[5] = 0;
+    avg_feature_value.fill(4);
+    float row[kNumberOfFeatures];
+    for (int j = 0; j < kNumberOfFeatures; j++) {
+      row[j] = 9;
+    }
+    NormalizeFeatureRow(max_feature_value, avg_feature_value, row);
+    assert(std::abs(row[0] - 0.5) < 1e-6);
+    assert(std::abs(row[5] - 0.99) < 1e-6);
+    return true;
+  }
+  bool TestSaveLoad() {
+    const std::string filename = "cluster_model_test.yml";
+    ClusterModel model = SampleModel(4);
+    assert(model.Save(filename));
+    ClusterModel loaded;
+    assert(loaded.Load(filename));
+    assert(loaded.num_of_clusters() == 4);
+    assert(loaded.training_error() == model.training_error());
+    for (int j = 0; j < kNumberOfFeatures; j++) {
+      assert(loaded.max_feature_value()[j] == model.max_feature_value()[j]);
+      assert(loaded.avg_feature_value()[j] == model.avg_feature_value()[j]);
+      for (int k = 0; k < 4; k++) {
+        assert(loaded.centers().at(k, j) == model.centers().at(k, j));
+      }
+    }
+    // a file which is not a model leaves the model as it was:
+    assert(!loaded.Load("no_such_model.yml"));
+    FILE *file = fopen(filename.c_str(), "w");
+    assert(file != NULL);
+    fprintf(file, "%%YAML:1.0\nversion: 1\nnum_of_features: 3\n");
+    fclose(file);
+    assert(!loaded.Load(filename));
+    assert(loaded.num_of_clusters() == 4);
+    std::remove(filename.c_str());
+    return true;
+  }
+  // A model whose clusters are renumbered gets the numbers back, and the
+  // clusters which are new or gone leave the numbers in [0; K):
+  bool TestAlign() {
+    ClusterModel previous = SampleModel(3);
+    FeatureMatrix centers(3, kNumberOfFeatures);
+    int order[3] = {2, 0, 1};
+    for (int k = 0; k < 3; k++) {
+      centers.at(k, order[k]) = order[k] + 0.01f;
+    }
+    ClusterModel model(previous.max_feature_value(),
+                       previous.avg_feature_value(), centers, 0.5);
+    model.AlignTo(previous);
+    for (int k = 0; k < 3; k++) {
+      assert(std::abs(model.centers().at(k, k) - (k + 0.01f)) < 1e-6);
+    }
+    // one more cluster takes the next number:
+    ClusterModel bigger = SampleModel(4);
+    bigger.AlignTo(previous);
+    assert(bigger.centers().at(3, 3) == 3);
+    // with one cluster less, the number of the lost one is given away:
+    FeatureMatrix smaller_centers(2, kNumberOfFeatures);
+    smaller_centers.at(0, 2) = 2;
+    smaller_centers.at(1, 1) = 1;
+    ClusterModel smaller(previous.max_feature_value(),
+                         previous.avg_feature_value(), smaller_centers, 0.5);
+    smaller.AlignTo(previous);
+    assert(smaller.centers().at(1, 1) == 1);
+    assert(smaller.centers().at(0, 2) == 2);
+    return true;
+  }
+  // A model trained on three groups labels their examples, and new examples
+  // near them, as the clustering did:
+  bool TestTrainModel() {
+    const int n = 30;
+    FeatureMatrix features(n, kNumberOfFeatures);
+    for (int i = 0; i < n; i++) {
+      features.at(i, i % 3) = 100;
+      features.at(i, 3) = static_cast<float>(i % 5);
+    }
+    NativeKMeansClusteringAlgorithm k;
+    ClusterModel model;
+    assert(k.TrainModel(features, &model) == 3);
+    assert(model.num_of_clusters() == 3);
+    assert(model.training_error() >= 0);
+    FeatureVector example;
+    int groups[3];
+    for (int g = 0; g < 3; g++) {
+      example.fill(0);
+      example[g] = 100;
+      groups[g] = model.Assign(example, nullptr);
+      example[3] = 2;
+      assert(model.Assign(example, nullptr) == groups[g]);
+      example[g] = 90;
+      assert(model.Assign(example, nullptr) == groups[g]);
+    }
+    assert((groups[0] != groups[1]) && (groups[1] != groups[2]) &&
+           (groups[0] != groups[2]));
+    ClusterModel empty_model = model;
+    assert(k.TrainModel(FeatureMatrix(), &empty_model) == 0);
+    assert(empty_model.empty());
+    return true;
+  }
+};
+}  // namespace object_clustering
+
+#endif  // OBJECT_CLUSTERING_CLUSTER_MODEL_TEST_H_
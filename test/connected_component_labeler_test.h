@@ -0,0 +1,123 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// connected_component_labeler_test.h
+// Object clustering
+// A test class for ConnectedComponentLabeler class.
+#ifndef OBJECT_CLUSTERING_CONNECTED_COMPONENT_LABELER_TEST_H_
+#define OBJECT_CLUSTERING_CONNECTED_COMPONENT_LABELER_TEST_H_
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <vector>
+
+#include "connected_component_labeler.h"
+
+namespace object_clustering {
+class ConnectedComponentLabelerTest {
+ public:
+  static bool TestConnectedComponentLabeler() {
+    ConnectedComponentLabelerTest labeler_test;
+    return labeler_test.TestSeparateBlobs() &&
+           labeler_test.TestDiagonalAndUShapedBlobs() &&
+           labeler_test.TestThreshold() &&
+           labeler_test.TestBands();
+  }
+  bool TestSeparateBlobs() {
+    cv::Mat m = cv::Mat::zeros(20, 30, CV_8UC1);
+    m(cv::Rect(2, 3, 4, 5)).setTo(cv::Scalar(255));
+    m(cv::Rect(10, 1, 10, 2)).setTo(cv::Scalar(255));
+    ConnectedComponentLabeler labeler;
+    std::vector<BlobStats> blobs;
+    labeler.LabelBlobs(m, 0, &blobs);
+    assert(blobs.size() == 2);
+    // ordered by the first pixel:
+    assert(blobs[0].bounding_rect == cv::Rect(10, 1, 10, 2));
+    assert(blobs[0].area == 20);
+    assert(blobs[0].centroid == cv::Point2d(14.5, 1.5));
+    assert(blobs[1].bounding_rect == cv::Rect(2, 3, 4, 5));
+    assert(blobs[1].area == 20);
+    assert(blobs[1].centroid == cv::Point2d(3.5, 5));
+    // the labeler can be reused:
+    labeler.LabelBlobs(cv::Mat::zeros(5, 5, CV_8UC1), 0, &blobs);
+    assert(blobs.empty());
+    return true;
+  }
+  bool TestDiagonalAndUShapedBlobs() {
+    cv::Mat m = cv::Mat::zeros(10, 10, CV_8UC1);
+    // a diagonal line is one blob with 8-connectivity:
+    for (int i = 0; i < 4; i++) {
+      m.at<uchar>(i, i) = 255;
+    }
+    // the two arms of a "U" are joined only in the last row:
+    m(cv::Rect(6, 5, 1, 5)).setTo(cv::Scalar(255));
+    m(cv::Rect(9, 5, 1, 5)).setTo(cv::Scalar(255));
+    m(cv::Rect(6, 9, 4, 1)).setTo(cv::Scalar(255));
+    ConnectedComponentLabeler labeler;
+    std::vector<BlobStats> blobs;
+    labeler.LabelBlobs(m, 0, &blobs);
+    assert(blobs.size() == 2);
+    assert(blobs[0].area == 4);
+    assert(blobs[0].bounding_rect == cv::Rect(0, 0, 4, 4));
+    assert(blobs[1].area == 12);
+    assert(blobs[1].bounding_rect == cv::Rect(6, 5, 4, 5));
+    return true;
+  }
+  bool TestThreshold() {
+    cv::Mat m = cv::Mat::zeros(4, 8, CV_8UC1);
+    m(cv::Rect(0, 0, 3, 3)).setTo(cv::Scalar(100));
+    m(cv::Rect(4, 0, 3, 3)).setTo(cv::Scalar(200));
+    ConnectedComponentLabeler labeler;
+    std::vector<BlobStats> blobs;
+    labeler.LabelBlobs(m, 99, &blobs);
+    assert(blobs.size() == 2);
+    labeler.LabelBlobs(m, 100, &blobs);
+    assert(blobs.size() == 1);
+    assert(blobs[0].bounding_rect == cv::Rect(4, 0, 3, 3));
+    labeler.LabelBlobs(m, 255, &blobs);
+    assert(blobs.empty());
+    return true;
+  }
+  bool TestBands() {
+    // a "U", a diagonal line, and blobs which cross every band border:
+    cv::Mat m = cv::Mat::zeros(23, 17, CV_8UC1);
+    m(cv::Rect(1, 0, 1, 9)).setTo(cv::Scalar(255));
+    m(cv::Rect(5, 0, 1, 9)).setTo(cv::Scalar(255));
+    m(cv::Rect(1, 8, 5, 1)).setTo(cv::Scalar(255));
+    for (int i = 0; i < 10; i++) {
+      m.at<uchar>(10 + i, 3 + i) = 200;
+    }
+    cv::RNG rng(17);
+    for (int y = 0; y < m.rows; y++) {
+      for (int x = 13; x < m.cols; x++) {
+        m.at<uchar>(y, x) = rng.uniform(0, 2) * 255;
+      }
+    }
+    ConnectedComponentLabeler labeler;
+    for (int threshold : {0, 199}) {
+      std::vector<BlobStats> expected;
+      labeler.LabelBlobs(m, threshold, &expected);
+      for (int band_height : {1, 2, 5, 8, 23, 40}) {
+        std::vector<BandBlobs> bands;
+        for (int y = 0; y < m.rows; y += band_height) {
+          bands.push_back(BandBlobs());
+          labeler.LabelBand(m, threshold, y, std::min(y + band_height, m.rows),
+                            &bands.back());
+        }
+        std::vector<BlobStats> blobs;
+        MergeBands(bands, &blobs);
+        // the same blobs, in the same order:
+        assert(blobs.size() == expected.size());
+        for (size_t i = 0; i < blobs.size(); i++) {
+          assert(blobs[i].area == expected[i].area);
+          assert(blobs[i].bounding_rect == expected[i].bounding_rect);
+          assert(std::abs(blobs[i].centroid.x - expected[i].centroid.x) < 1e-9);
+          assert(std::abs(blobs[i].centroid.y - expected[i].centroid.y) < 1e-9);
+        }
+      }
+    }
+    return true;
+  }
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_CONNECTED_COMPONENT_LABELER_TEST_H_
@@ -0,0 +1,106 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// feature_descriptor_test.h
+// Object clustering
+// A test class for the feature extractors and FeatureDescriptor.
+#ifndef OBJECT_CLUSTERING_FEATURE_DESCRIPTOR_TEST_H_
+#define OBJECT_CLUSTERING_FEATURE_DESCRIPTOR_TEST_H_
+
+#include <cassert>
+#include <cmath>
+
+#include <vector>
+
+#include "feature_descriptor.h"
+#include "feature_matrix.h"
+#include "image.h"
+#include "integral_color_image.h"
+#include "object.h"
+
+namespace object_clustering {
+class FeatureDescriptorTest {
+ public:
+  static bool TestFeatureDescriptor() {
+    FeatureDescriptorTest descriptor_test;
+    return descriptor_test.TestWidth() &&
+           descriptor_test.TestExtractFeatures() &&
+           descriptor_test.TestIntegralColorImage() &&
+           descriptor_test.TestFeaturesOfFrame();
+  }
+  bool TestWidth() {
+    static_assert(FeatureDescriptor<>::kWidth == 0, "empty descriptor");
+    static_assert(FeatureDescriptor<SizeFeatures, ShapeFeatures>::kWidth == 4,
+                  "widths add up");
+    static_assert(kNumberOfFeatures == 22, "the features of an object");
+    return true;
+  }
+  // A 20 x 10 image of one color:
+  bool TestExtractFeatures() {
+    Image image(cv::Mat(10, 20, CV_8UC3, cv::Scalar(1, 2, 3)));
+    FeatureVector features = ExtractFeatures(image);
+    int j = 0;
+    assert(features[j++] == 20);
+    assert(features[j++] == 10);
+    for (int region = 0; region < RegionColorFeatures::kNumberOfRegions;
+         region++) {
+      assert(features[j++] == 1);
+      assert(features[j++] == 2);
+      assert(features[j++] == 3);
+    }
+    assert(features[j++] == 10);
+    assert(features[j++] == 400);
+    assert(j == kNumberOfFeatures);
+    return true;
+  }
+  // A frame whose every pixel has a color of its own:
+  static cv::Mat PatternFrame() {
+    cv::Mat frame(60, 80, CV_8UC3);
+    for (int y = 0; y < frame.rows; y++) {
+      for (int x = 0; x < frame.cols; x++) {
+        frame.at<cv::Vec3b>(y, x) = cv::Vec3b((x * 7 + y) % 256,
+                                              (x * y) % 256,
+                                              (x + y * 13) % 256);
+      }
+    }
+    return frame;
+  }
+  bool TestIntegralColorImage() {
+    cv::Mat frame = PatternFrame();
+    IntegralColorImage integral(frame, cv::Rect(10, 5, 50, 40));
+    for (const auto &rect : {cv::Rect(10, 5, 50, 40), cv::Rect(12, 7, 1, 1),
+                             cv::Rect(20, 30, 13, 9)}) {
+      cv::Scalar expected = cv::mean(frame(rect));
+      cv::Scalar mean = integral.Mean(rect);
+      for (int channel = 0; channel < 3; channel++) {
+        assert(std::fabs(mean[channel] - expected[channel]) < 1e-9);
+      }
+    }
+    assert(integral.Mean(cv::Rect(20, 20, 0, 0)) == cv::Scalar());
+    assert(!integral.Contains(cv::Rect(0, 0, 20, 20)));
+    return true;
+  }
+  // The objects cut out of a frame get the features they would get alone:
+  bool TestFeaturesOfFrame() {
+    cv::Mat frame = PatternFrame();
+    std::vector<Object> objects;
+    for (const auto &rect : {cv::Rect(3, 4, 20, 15), cv::Rect(30, 10, 41, 33),
+                             cv::Rect(50, 40, 9, 17)}) {
+      objects.push_back(Object(Image(frame(rect), rect)));
+    }
+    // and one of another frame:
+    objects.push_back(Object(Image(cv::Mat(10, 20, CV_8UC3,
+                                           cv::Scalar(1, 2, 3)))));
+    FeatureMatrix features(static_cast<int>(objects.size()),
+                           kNumberOfFeatures);
+    ExtractFeatures(objects, &features);
+    for (int i = 0; i < features.rows(); i++) {
+      FeatureVector expected = ExtractFeatures(objects[i].image());
+      for (int j = 0; j < kNumberOfFeatures; j++) {
+        assert(std::fabs(features.at(i, j) - expected[j]) < 1e-3);
+      }
+    }
+    return true;
+  }
+};
+}  // namespace object_clustering
+
+#endif  // OBJECT_CLUSTERING_FEATURE_DESCRIPTOR_TEST_H_
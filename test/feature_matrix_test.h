@@ -0,0 +1,72 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// feature_matrix_test.h
+// Object clustering
+// A test class for FeatureMatrix class and its distance kernels.
+#ifndef OBJECT_CLUSTERING_FEATURE_MATRIX_TEST_H_
+#define OBJECT_CLUSTERING_FEATURE_MATRIX_TEST_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include "feature_matrix.h"
+
+namespace object_clustering {
+class FeatureMatrixTest {
+ public:
+  static bool TestFeatureMatrix() {
+    FeatureMatrixTest matrix_test;
+    return matrix_test.TestLayout() &&
+           matrix_test.TestKernels();
+  }
+  bool TestLayout() {
+    FeatureMatrix m(3, 22);
+    assert((m.rows() == 3) && (m.cols() == 22) && (m.stride() == 24));
+    for (int i = 0; i < m.rows(); i++) {
+      assert(reinterpret_cast<std::uintptr_t>(m.row(i)) %
+             kFeatureAlignment == 0);
+      for (int j = 0; j < m.stride(); j++) {
+        assert(m.row(i)[j] == 0);
+      }
+    }
+    m.at(1, 2) = 5;
+    // copies are deep, the header is not:
+    FeatureMatrix copy(m);
+    copy.at(1, 2) = 6;
+    assert(m.at(1, 2) == 5);
+    cv::Mat header = m.matrix();
+    assert((header.rows == 3) && (header.cols == 22));
+    assert(header.at<float>(1, 2) == 5);
+    return true;
+  }
+  bool TestKernels() {
+    FeatureMatrix m(2, 22);
+    for (int j = 0; j < m.cols(); j++) {
+      m.at(0, j) = 0.1f * j;
+      m.at(1, j) = -0.05f * j;
+    }
+    float expected = 0;
+    for (int j = 0; j < m.cols(); j++) {
+      expected += (m.at(0, j) - m.at(1, j)) * (m.at(0, j) - m.at(1, j));
+    }
+    float distance = SquaredDistance(m.row(0), m.row(1), m.stride());
+    assert(std::fabs(distance - expected) <= 1e-4f * expected);
+    float nearest_distance;
+    assert(NearestRow(m.row(1), m, &nearest_distance) == 1);
+    assert(nearest_distance == 0);
+    AddRow(m.row(0), m.stride(), m.row(1));
+    ScaleRow(2, m.stride(), m.row(1));
+    SubtractRow(m.row(0), m.stride(), m.row(1));
+    for (int j = 0; j < m.cols(); j++) {
+      assert(std::fabs(m.at(1, j) - 0.1f * j) <= 1e-5f);
+    }
+    // the padding stays zero:
+    for (int j = m.cols(); j < m.stride(); j++) {
+      assert(m.row(1)[j] == 0);
+    }
+    return true;
+  }
+};
+}  // namespace object_clustering
+
+#endif  // OBJECT_CLUSTERING_FEATURE_MATRIX_TEST_H_
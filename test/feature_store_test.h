@@ -0,0 +1,216 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// feature_store_test.h
+// Object clustering
+// A test class for the feature store classes, and for the clustering of a
+// store by MiniBatchKMeansClusteringAlgorithm.
+#ifndef OBJECT_CLUSTERING_FEATURE_STORE_TEST_H_
+#define OBJECT_CLUSTERING_FEATURE_STORE_TEST_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "feature_descriptor.h"
+#include "feature_store.h"
+#include "image.h"
+#include "mini_batch_k_means_clustering_algorithm.h"
+#include "object.h"
+
+namespace object_clustering {
+class FeatureStoreTest {
+ public:
+  static bool TestFeatureStore() {
+    FeatureStoreTest store_test;
+    return store_test.TestRoundTrip() &&
+           store_test.TestCutRow() &&
+           store_test.TestInvalidFiles() &&
+           store_test.TestObjects() &&
+           store_test.TestClusterStore();
+  }
+  // The features of row i of the tests; group is the feature which is set:
+  FeatureVector SampleFeatures(const int &i, const int &group) {
+    FeatureVector features;
+    features.fill(0);
+    features[group] = 100;
+    features[3] = static_cast<float>(i % 7);
+    return features;
+  }
+  // Appends num_of_rows rows; row i is in group i % 3:
+  void AppendSampleRows(const int &first_row,
+                        const int &num_of_rows,
+                        FeatureStoreWriter *writer) {
+    for (int i = first_row; i < first_row + num_of_rows; i++) {
+      assert(writer->Append(i / 10, cv::Rect(i, 2 * i, 3, 4),
+                            SampleFeatures(i, i % 3)));
+    }
+  }
+  // Rows are appended across writers, and read back by rows and by chunks:
+  bool TestRoundTrip() {
+    const std::string filename = "feature_store_test.features";
+    std::remove(filename.c_str());
+    {
+      FeatureStoreWriter writer(filename);
+      assert(writer.IsOpened());
+      AppendSampleRows(0, 10, &writer);
+      assert(writer.num_of_rows() == 10);
+      assert(writer.Flush());
+      // the flushed rows are seen by a new mapping:
+      MappedFeatureStore store(filename);
+      assert(store.IsOpened());
+      assert(store.num_of_rows() == 10);
+      assert(writer.Close());
+    }
+    {
+      FeatureStoreWriter writer(filename);
+      assert(writer.IsOpened());
+      AppendSampleRows(10, 25, &writer);
+      assert(writer.num_of_rows() == 25);
+    }
+    MappedFeatureStore store(filename);
+    assert(store.IsOpened());
+    assert(store.num_of_rows() == 35);
+    for (int i = 0; i < 35; i++) {
+      const FeatureStoreRow &row = store.row(i);
+      assert(row.frame_id == i / 10);
+      assert(row.rect() == cv::Rect(i, 2 * i, 3, 4));
+      FeatureVector features = SampleFeatures(i, i % 3);
+      for (int j = 0; j < kNumberOfFeatures; j++) {
+        assert(row.features[j] == features[j]);
+      }
+    }
+    // the last chunk is cut at the end of the store:
+    FeatureMatrix chunk;
+    assert(store.ReadChunk(0, 16, &chunk) == 16);
+    assert((chunk.rows() == 16) && (chunk.cols() == kNumberOfFeatures));
+    assert(store.ReadChunk(32, 16, &chunk) == 3);
+    assert(chunk.rows() == 3);
+    for (int j = 0; j < kNumberOfFeatures; j++) {
+      assert(chunk.at(2, j) == store.row(34).features[j]);
+    }
+    std::remove(filename.c_str());
+    return true;
+  }
+  // A row cut short is not read, and the next writer overwrites it:
+  bool TestCutRow() {
+    const std::string filename = "feature_store_test.features";
+    std::remove(filename.c_str());
+    {
+      FeatureStoreWriter writer(filename);
+      AppendSampleRows(0, 5, &writer);
+    }
+    FILE *file = fopen(filename.c_str(), "ab");
+    assert(file != NULL);
+    const char half_row[sizeof(FeatureStoreRow) / 2] = {0};
+    fwrite(half_row, sizeof(half_row), 1, file);
+    fclose(file);
+    {
+      MappedFeatureStore store(filename);
+      assert(store.IsOpened());
+      assert(store.num_of_rows() == 5);
+    }
+    {
+      FeatureStoreWriter writer(filename);
+      assert(writer.IsOpened());
+      AppendSampleRows(5, 1, &writer);
+    }
+    MappedFeatureStore store(filename);
+    assert(store.num_of_rows() == 6);
+    assert(store.row(5).rect() == cv::Rect(5, 10, 3, 4));
+    std::remove(filename.c_str());
+    return true;
+  }
+  // Files which are not stores are opened neither for reading nor for
+  // appending, and are not changed:
+  bool TestInvalidFiles() {
+    const std::string filename = "feature_store_test.features";
+    assert(!MappedFeatureStore("no_such_store.features").IsOpened());
+    FILE *file = fopen(filename.c_str(), "wb");
+    assert(file != NULL);
+    const char text[] = "not a feature store, just some text";
+    fwrite(text, sizeof(text), 1, file);
+    fclose(file);
+    assert(!MappedFeatureStore(filename).IsOpened());
+    assert(!FeatureStoreWriter(filename).IsOpened());
+    assert(!MappedFeatureStore(filename).IsOpened());
+    std::remove(filename.c_str());
+    assert(IsFeatureStoreName("month.features"));
+    assert(!IsFeatureStoreName(".features"));
+    assert(!IsFeatureStoreName("month.frames"));
+    return true;
+  }
+  // The rows of objects hold their rects and the same features as
+  // ExtractFeatures(..) of their images:
+  bool TestObjects() {
+    const std::string filename = "feature_store_test.features";
+    std::remove(filename.c_str());
+    Image frame("images/1-2.png");
+    std::vector<Object> objects;
+    objects.push_back(Object(Image(frame.matrix()(cv::Rect(10, 20, 30, 40)),
+                                   cv::Rect(10, 20, 30, 40))));
+    objects.push_back(Object(Image(frame.matrix()(cv::Rect(50, 5, 8, 9)),
+                                   cv::Rect(50, 5, 8, 9))));
+    {
+      FeatureStoreWriter writer(filename);
+      assert(writer.Append(7, objects));
+      assert(writer.Append(8, std::vector<Object>()));
+      assert(writer.num_of_rows() == 2);
+    }
+    MappedFeatureStore store(filename);
+    assert(store.num_of_rows() == 2);
+    for (int i = 0; i < 2; i++) {
+      const FeatureStoreRow &row = store.row(i);
+      assert(row.frame_id == 7);
+      assert(row.rect() == objects[i].image().bounding_rect());
+      FeatureVector features = ExtractFeatures(objects[i].image());
+      for (int j = 0; j < kNumberOfFeatures; j++) {
+        assert(std::abs(row.features[j] - features[j]) <=
+               1e-3 * (1 + std::abs(features[j])));
+      }
+    }
+    std::remove(filename.c_str());
+    return true;
+  }
+  // A store with far more rows than the sample; every row gets the group of
+  // its neighbours:
+  bool TestClusterStore() {
+    const std::string filename = "feature_store_test.features";
+    std::remove(filename.c_str());
+    const int n = 3 * kFeatureStoreChunkRows + 5;
+    {
+      FeatureStoreWriter writer(filename);
+      AppendSampleRows(0, n, &writer);
+    }
+    MappedFeatureStore store(filename);
+    assert(store.num_of_rows() == n);
+    MiniBatchKMeansClusteringAlgorithm k;
+    k.set_batch_size(256);
+    k.set_sample_size(1000);
+    std::vector<int> groups;
+    int num_of_groups = k.AssignGroupsToStore(store, &groups);
+    assert(num_of_groups == 3);
+    assert(static_cast<int>(groups.size()) == n);
+    for (int i = 3; i < n; i++) {
+      assert(groups[i] == groups[i % 3]);
+    }
+    assert((groups[0] != groups[1]) && (groups[1] != groups[2]) &&
+           (groups[0] != groups[2]));
+    std::remove(filename.c_str());
+    // an empty store has no groups:
+    {
+      FeatureStoreWriter writer(filename);
+    }
+    MappedFeatureStore empty_store(filename);
+    assert(empty_store.IsOpened());
+    assert(k.AssignGroupsToStore(empty_store, &groups) == 0);
+    assert(groups.empty());
+    std::remove(filename.c_str());
+    return true;
+  }
+};
+}  // namespace object_clustering
+
+#endif  // OBJECT_CLUSTERING_FEATURE_STORE_TEST_H_
@@ -0,0 +1,131 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// frame_container_test.h
+// Object clustering
+// A test class for the frame container classes.
+#ifndef OBJECT_CLUSTERING_FRAME_CONTAINER_TEST_H_
+#define OBJECT_CLUSTERING_FRAME_CONTAINER_TEST_H_
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "frame_container.h"
+#include "image.h"
+
+namespace object_clustering {
+class FrameContainerTest {
+ public:
+  static bool TestFrameContainer() {
+    FrameContainerTest container_test;
+    return container_test.TestRoundTrip() &&
+           container_test.TestPrivateMapping() &&
+           container_test.TestInvalidFiles() &&
+           container_test.TestFrameSource();
+  }
+  // The sample images, and a region of one of them, whose rows have gaps:
+  std::vector<cv::Mat> SampleFrames() {
+    std::vector<cv::Mat> frames;
+    frames.push_back(Image("images/1-1.png").matrix());
+    frames.push_back(Image("images/2-2.png").matrix());
+    frames.push_back(frames[0](cv::Rect(3, 5, 101, 17)));
+    return frames;
+  }
+  void WriteSampleContainer(const std::string &filename) {
+    FrameContainerWriter writer(filename);
+    assert(writer.IsOpened());
+    for (const auto &frame : SampleFrames()) {
+      assert(writer.Append(frame));
+    }
+    assert(!writer.Append(cv::Mat(2, 2, CV_8UC1)));  // not BGR
+    assert(!writer.Close());  // the failed frame is reported
+  }
+  bool TestRoundTrip() {
+    const std::string filename = "frame_container_test.frames";
+    {
+      FrameContainerWriter writer(filename);
+      for (const auto &frame : SampleFrames()) {
+        assert(writer.Append(frame));
+      }
+      assert(writer.num_of_frames() == 3);
+      assert(writer.Close());
+    }
+    MappedFrameContainer container(filename);
+    assert(container.IsOpened());
+    auto frames = SampleFrames();
+    assert(container.num_of_frames() == static_cast<int>(frames.size()));
+    for (int i = 0; i < container.num_of_frames(); i++) {
+      Image frame = container.frame(i);
+      assert(frame.matrix().size() == frames[i].size());
+      assert(frame.matrix().type() == CV_8UC3);
+      assert(reinterpret_cast<uintptr_t>(frame.matrix().data) %
+             kFrameAlignment == 0);
+      assert(cv::norm(frame.matrix(), frames[i], cv::NORM_INF) == 0);
+    }
+    std::remove(filename.c_str());
+    return true;
+  }
+  bool TestPrivateMapping() {
+    const std::string filename = "frame_container_test.frames";
+    WriteSampleContainer(filename);
+    {
+      MappedFrameContainer container(filename);
+      assert(container.IsOpened());
+      cv::Mat pixels = container.frame(0).matrix();
+      pixels.setTo(cv::Scalar(1, 2, 3));
+    }
+    // the file is not changed:
+    MappedFrameContainer container(filename);
+    assert(cv::norm(container.frame(0).matrix(), SampleFrames()[0],
+                    cv::NORM_INF) == 0);
+    std::remove(filename.c_str());
+    return true;
+  }
+  bool TestInvalidFiles() {
+    assert(!MappedFrameContainer("no_such_file.frames").IsOpened());
+    assert(!MappedFrameContainer("images/1-1.png").IsOpened());
+    // a truncated container:
+    const std::string filename = "frame_container_test.frames";
+    WriteSampleContainer(filename);
+    FILE *file = fopen(filename.c_str(), "rb");
+    std::vector<char> bytes(1 << 16);
+    size_t size = fread(&bytes[0], 1, bytes.size(), file);
+    fclose(file);
+    file = fopen(filename.c_str(), "wb");
+    fwrite(&bytes[0], 1, size, file);
+    fclose(file);
+    assert(!MappedFrameContainer(filename).IsOpened());
+    std::remove(filename.c_str());
+    return true;
+  }
+  bool TestFrameSource() {
+    assert(IsFrameContainerName("recording.frames"));
+    assert(!IsFrameContainerName(".frames"));
+    assert(!IsFrameContainerName("frames/%04d.png"));
+    const std::string filename = "frame_container_test.frames";
+    WriteSampleContainer(filename);
+    ContainerFrameSource source(filename);
+    assert(source.IsOpened());
+    assert(source.get_name() == filename);
+    auto frames = SampleFrames();
+    cv::Mat frame;
+    int num_of_frames = 0;
+    while (source.NextFrame(&frame)) {
+      assert(cv::norm(frame, frames[num_of_frames], cv::NORM_INF) == 0);
+      num_of_frames++;
+    }
+    assert(num_of_frames == static_cast<int>(frames.size()));
+    // the frames can be packed again:
+    ContainerFrameSource again(filename);
+    assert(ConvertToFrameContainer(&again, "copy.frames") == num_of_frames);
+    assert(MappedFrameContainer("copy.frames").num_of_frames() ==
+           num_of_frames);
+    std::remove("copy.frames");
+    std::remove(filename.c_str());
+    return true;
+  }
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_FRAME_CONTAINER_TEST_H_
@@ -0,0 +1,125 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// frame_stream_test.h
+// Object clustering
+// A test class for StreamProcessor class.
+#ifndef OBJECT_CLUSTERING_FRAME_STREAM_TEST_H_
+#define OBJECT_CLUSTERING_FRAME_STREAM_TEST_H_
+
+#include <cassert>
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "abstract_cluster_algorithm.h"
+#include "background_model.h"
+#include "frame_stream.h"
+#include "image.h"
+#include "object.h"
+#include "object_detector.h"
+
+namespace object_clustering {
+class FrameStreamTest {
+ public:
+  static bool TestFrameStream() {
+    FrameStreamTest stream_test;
+    return stream_test.TestEveryFrameInOrder() &&
+           stream_test.TestManyWorkers();
+  }
+  // Gives the frames of a vector, and counts them:
+  class VectorFrameSource: public AbstractFrameSource {
+   public:
+    explicit VectorFrameSource(const std::vector<cv::Mat> &frames):
+      frames_(frames) {}
+
+    bool NextFrame(cv::Mat *frame) override {
+      if (num_of_frames_read == static_cast<int>(frames_.size())) {
+        return false;
+      }
+      *frame = frames_[num_of_frames_read++].clone();
+      return true;
+    }
+
+    int num_of_frames_read = 0;
+
+   private:
+    std::vector<cv::Mat> frames_;
+  };
+  // Puts all the objects into one group:
+  class SingleGroupAlgorithm: public AbstractClusterAlgorithm {
+   public:
+    int AssignGroupsToObjects(std::vector<Object> *objects) const override {
+      for (auto &object : *objects) {
+        object.set_group(0);
+      }
+      return objects->empty() ? 0 : 1;
+    }
+  };
+  // The objects, the background itself and a frame of the wrong size, which
+  // is skipped, over and over:
+  std::vector<cv::Mat> SampleFrames() {
+    cv::Mat objects = Image("images/1-2.png").matrix();
+    cv::Mat background = Image("images/1-1.png").matrix();
+    cv::Mat wrong_size(10, 10, CV_8UC3, cv::Scalar(0, 0, 0));
+    return {objects, background, wrong_size, objects, background, objects,
+            wrong_size, objects};
+  }
+  // The indices of SampleFrames() which are not skipped:
+  std::vector<int> ProcessedIndices() { return {0, 1, 3, 4, 5, 7}; }
+  // One worker gives the results in the order of the stream, whatever the
+  // capacity of the queue, with and without tracking:
+  bool TestEveryFrameInOrder() {
+    ObjectDetector detector;
+    BackgroundModel background(Image("images/1-1.png"));
+    SingleGroupAlgorithm clusterer;
+    auto frames = SampleFrames();
+    for (int capacity : {1, 3, kStreamQueueCapacity}) {
+      for (bool tracking : {false, true}) {
+        StreamProcessor processor(detector, background, clusterer, capacity);
+        processor.set_tracking(tracking);
+        VectorFrameSource source(frames);
+        std::vector<int> indices;
+        auto statistics = processor.Process(&source,
+                                            [&](const FrameResult &result) {
+          indices.push_back(result.frame_index);
+          auto expected = detector.DetectObjectsFromImage(
+              Image(frames[result.frame_index]), background);
+          assert(result.objects.size() == expected.size());
+          assert(result.num_of_groups == (expected.empty() ? 0 : 1));
+        });
+        assert(source.num_of_frames_read == static_cast<int>(frames.size()));
+        assert(indices == ProcessedIndices());
+        assert(statistics.num_of_frames ==
+               static_cast<int>(ProcessedIndices().size()));
+        assert(statistics.num_of_skipped_frames == 2);
+      }
+    }
+    return true;
+  }
+  // Several workers may give the results out of order, but every frame gets
+  // exactly one:
+  bool TestManyWorkers() {
+    ObjectDetector detector;
+    BackgroundModel background(Image("images/1-1.png"));
+    SingleGroupAlgorithm clusterer;
+    auto frames = SampleFrames();
+    StreamProcessor processor(detector, background, clusterer, 1, 3);
+    VectorFrameSource source(frames);
+    std::vector<int> times_processed(frames.size(), 0);
+    auto statistics = processor.Process(&source,
+                                        [&](const FrameResult &result) {
+      times_processed[result.frame_index]++;
+      assert(result.frame.data != nullptr);
+    });
+    assert(source.num_of_frames_read == static_cast<int>(frames.size()));
+    for (int index : ProcessedIndices()) {
+      assert(times_processed[index] == 1);
+    }
+    assert((times_processed[2] == 0) && (times_processed[6] == 0));
+    assert(statistics.num_of_frames ==
+           static_cast<int>(ProcessedIndices().size()));
+    return true;
+  }
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_FRAME_STREAM_TEST_H_
@@ -0,0 +1,150 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// image_source_test.h
+// Object clustering
+// A test class for DecodedImageCache and ImageSource classes.
+#ifndef OBJECT_CLUSTERING_IMAGE_SOURCE_TEST_H_
+#define OBJECT_CLUSTERING_IMAGE_SOURCE_TEST_H_
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <cassert>
+#include <cstdio>
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "opencv2/highgui/highgui.hpp"
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include "image.h"
+#include "image_source.h"
+
+namespace object_clustering {
+class ImageSourceTest {
+ public:
+  static bool TestImageSource() {
+    ImageSourceTest source_test;
+    return source_test.TestCacheHits() &&
+           source_test.TestEviction() &&
+           source_test.TestModifiedFile() &&
+           source_test.TestConcurrentGets() &&
+           source_test.TestLazySource();
+  }
+  bool TestCacheHits() {
+    DecodedImageCache cache;
+    Image first = cache.Get("images/1-1.png");
+    Image second = cache.Get("images/1-1.png");
+    assert(cache.num_of_decodes() == 1);
+    // the pixels are shared, and the same as decoding the file:
+    assert(first.matrix().data == second.matrix().data);
+    assert(cv::norm(first.matrix(), Image("images/1-1.png").matrix(),
+                    cv::NORM_INF) == 0);
+    assert(cache.size_bytes() ==
+           first.matrix().total() * first.matrix().elemSize());
+    bool thrown = false;
+    try {
+      cache.Get("images/no_such_image.png");
+    } catch (const std::runtime_error &error) {
+      thrown = true;
+    }
+    assert(thrown);
+    return true;
+  }
+  bool TestEviction() {
+    Image background("images/1-1.png");
+    size_t bytes = background.matrix().total() * background.matrix().elemSize();
+    // room for a single image:
+    DecodedImageCache cache(bytes + bytes / 2);
+    cache.Get("images/1-1.png");
+    cache.Get("images/2-1.png");
+    cache.Get("images/1-1.png");
+    assert(cache.num_of_decodes() == 3);
+    assert(cache.size_bytes() <= cache.capacity_bytes());
+    // nothing is kept without room:
+    DecodedImageCache no_cache(0);
+    no_cache.Get("images/1-1.png");
+    no_cache.Get("images/1-1.png");
+    assert(no_cache.num_of_decodes() == 2);
+    assert(no_cache.size_bytes() == 0);
+    // an image bigger than the whole cache does not evict the others:
+    const std::string filename = "image_source_test_big.png";
+    cv::Mat big;
+    cv::resize(background.matrix(), big, cv::Size(), 2, 2);
+    assert(cv::imwrite(filename, big));
+    DecodedImageCache small_cache(bytes);
+    small_cache.Get("images/1-1.png");
+    assert(small_cache.Get(filename).matrix().size() == big.size());
+    small_cache.Get("images/1-1.png");
+    assert(small_cache.num_of_decodes() == 2);
+    assert(small_cache.size_bytes() == bytes);
+    std::remove(filename.c_str());
+    return true;
+  }
+  bool TestModifiedFile() {
+    const std::string filename = "image_source_test.png";
+    assert(cv::imwrite(filename, Image("images/1-1.png").matrix()));
+    struct stat file_stat;
+    assert(stat(filename.c_str(), &file_stat) == 0);
+    struct timespec times[2];  // the access and the modification times
+    times[0].tv_sec = times[1].tv_sec = file_stat.st_mtime - 10;
+    times[0].tv_nsec = times[1].tv_nsec = 0;
+    assert(utimensat(AT_FDCWD, filename.c_str(), times, 0) == 0);
+    DecodedImageCache cache;
+    cache.Get(filename);
+    // a different modification time makes it a different file, even within
+    // the same second:
+    times[1].tv_nsec = 500000000;
+    assert(utimensat(AT_FDCWD, filename.c_str(), times, 0) == 0);
+    cache.Get(filename);
+    cache.Get(filename);
+    assert(cache.num_of_decodes() == 2);
+    std::remove(filename.c_str());
+    return true;
+  }
+  bool TestConcurrentGets() {
+    DecodedImageCache cache;
+    std::vector<std::thread> threads;
+    std::vector<Image> images(8, Image(cv::Mat()));
+    for (int i = 0; i < 8; i++) {
+      threads.push_back(std::thread([&cache, &images, i]() {
+        images[i] = cache.Get("images/2-1.png");
+      }));
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    assert(cache.num_of_decodes() == 1);
+    for (const auto &image : images) {
+      assert(image.matrix().data == images[0].matrix().data);
+    }
+    return true;
+  }
+  bool TestLazySource() {
+    // nothing is read before it is needed:
+    ImageSource missing("images/no_such_image.png");
+    bool thrown = false;
+    try {
+      missing.image();
+    } catch (const std::runtime_error &error) {
+      thrown = true;
+    }
+    assert(thrown);
+    DecodedImageCache cache;
+    ImageSource objects("images/2-2.png");
+    ImageSource background("images/2-1.png", &cache);
+    background.Prefetch();
+    background.Prefetch();  // started only once
+    assert(cv::norm(objects.image().matrix(),
+                    Image("images/2-2.png").matrix(), cv::NORM_INF) == 0);
+    assert(cv::norm(background.image().matrix(),
+                    Image("images/2-1.png").matrix(), cv::NORM_INF) == 0);
+    assert(&background.image() == &background.image());
+    assert(cache.num_of_decodes() == 1);
+    return true;
+  }
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_IMAGE_SOURCE_TEST_H_
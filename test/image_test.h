@@ -6,6 +6,11 @@
 #define OBJECT_CLUSTERING_IMAGE_TEST_H_
 
 #include <cassert>
+
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
 #include "image.h"
 #include "gui_functions.h"
 
@@ -15,8 +20,17 @@ class ImageTest {
  static bool TestImage() {
    ImageTest image_test;
    return image_test.TestCreation() &&
-          image_test.TestSettersAndGetters();
+          image_test.TestSettersAndGetters() &&
+          image_test.TestSharingAndCloning() &&
+          image_test.TestReadError();
  }
+  // The tests which need no display, run by test.cc:
+  static bool TestImageWithoutDisplay() {
+    ImageTest image_test;
+    return image_test.TestSettersAndGetters() &&
+           image_test.TestSharingAndCloning() &&
+           image_test.TestReadError();
+  }
   bool TestCreation() {
     //Image i1; // this should give a compile error.
     Image i("images/1-2.png");
@@ -37,15 +51,53 @@ class ImageTest {
   }
   bool TestSettersAndGetters() {
     Image i("images/1-2.png");
-    cv::Rect r(0,0,1280,960);
-    assert(r == i.bounding_rect());
     cv::Mat m(cv::imread("images/1-2.png", CV_LOAD_IMAGE_COLOR)); 
-    cv::Point2d p(640, 480);
+    cv::Rect r(0, 0, m.cols, m.rows);
+    assert(r == i.bounding_rect());
+    cv::Point2d p(m.cols/2, m.rows/2);
     assert(i.GetCenter() == p);
 
     Image i2(m);
     i2.set_bounding_rect(r);
     assert(i2.GetCenter() == p);
+    // the geometry comes from the matrix, whatever its size:
+    Image i3(cv::Mat(2160, 3840, CV_8UC3, cv::Scalar(0, 0, 0)));
+    assert(i3.bounding_rect() == cv::Rect(0, 0, 3840, 2160));
+    assert(i3.GetCenter() == cv::Point2d(1920, 1080));
+    return true;
+  }
+  bool TestReadError() {
+    bool thrown = false;
+    try {
+      Image i("images/no_such_image.png");
+    } catch (const std::runtime_error &error) {
+      thrown = true;
+    }
+    assert(thrown);
+    return true;
+  }
+  bool TestSharingAndCloning() {
+    Image i("images/1-2.png");
+    // copies and crops share the pixels:
+    Image i_copy(i);
+    assert(i_copy.matrix().data == i.matrix().data);
+    cv::Rect r(100, 200, 50, 60);
+    Image crop(i.matrix()(r), r);
+    assert(crop.matrix().data == i.matrix().ptr(r.y) + r.x * 3);
+    assert(crop.bounding_rect() == r);
+    // a clone does not:
+    Image clone = i.Clone();
+    assert(clone.matrix().data != i.matrix().data);
+    assert(cv::norm(clone.matrix(), i.matrix()) == 0);
+    assert(clone.bounding_rect() == i.bounding_rect());
+    // moving does not throw and leaves the original empty:
+    static_assert(std::is_nothrow_move_constructible<Image>::value,
+                  "moving an image should not throw");
+    static_assert(std::is_nothrow_move_assignable<Image>::value,
+                  "move-assigning an image should not throw");
+    Image moved(std::move(clone));
+    assert(clone.matrix().empty());
+    assert(!moved.matrix().empty());
     return true;
   }
 };
@@ -0,0 +1,135 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// incremental_cluster_algorithm_test.h
+// Object clustering
+// A test class for IncrementalClusterAlgorithm class.
+#ifndef OBJECT_CLUSTERING_INCREMENTAL_CLUSTER_ALGORITHM_TEST_H_
+#define OBJECT_CLUSTERING_INCREMENTAL_CLUSTER_ALGORITHM_TEST_H_
+
+#include <cassert>
+
+#include <vector>
+
+#include "image.h"
+#include "incremental_cluster_algorithm.h"
+#include "native_k_means_clustering_algorithm.h"
+#include "object.h"
+
+namespace object_clustering {
+class IncrementalClusterAlgorithmTest {
+ public:
+  static bool TestIncrementalClusterAlgorithm() {
+    IncrementalClusterAlgorithmTest incremental_test;
+    return incremental_test.TestStableGroups() &&
+           incremental_test.TestDrift() &&
+           incremental_test.TestLoadedModel();
+  }
+  // The kinds of objects of the frames:
+  enum Kind { kRed, kGreen, kBlue, kYellow, kWhite, kNumberOfKinds };
+  // A patch of one color; the new kinds are bigger:
+  Object MakeObject(const Kind &kind) {
+    const cv::Scalar colors[kNumberOfKinds] = {
+      cv::Scalar(0, 0, 255), cv::Scalar(0, 255, 0), cv::Scalar(255, 0, 0),
+      cv::Scalar(0, 255, 255), cv::Scalar(255, 255, 255)
+    };
+    int size = kind < kYellow ? 20 : 60;
+    return Object(Image(cv::Mat(size, size, CV_8UC3, colors[kind])));
+  }
+  // Two objects of every kind in [first; last], the kinds interleaved:
+  std::vector<Object> MakeFrame(const Kind &first, const Kind &last) {
+    std::vector<Object> objects;
+    for (int copy = 0; copy < 2; copy++) {
+      for (int kind = first; kind <= last; kind++) {
+        objects.push_back(MakeObject(static_cast<Kind>(kind)));
+      }
+    }
+    return objects;
+  }
+  // The group of every kind in frame, which should have all the kinds in
+  // [first; last]; the objects of a kind should share their group.
+  std::vector<int> GroupsOfKinds(const std::vector<Object> &frame,
+                                 const Kind &first, const Kind &last) {
+    int num_of_kinds = last - first + 1;
+    std::vector<int> groups(num_of_kinds);
+    for (int i = 0; i < static_cast<int>(frame.size()); i++) {
+      int kind = i % num_of_kinds;
+      if (i < num_of_kinds) {
+        groups[kind] = frame[i].group();
+      } else {
+        assert(frame[i].group() == groups[kind]);
+      }
+    }
+    return groups;
+  }
+  // The first frame trains the model; the next ones keep its groups:
+  bool TestStableGroups() {
+    NativeKMeansClusteringAlgorithm k;
+    IncrementalClusterAlgorithm incremental(k);
+    assert(incremental.model().empty());
+    std::vector<Object> no_objects;
+    assert(incremental.AssignGroupsToObjects(&no_objects) == 0);
+    auto frame = MakeFrame(kRed, kBlue);
+    assert(incremental.AssignGroupsToObjects(&frame) == 3);
+    auto groups = GroupsOfKinds(frame, kRed, kBlue);
+    assert((groups[0] != groups[1]) && (groups[1] != groups[2]) &&
+           (groups[0] != groups[2]));
+    for (int i = 0; i < 100; i++) {
+      frame = MakeFrame(kRed, kBlue);
+      assert(incremental.AssignGroupsToObjects(&frame) == 3);
+      assert(GroupsOfKinds(frame, kRed, kBlue) == groups);
+    }
+    assert(incremental.num_of_trainings() == 1);
+    assert(incremental.drift() < incremental.drift_threshold());
+    return true;
+  }
+  // New kinds of objects make the model drift; the model is trained again,
+  // until the latest objects fit it, and the old kinds keep their groups:
+  bool TestDrift() {
+    NativeKMeansClusteringAlgorithm k;
+    IncrementalClusterAlgorithm incremental(k);
+    std::vector<int> groups;
+    for (int i = 0; i < 60; i++) {
+      auto frame = MakeFrame(kRed, kBlue);
+      incremental.AssignGroupsToObjects(&frame);
+      groups = GroupsOfKinds(frame, kRed, kBlue);
+    }
+    assert(incremental.num_of_trainings() == 1);
+    for (int i = 0; i < 200; i++) {
+      auto frame = MakeFrame(kRed, kWhite);
+      incremental.AssignGroupsToObjects(&frame);
+    }
+    int num_of_trainings = incremental.num_of_trainings();
+    assert(num_of_trainings >= 2);
+    assert(incremental.model().num_of_clusters() == 5);
+    std::vector<Object> frame;
+    for (int i = 0; i < 100; i++) {
+      frame = MakeFrame(kRed, kWhite);
+      incremental.AssignGroupsToObjects(&frame);
+    }
+    assert(incremental.num_of_trainings() == num_of_trainings);
+    auto new_groups = GroupsOfKinds(frame, kRed, kWhite);
+    for (int kind = kRed; kind <= kBlue; kind++) {
+      assert(new_groups[kind] == groups[kind]);
+    }
+    assert((new_groups[kYellow] != new_groups[kWhite]) &&
+           (new_groups[kYellow] > kBlue) && (new_groups[kWhite] > kBlue));
+    return true;
+  }
+  // A model given to the algorithm is used without training:
+  bool TestLoadedModel() {
+    NativeKMeansClusteringAlgorithm k;
+    auto frame = MakeFrame(kRed, kBlue);
+    ClusterModel model;
+    assert(k.TrainModel(frame, &model) == 3);
+    IncrementalClusterAlgorithm incremental(k);
+    incremental.set_model(model);
+    assert(incremental.AssignGroupsToObjects(&frame) == 3);
+    assert(incremental.num_of_trainings() == 0);
+    auto groups = GroupsOfKinds(frame, kRed, kBlue);
+    FeatureVector features = ExtractFeatures(frame[0].image());
+    assert(groups[kRed] == model.Assign(features, nullptr));
+    return true;
+  }
+};
+}  // namespace object_clustering
+
+#endif  // OBJECT_CLUSTERING_INCREMENTAL_CLUSTER_ALGORITHM_TEST_H_
@@ -5,6 +5,10 @@
 #ifndef OBJECT_CLUSTERING_K_MEANS_CLUSTERING_ALGORITHM_TEST_H_
 #define OBJECT_CLUSTERING_K_MEANS_CLUSTERING_ALGORITHM_TEST_H_
 
+#include <cassert>
+
+#include <vector>
+
 #include "gui_functions.h"
 #include "image.h"
 #include "k_means_clustering_algorithm.h"
@@ -19,7 +23,9 @@ class KMeansClusteringAlgorithmTest {
            //k.TestAssignFeatures() &&
            //k.TestNormalizeFeatures();
            //k.TestComputeError();
-           k.TestKMeans();
+           k.TestKMeans() &&
+           TestKSearch<KMeansClusteringAlgorithm>() &&
+           TestParallelKSearch<KMeansClusteringAlgorithm>();
   }
   bool TestAssignGroupsToObjects() {
     ObjectDetector d;
@@ -85,6 +91,88 @@ class KMeansClusteringAlgorithmTest {
     //k.KMeansClusteringOpenCVImplementation(training_set, &objects);
     
 
+    return true;
+  }
+  // Three well separated groups of four examples each:
+  static void SeparatedTrainingSet(FeatureMatrix *training_set,
+                                   std::vector<Object> *objects) {
+    training_set->Create(12, kNumberOfFeatures);
+    for (int i = 0; i < 12; i++) {
+      int group = i / 4;
+      training_set->at(i, 0) = (group - 1) * 0.5;
+      training_set->at(i, 1) = (i % 4 - 1.5) * 0.01;
+      objects->push_back(Object(Image(cv::Mat(10, 10, CV_8UC3,
+                                              cv::Scalar::all(0)))));
+    }
+  }
+  // Runs the Elbow method of k over the training set:
+  static int Cluster(const KMeansClusteringAlgorithm &k,
+                     const FeatureMatrix &training_set,
+                     std::vector<Object> *objects) {
+    return k.KMeansClusteringOpenCVImplementation(training_set, objects);
+  }
+  // Runs one K-Means of k, from no previous centers:
+  static double RunKMeans(const KMeansClusteringAlgorithm &k,
+                          const FeatureMatrix &training_set,
+                          const int &num_of_clusters,
+                          std::vector<int> *labels,
+                          FeatureMatrix *centers) {
+    return k.RunKMeans(training_set, num_of_clusters, FeatureMatrix(), labels,
+                       centers);
+  }
+  // Algorithm should be KMeansClusteringAlgorithm or a subclass:
+  template <typename Algorithm>
+  static bool TestKSearch() {
+    for (auto mode : {kColdKSearch, kWarmStartedKSearch, kParallelKSearch}) {
+      Algorithm k;
+      k.set_k_search_mode(mode);
+      FeatureMatrix training_set;
+      std::vector<Object> objects;
+      SeparatedTrainingSet(&training_set, &objects);
+      assert(Cluster(k, training_set, &objects) == 3);
+      int n = static_cast<int>(objects.size());
+      for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+          bool same_group = i / 4 == j / 4;
+          assert(same_group == (objects[i].group() == objects[j].group()));
+        }
+      }
+      // max_k bounds the search:
+      k.set_max_k(1);
+      assert(Cluster(k, training_set, &objects) == 1);
+      for (const auto &object : objects) {
+        assert(object.group() == 0);
+      }
+    }
+    return true;
+  }
+  // The number of threads and the window do not change the result:
+  template <typename Algorithm>
+  static bool TestParallelKSearch() {
+    FeatureMatrix training_set;
+    std::vector<Object> objects;
+    SeparatedTrainingSet(&training_set, &objects);
+    int expected_num_of_groups = -1;
+    std::vector<int> expected_groups;
+    for (int num_of_threads : {1, 3}) {
+      for (int k_window : {1, 2, 5}) {
+        Algorithm k;
+        k.set_k_search_mode(kParallelKSearch);
+        k.set_num_of_threads(num_of_threads);
+        k.set_k_window(k_window);
+        int num_of_groups = Cluster(k, training_set, &objects);
+        std::vector<int> groups;
+        for (const auto &object : objects) {
+          groups.push_back(object.group());
+        }
+        if (expected_num_of_groups < 0) {
+          expected_num_of_groups = num_of_groups;
+          expected_groups = groups;
+        }
+        assert(num_of_groups == expected_num_of_groups);
+        assert(groups == expected_groups);
+      }
+    }
     return true;
   }
 };
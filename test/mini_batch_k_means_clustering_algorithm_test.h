@@ -0,0 +1,52 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// mini_batch_k_means_clustering_algorithm_test.h
+// Object clustering
+// A test class for MiniBatchKMeansClusteringAlgorithm class.
+#ifndef OBJECT_CLUSTERING_MINI_BATCH_K_MEANS_CLUSTERING_ALGORITHM_TEST_H_
+#define OBJECT_CLUSTERING_MINI_BATCH_K_MEANS_CLUSTERING_ALGORITHM_TEST_H_
+
+#include <cassert>
+
+#include <vector>
+
+#include "k_means_clustering_algorithm_test.h"
+#include "mini_batch_k_means_clustering_algorithm.h"
+
+namespace object_clustering {
+class MiniBatchKMeansClusteringAlgorithmTest {
+ public:
+  static bool TestMiniBatchKMeansClusteringAlgorithm() {
+    MiniBatchKMeansClusteringAlgorithmTest k_test;
+    return KMeansClusteringAlgorithmTest::
+           TestKSearch<MiniBatchKMeansClusteringAlgorithm>() &&
+           k_test.TestManyRows();
+  }
+  // Far more rows than a batch; every row still gets the group of its
+  // neighbours:
+  bool TestManyRows() {
+    const int n = 30000;
+    FeatureMatrix training_set(n, kNumberOfFeatures);
+    for (int i = 0; i < n; i++) {
+      int group = i % 3;
+      training_set.at(i, group) = 0.5;
+      training_set.at(i, 3) = (i % 7 - 3) * 0.01;
+    }
+    MiniBatchKMeansClusteringAlgorithm k;
+    k.set_batch_size(256);
+    k.set_tolerance(1e-4);
+    std::vector<int> labels;
+    FeatureMatrix centers;
+    KMeansClusteringAlgorithmTest::RunKMeans(k, training_set, 3, &labels,
+                                             &centers);
+    assert(static_cast<int>(labels.size()) == n);
+    for (int i = 3; i < n; i++) {
+      assert(labels[i] == labels[i % 3]);
+    }
+    assert((labels[0] != labels[1]) && (labels[1] != labels[2]) &&
+           (labels[0] != labels[2]));
+    return true;
+  }
+};
+}  // namespace object_clustering
+
+#endif  // OBJECT_CLUSTERING_MINI_BATCH_K_MEANS_CLUSTERING_ALGORITHM_TEST_H_
@@ -0,0 +1,77 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// native_k_means_clustering_algorithm_test.h
+// Object clustering
+// A test class for NativeKMeansClusteringAlgorithm class.
+#ifndef OBJECT_CLUSTERING_NATIVE_K_MEANS_CLUSTERING_ALGORITHM_TEST_H_
+#define OBJECT_CLUSTERING_NATIVE_K_MEANS_CLUSTERING_ALGORITHM_TEST_H_
+
+#include <cassert>
+#include <cmath>
+
+#include <vector>
+
+#include "k_means_clustering_algorithm_test.h"
+#include "native_k_means_clustering_algorithm.h"
+
+namespace object_clustering {
+class NativeKMeansClusteringAlgorithmTest {
+ public:
+  static bool TestNativeKMeansClusteringAlgorithm() {
+    NativeKMeansClusteringAlgorithmTest k_test;
+    return KMeansClusteringAlgorithmTest::
+           TestKSearch<NativeKMeansClusteringAlgorithm>() &&
+           KMeansClusteringAlgorithmTest::
+           TestParallelKSearch<NativeKMeansClusteringAlgorithm>() &&
+           k_test.TestSameAsOpenCV() &&
+           k_test.TestDeterminism();
+  }
+  // Both implementations find the same groups when they are well separated:
+  bool TestSameAsOpenCV() {
+    FeatureMatrix training_set;
+    std::vector<Object> native_objects;
+    KMeansClusteringAlgorithmTest::SeparatedTrainingSet(&training_set,
+                                                        &native_objects);
+    NativeKMeansClusteringAlgorithm native;
+    KMeansClusteringAlgorithm k;
+    std::vector<int> native_labels, labels;
+    FeatureMatrix native_centers, centers;
+    double native_compactness = KMeansClusteringAlgorithmTest::RunKMeans(
+        native, training_set, 3, &native_labels, &native_centers);
+    double compactness = KMeansClusteringAlgorithmTest::RunKMeans(
+        k, training_set, 3, &labels, &centers);
+    assert(std::fabs(native_compactness - compactness) <= 1e-4);
+    for (int i = 0; i < training_set.rows(); i++) {
+      for (int j = 0; j < training_set.rows(); j++) {
+        assert((native_labels[i] == native_labels[j]) ==
+               (labels[i] == labels[j]));
+      }
+    }
+    return true;
+  }
+  bool TestDeterminism() {
+    FeatureMatrix training_set;
+    std::vector<Object> objects;
+    KMeansClusteringAlgorithmTest::SeparatedTrainingSet(&training_set,
+                                                        &objects);
+    NativeKMeansClusteringAlgorithm native;
+    std::vector<int> first, second;
+    FeatureMatrix first_centers, second_centers;
+    native.RunKMeans(training_set, 5, FeatureMatrix(), &first,
+                     &first_centers);
+    native.RunKMeans(training_set, 5, FeatureMatrix(), &second,
+                     &second_centers);
+    assert(first == second);
+    // no cluster is left empty:
+    std::vector<int> counts(5, 0);
+    for (int label : first) {
+      counts[label]++;
+    }
+    for (int count : counts) {
+      assert(count > 0);
+    }
+    return true;
+  }
+};
+}  // namespace object_clustering
+
+#endif  // OBJECT_CLUSTERING_NATIVE_K_MEANS_CLUSTERING_ALGORITHM_TEST_H_
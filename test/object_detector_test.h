@@ -6,17 +6,26 @@
 #define OBJECT_CLUSTERING_OBJECT_DETECTOR_TEST_H_
 
 #include <cassert>
+#include <cstdint>
 
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <vector>
 
 #include "opencv2/imgproc/imgproc.hpp"
 
+#include "background_model.h"
+#include "detector_workspace.h"
+#include "foreground_kernel.h"
 #include "gui_functions.h"
 #include "image.h"
 #include "object_detector.h"
 
 namespace object_clustering {
+// The calls of operator new, counted by the one of test.cc:
+extern std::atomic<int64_t> num_of_heap_allocations;
+
 class ObjectDetectorTest {
  public:
   static bool TestObjectDetector() {
@@ -25,13 +34,28 @@ class ObjectDetectorTest {
            //obj_detector_test.TestGetObjects() &&
            //obj_detector_test.TestGetGoodRects() &&
            //obj_detector_test.TestDetectContours() &&
-           obj_detector_test.TestRectCenterInsideOtherRect() &&
            //obj_detector_test.TestRecolorDetectedPixels() &&
            obj_detector_test.TestExtractForeground() &&
            obj_detector_test.TestComputeForegroundMask() &&
+           obj_detector_test.TestThresholdSearchModes() &&
+           obj_detector_test.TestFusedPreprocessing() &&
+           obj_detector_test.TestTiledDetection() &&
+           obj_detector_test.TestPyramidDetection() &&
+           obj_detector_test.TestWorkspace() &&
            obj_detector_test.TestDetectObjects(); 
            
   }
+  // The tests which need neither a display nor more than the image pairs
+  // 1 and 2, which are checked in; test.cc runs these:
+  static bool TestObjectDetectorWithoutDisplay() {
+    ObjectDetectorTest obj_detector_test;
+    return obj_detector_test.TestCreation() &&
+           obj_detector_test.TestThresholdSearchModes() &&
+           obj_detector_test.TestFusedPreprocessing() &&
+           obj_detector_test.TestTiledDetection() &&
+           obj_detector_test.TestPyramidDetection() &&
+           obj_detector_test.TestWorkspace();
+  }
   bool TestCreation() {
     ObjectDetector o;
     //ObjectDetector o2(o); // should not compile
@@ -57,26 +81,6 @@ class ObjectDetectorTest {
    
     return true;
   }
-  bool TestRectCenterInsideOtherRect() {
-    cv::Rect r(0, 0, 1000, 1000);
-    cv::Rect r2(100, 100, 500, 500);
-    ObjectDetector d;
-    assert(d.RectCenterInsideOtherRect(1,{r, r2}));
-    cv::Rect r3(0, 0, 200, 400);
-    cv::Rect r4(600, 0 , 30, 40);
-    assert(! d.RectCenterInsideOtherRect(1, {r3, r4}));
-    cv::Rect r5(10, 10, 100, 100);
-    cv::Rect r6(90, 90, 200, 200);
-    assert(! d.RectCenterInsideOtherRect(1, {r5, r6}));
-    cv::Rect r7(-50, -50, 100, 100);
-    cv::Rect r8(-1, -1, 80, 80);
-    assert(d.RectCenterInsideOtherRect(1, {r7, r8}));
-    cv::Rect r9(-100, -100, 300, 300);
-    assert(! d.RectCenterInsideOtherRect(2, {r7, r8, r9}));
-    // should give a runtime error:
-    //assert(! d.RectCenterInsideOtherRect(1, {}));  
-    return true;
-  }
   bool TestComputeForegroundMask() {
     ObjectDetector d;
     for (int i = 1; i <= 17; i++) {
@@ -102,6 +106,202 @@ class ObjectDetectorTest {
     
     return true;
   }
+  // The unfused chain, step by step:
+  cv::Mat PreprocessStepByStep(const Image &image, const cv::Mat &mask) {
+    cv::Mat recolored_src;
+    image.matrix().copyTo(recolored_src, mask);
+    ObjectDetector d;
+    d.RecolorDetectedPixels(&recolored_src);
+    cv::Mat src_gray;
+    cvtColor(recolored_src, src_gray, CV_BGR2GRAY);
+    blur(src_gray, src_gray, cv::Size(3, 3));
+    return src_gray;
+  }
+  bool TestFusedPreprocessing() {
+    ObjectDetector d;
+    for (int i = 1; i <= 2; i++) {
+      Image img("images/" + std::to_string(i) + "-2.png");
+      Image background("images/" + std::to_string(i) + "-1.png");
+      cv::Mat expected = PreprocessStepByStep(
+          img, d.ComputeForegroundMask(img, background));
+      cv::Mat result = d.ExtractForegroundAndPreprocess(img, background);
+      assert(cv::norm(expected, result, cv::NORM_INF) == 0);
+    }
+    // random masks with shadow, odd sizes and black pixels in the image:
+    cv::RNG rng(12345);
+    for (int i = 0; i < 50; i++) {
+      int rows = rng.uniform(1, 40);
+      int cols = rng.uniform(1, 70);
+      cv::Mat raw_mask(rows, cols, CV_8UC1);
+      cv::Mat src(rows, cols, CV_8UC3);
+      const uchar mask_values[] = {0, kShadowIntensity, 255};
+      for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+          raw_mask.at<uchar>(y, x) = mask_values[rng.uniform(0, 3)];
+          cv::Vec3b pixel(rng.uniform(0, 2) * rng.uniform(0, 256),
+                          rng.uniform(0, 2) * rng.uniform(0, 256),
+                          rng.uniform(0, 2) * rng.uniform(0, 256));
+          src.at<cv::Vec3b>(y, x) = pixel;
+        }
+      }
+      cv::Mat mask = raw_mask.clone();
+      mask.setTo(cv::Scalar(0), raw_mask == kShadowIntensity);
+      cv::Mat expected = PreprocessStepByStep(Image(src), mask);
+      cv::Mat result;
+      ForegroundToBlurredGray(raw_mask, src, &result);
+      assert(cv::norm(expected, result, cv::NORM_INF) == 0);
+    }
+    return true;
+  }
+  bool TestTiledDetection() {
+    for (auto backend : {kContoursBackend, kConnectedComponentsBackend}) {
+      ObjectDetector whole;
+      whole.set_detection_backend(backend);
+      ObjectDetector tiled;
+      tiled.set_detection_backend(backend);
+      tiled.set_num_of_threads(3);
+      for (int tile_height : {7, 100, kDetectionTileHeight}) {
+        tiled.set_tile_height(tile_height);
+        for (int i = 1; i <= 2; i++) {
+          Image img("images/" + std::to_string(i) + "-2.png");
+          Image background("images/" + std::to_string(i) + "-1.png");
+          cv::Mat m1 = whole.ExtractForegroundAndPreprocess(img, background);
+          cv::Mat m2 = tiled.ExtractForegroundAndPreprocess(img, background);
+          assert(cv::norm(m1, m2, cv::NORM_INF) == 0);
+          auto objects1 = whole.DetectObjectsFromImage(img, background);
+          auto objects2 = tiled.DetectObjectsFromImage(img, background);
+          assert(objects1.size() == objects2.size());
+          for (size_t j = 0; j < objects1.size(); j++) {
+            assert(objects1[j].image().bounding_rect() ==
+                   objects2[j].image().bounding_rect());
+          }
+        }
+      }
+    }
+    return true;
+  }
+  // The rects sorted by position, so that searches which find them in
+  // different orders can be compared:
+  std::vector<cv::Rect> SortedRects(std::vector<cv::Rect> rects) {
+    std::sort(rects.begin(), rects.end(),
+              [](const cv::Rect &a, const cv::Rect &b) {
+      return (a.y != b.y) ? (a.y < b.y) : (a.x < b.x);
+    });
+    return rects;
+  }
+
+  std::vector<cv::Rect> SortedRects(const std::vector<Object> &objects) {
+    std::vector<cv::Rect> rects;
+    for (const auto &object : objects) {
+      rects.push_back(object.image().bounding_rect());
+    }
+    return SortedRects(rects);
+  }
+  // The pyramid gives the objects of the full resolution search: on the pair
+  // 1 the contours come from its one region, while on the pair 2, and for the
+  // blobs, whose downscaled frames have none, the whole frame is searched
+  // again.
+  bool TestPyramidDetection() {
+    for (auto backend : {kContoursBackend, kConnectedComponentsBackend}) {
+      ObjectDetector full;
+      full.set_detection_backend(backend);
+      ObjectDetector pyramid;
+      pyramid.set_detection_backend(backend);
+      pyramid.set_detection_resolution(kPyramidDetection);
+      for (int i = 1; i <= 2; i++) {
+        Image img("images/" + std::to_string(i) + "-2.png");
+        BackgroundModel background(
+            Image("images/" + std::to_string(i) + "-1.png"));
+        assert(SortedRects(pyramid.DetectObjectsFromImage(img, background)) ==
+               SortedRects(full.DetectObjectsFromImage(img, background)));
+      }
+    }
+    // the foreground left outside the objects of the downscaled frame:
+    ObjectDetector d;
+    cv::Mat mask(8, 8, CV_8UC1, cv::Scalar(0));
+    mask(cv::Rect(1, 1, 3, 3)).setTo(cv::Scalar(255));
+    mask(cv::Rect(5, 5, 2, 1)).setTo(cv::Scalar(255));
+    mask(cv::Rect(5, 0, 2, 2)).setTo(cv::Scalar(kShadowIntensity));
+    assert(d.CountForegroundOutside(mask, {cv::Rect(0, 0, 4, 4)}) == 2);
+    assert(d.CountForegroundOutside(mask, {cv::Rect(0, 0, 4, 4),
+                                           cv::Rect(4, 4, 4, 4)}) == 0);
+    assert(d.CountForegroundOutside(mask, {}) == 11);
+    // the coarse limits are scaled and widened:
+    float coarse_scale = 1.0f / (1 << (2 * kCoarseLevels));
+    assert(!d.HasObjectArea(kMinimalAreaForObjectIdentification, 0));
+    assert(d.HasObjectArea(kMinimalAreaForObjectIdentification * coarse_scale,
+                           kCoarseLevels));
+    assert(d.HasObjectArea(kMaximalAreaForObjectIdentification * coarse_scale,
+                           kCoarseLevels));
+    return true;
+  }
+  // One workspace, reused across frames, sizes, backends and resolutions,
+  // gives the same objects as a new one every frame:
+  bool TestWorkspace() {
+    DetectorWorkspace workspace;
+    std::vector<Object> objects2;
+    for (auto resolution : {kFullResolutionDetection, kPyramidDetection}) {
+      for (auto backend : {kContoursBackend, kConnectedComponentsBackend}) {
+        ObjectDetector detector;
+        detector.set_detection_backend(backend);
+        detector.set_detection_resolution(resolution);
+        for (int i = 1; i <= 2; i++) {
+          Image img("images/" + std::to_string(i) + "-2.png");
+          BackgroundModel background(
+              Image("images/" + std::to_string(i) + "-1.png"));
+          auto objects1 = detector.DetectObjectsFromImage(img, background);
+          detector.DetectObjectsFromImage(img, background, &workspace,
+                                          &objects2);
+          assert(objects1.size() == objects2.size());
+          for (size_t j = 0; j < objects1.size(); j++) {
+            assert(objects1[j].image().bounding_rect() ==
+                   objects2[j].image().bounding_rect());
+          }
+        }
+      }
+    }
+    // the same frame once more takes no new matrix buffer from the system,
+    // in every mode, with tiles as well; a pool of one thread runs one task
+    // at a time, so the number of task scratches does not depend on timing:
+    Image img("images/1-2.png");
+    BackgroundModel background(Image("images/1-1.png"));
+    for (auto resolution : {kFullResolutionDetection, kPyramidDetection}) {
+      for (auto backend : {kContoursBackend, kConnectedComponentsBackend}) {
+        for (bool tiled : {false, true}) {
+          ObjectDetector detector;
+          detector.set_detection_backend(backend);
+          detector.set_detection_resolution(resolution);
+          if (tiled) {
+            detector.set_num_of_threads(1);
+            detector.set_tile_height(64);
+          }
+          detector.DetectObjectsFromImage(img, background, &workspace,
+                                          &objects2);
+          int64_t num_of_allocations =
+            workspace.allocator().num_of_allocations();
+          detector.DetectObjectsFromImage(img, background, &workspace,
+                                          &objects2);
+          assert(workspace.allocator().num_of_allocations() ==
+                 num_of_allocations);
+        }
+      }
+    }
+    // and the blobs of a whole frame, without a pool, take nothing from the
+    // heap at all. Only this mode is checked: the others still allocate
+    // every frame, and OpenCV's own cv::fastMalloc(..) is not counted, see
+    // DetectorWorkspace:
+    ObjectDetector blob_detector;
+    blob_detector.set_detection_backend(kConnectedComponentsBackend);
+    blob_detector.DetectObjectsFromImage(img, background, &workspace,
+                                         &objects2);
+    int64_t num_of_news = num_of_heap_allocations;
+    for (int frame = 0; frame < 3; frame++) {
+      blob_detector.DetectObjectsFromImage(img, background, &workspace,
+                                           &objects2);
+    }
+    assert(num_of_heap_allocations == num_of_news);
+    return true;
+  }
   bool TestRecolorDetectedPixels() {
     Image i("images/7-2.png");
     Image b("images/7-1.png");
@@ -168,6 +368,30 @@ class ObjectDetectorTest {
     //d.DetectContoursInMatrixWithThresholdOutput(m, &contours, nullptr);
     return true;
   }
+  bool TestThresholdSearchModes() {
+    ObjectDetector exhaustive;
+    exhaustive.set_threshold_search_mode(kExhaustiveThresholdSearch);
+    ObjectDetector distinct;
+    distinct.set_threshold_search_mode(kDistinctLevelsThresholdSearch);
+    for (int i = 1; i <= 2; i++) {
+      Image img("images/" + std::to_string(i) + "-2.png");
+      Image background("images/" + std::to_string(i) + "-1.png");
+      auto m = exhaustive.ExtractForegroundAndPreprocess(img, background);
+      cv::vector<cv::vector<cv::Point>> contours1, contours2;
+      cv::Mat threshold1, threshold2;
+      exhaustive.DetectContoursInMatrixWithThresholdOutput(m,
+                                                           &contours1,
+                                                           &threshold1);
+      distinct.DetectContoursInMatrixWithThresholdOutput(m,
+                                                         &contours2,
+                                                         &threshold2);
+      assert(contours1 == contours2);
+      assert(cv::countNonZero(threshold1 != threshold2) == 0);
+      assert(distinct.CandidateThresholds(m).size() <=
+             exhaustive.CandidateThresholds(m).size());
+    }
+    return true;
+  }
   bool TestGetGoodRects() {
     ObjectDetector d;
     for (int i = 1; i <= 17; i++) {
@@ -215,7 +439,7 @@ class ObjectDetectorTest {
       d.DetectContoursInMatrixWithThresholdOutput(m, &contours, &threshold);
       cv::vector<cv::Rect> good_rects;
       d.GetGoodBoundingRectsOfContours(contours, &good_rects);
-      auto v = d.GetObjectsFromRects(good_rects, threshold, img.matrix());
+      auto v = d.GetObjectsFromRects(good_rects, img.matrix());
       for(auto obj : v) {
         ShowImage(obj.image());
       }
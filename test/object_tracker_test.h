@@ -0,0 +1,214 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// object_tracker_test.h
+// Object clustering
+// A test class for ObjectTracker class.
+#ifndef OBJECT_CLUSTERING_OBJECT_TRACKER_TEST_H_
+#define OBJECT_CLUSTERING_OBJECT_TRACKER_TEST_H_
+
+#include <cassert>
+#include <cmath>
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "abstract_cluster_algorithm.h"
+#include "feature_descriptor.h"
+#include "image.h"
+#include "object.h"
+#include "object_tracker.h"
+
+namespace object_clustering {
+class ObjectTrackerTest {
+ public:
+  static bool TestObjectTracker() {
+    ObjectTrackerTest tracker_test;
+    return tracker_test.TestOverlap() &&
+           tracker_test.TestMeanColor() &&
+           tracker_test.TestCarryOver() &&
+           tracker_test.TestNewAndChanged() &&
+           tracker_test.TestAlgorithmWhichRenumbers();
+  }
+  // Groups the objects by their brightest channel, and counts what it is
+  // given:
+  class ChannelClusterAlgorithm: public AbstractClusterAlgorithm {
+   public:
+    explicit ChannelClusterAlgorithm(bool keeps_groups):
+      keeps_groups_(keeps_groups) {}
+
+    int AssignGroupsToObjects(std::vector<Object> *objects) const override {
+      num_of_calls++;
+      num_of_objects += objects->size();
+      for (auto &object : *objects) {
+        cv::Scalar color = cv::mean(object.image().matrix());
+        int channel = 0;
+        for (int c = 1; c < 3; c++) {
+          if (color[c] > color[channel]) channel = c;
+        }
+        object.set_group(channel);
+      }
+      return objects->empty() ? 0 : 3;
+    }
+
+    bool keeps_groups() const override { return keeps_groups_; }
+
+    mutable int num_of_calls = 0;
+    mutable int num_of_objects = 0;
+
+   private:
+    bool keeps_groups_;
+  };
+  // A patch of a frame, with the objects' images as views into the frame:
+  struct Patch {
+    cv::Rect rect;
+    cv::Scalar color;
+  };
+  std::vector<Object> MakeFrame(const std::vector<Patch> &patches) {
+    cv::Mat frame(200, 300, CV_8UC3, cv::Scalar(0, 0, 0));
+    std::vector<Object> objects;
+    for (const auto &patch : patches) {
+      frame(patch.rect).setTo(patch.color);
+      objects.push_back(Object(Image(frame(patch.rect), patch.rect)));
+    }
+    return objects;
+  }
+
+  std::vector<Patch> SamplePatches() {
+    return {{cv::Rect(10, 10, 40, 40), cv::Scalar(255, 0, 0)},
+            {cv::Rect(100, 20, 50, 30), cv::Scalar(0, 255, 0)},
+            {cv::Rect(200, 100, 60, 60), cv::Scalar(0, 0, 255)}};
+  }
+
+  bool TestOverlap() {
+    cv::Rect rect(0, 0, 10, 10);
+    assert(ObjectTracker::Overlap(rect, rect) == 1);
+    assert(ObjectTracker::Overlap(rect, cv::Rect(20, 20, 10, 10)) == 0);
+    assert(std::abs(ObjectTracker::Overlap(rect, cv::Rect(5, 0, 10, 10)) -
+                    50.0 / 150) < 1e-6);
+    assert(ObjectTracker::Overlap(rect, cv::Rect(0, 0, 0, 0)) == 0);
+    return true;
+  }
+  // The sampled mean is the mean of a plain patch, and close to the mean of
+  // a noisy one:
+  bool TestMeanColor() {
+    cv::Scalar color = ObjectTracker::MeanColor(
+        cv::Mat(30, 17, CV_8UC3, cv::Scalar(10, 200, 30)));
+    assert((color[0] == 10) && (color[1] == 200) && (color[2] == 30));
+    cv::Mat noisy(120, 90, CV_8UC3);
+    cv::randu(noisy, cv::Scalar(0, 0, 0), cv::Scalar(256, 256, 256));
+    color = ObjectTracker::MeanColor(noisy);
+    cv::Scalar mean = cv::mean(noisy);
+    for (int c = 0; c < 3; c++) {
+      assert(std::abs(color[c] - mean[c]) < kTrackerMaxColorShift);
+    }
+    assert(ObjectTracker::MeanColor(cv::Mat(1, 1, CV_8UC3,
+                                            cv::Scalar(1, 2, 3)))[2] == 3);
+    return true;
+  }
+  // The objects which did not move are not clustered again:
+  bool TestCarryOver() {
+    ChannelClusterAlgorithm clusterer(true);
+    ObjectTracker tracker;
+    auto objects = MakeFrame(SamplePatches());
+    assert(tracker.AssignGroupsToObjects(clusterer, &objects) == 3);
+    assert((clusterer.num_of_calls == 1) && (clusterer.num_of_objects == 3));
+    assert((tracker.num_of_hits() == 0) && (tracker.num_of_misses() == 3));
+    for (int frame = 0; frame < 10; frame++) {
+      auto next_objects = MakeFrame(SamplePatches());
+      assert(tracker.AssignGroupsToObjects(clusterer, &next_objects) == 3);
+      for (int i = 0; i < 3; i++) {
+        assert(next_objects[i].grouped());
+        assert(next_objects[i].group() == objects[i].group());
+      }
+    }
+    assert(clusterer.num_of_calls == 1);
+    assert((tracker.num_of_hits() == 30) && (tracker.num_of_misses() == 3));
+    // an empty frame has no groups, and the frame after it is all new:
+    std::vector<Object> no_objects;
+    assert(tracker.AssignGroupsToObjects(clusterer, &no_objects) == 0);
+    objects = MakeFrame(SamplePatches());
+    tracker.AssignGroupsToObjects(clusterer, &objects);
+    assert(tracker.num_of_misses() == 6);
+    // and so is the frame after a reset:
+    tracker.Reset();
+    objects = MakeFrame(SamplePatches());
+    tracker.AssignGroupsToObjects(clusterer, &objects);
+    assert(tracker.num_of_misses() == 9);
+    return true;
+  }
+  // A jitter of a few pixels keeps an object; a move, a new color or a new
+  // object are clustered, and only they are:
+  bool TestNewAndChanged() {
+    ChannelClusterAlgorithm clusterer(true);
+    ObjectTracker tracker;
+    auto patches = SamplePatches();
+    auto objects = MakeFrame(patches);
+    tracker.AssignGroupsToObjects(clusterer, &objects);
+    patches[0].rect.x += 2;  // jitter
+    patches[1].rect.y += 40;  // moved
+    patches[2].color = cv::Scalar(0, 255, 0);  // another object
+    patches.push_back({cv::Rect(10, 120, 40, 40), cv::Scalar(0, 0, 255)});
+    auto next_objects = MakeFrame(patches);
+    assert(tracker.AssignGroupsToObjects(clusterer, &next_objects) == 3);
+    assert((clusterer.num_of_calls == 2) && (clusterer.num_of_objects == 6));
+    assert((tracker.num_of_hits() == 1) && (tracker.num_of_misses() == 6));
+    assert(next_objects[0].group() == objects[0].group());
+    assert(next_objects[1].group() == 1);
+    assert(next_objects[2].group() == 1);
+    assert(next_objects[3].group() == 2);
+    // two objects on the same previous one: only one of them is the same
+    tracker.Reset();
+    objects = MakeFrame({{cv::Rect(10, 10, 40, 40), cv::Scalar(255, 0, 0)}});
+    tracker.AssignGroupsToObjects(clusterer, &objects);
+    auto num_of_misses = tracker.num_of_misses();
+    objects = MakeFrame({{cv::Rect(10, 10, 40, 40), cv::Scalar(255, 0, 0)},
+                         {cv::Rect(11, 10, 40, 40), cv::Scalar(255, 0, 0)}});
+    tracker.AssignGroupsToObjects(clusterer, &objects);
+    assert(tracker.num_of_misses() == num_of_misses + 1);
+    return true;
+  }
+  // With an algorithm which numbers the groups anew on every call, only a
+  // frame without a hit is clustered; a new or changed object of the frames
+  // after it gets the group of the nearest center of that frame:
+  bool TestAlgorithmWhichRenumbers() {
+    ChannelClusterAlgorithm clusterer(false);
+    ObjectTracker tracker;
+    auto patches = SamplePatches();
+    auto objects = MakeFrame(patches);
+    tracker.AssignGroupsToObjects(clusterer, &objects);
+    assert(!tracker.model_.empty());
+    objects = MakeFrame(patches);
+    tracker.AssignGroupsToObjects(clusterer, &objects);
+    assert((clusterer.num_of_calls == 1) && (tracker.num_of_hits() == 3));
+    patches[1].rect.y += 40;  // moved
+    patches.push_back({cv::Rect(10, 120, 40, 40), cv::Scalar(0, 0, 255)});
+    objects = MakeFrame(patches);
+    assert(tracker.AssignGroupsToObjects(clusterer, &objects) == 3);
+    assert((clusterer.num_of_calls == 1) && (clusterer.num_of_objects == 3));
+    assert((tracker.num_of_hits() == 5) && (tracker.num_of_misses() == 5));
+    assert(objects[1].group() == 1);
+    assert(objects[3].group() == 2);
+    // the features of the hits are carried over, and the new ones kept:
+    objects = MakeFrame(patches);
+    tracker.AssignGroupsToObjects(clusterer, &objects);
+    assert((tracker.num_of_hits() == 9) && (tracker.num_of_misses() == 5));
+    for (int i = 0; i < 4; i++) {
+      assert(tracker.tracks_[i].features ==
+             ExtractFeatures(objects[i].image()));
+    }
+    // a frame without a hit is clustered as a whole again:
+    objects = MakeFrame({{cv::Rect(150, 150, 30, 30), cv::Scalar(0, 255, 0)}});
+    tracker.AssignGroupsToObjects(clusterer, &objects);
+    assert((clusterer.num_of_calls == 2) && (clusterer.num_of_objects == 4));
+    // and so is the first frame after a reset:
+    tracker.Reset();
+    assert(tracker.model_.empty());
+    objects = MakeFrame(patches);
+    tracker.AssignGroupsToObjects(clusterer, &objects);
+    assert(clusterer.num_of_calls == 3);
+    return true;
+  }
+};
+}  // namespace object_clustering
+
+#endif  // OBJECT_CLUSTERING_OBJECT_TRACKER_TEST_H_
@@ -0,0 +1,106 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// pooling_mat_allocator_test.h
+// Object clustering
+// A friend-test class for PoolingMatAllocator class.
+#ifndef OBJECT_CLUSTERING_POOLING_MAT_ALLOCATOR_TEST_H_
+#define OBJECT_CLUSTERING_POOLING_MAT_ALLOCATOR_TEST_H_
+
+#include <cassert>
+
+#include "opencv2/core/core.hpp"
+
+#include "pooling_mat_allocator.h"
+
+namespace object_clustering {
+class PoolingMatAllocatorTest {
+ public:
+  static bool TestPoolingMatAllocator() {
+    PoolingMatAllocatorTest allocator_test;
+    return allocator_test.TestSizeClasses() &&
+           allocator_test.TestReuse() &&
+           allocator_test.TestMatrices() &&
+           allocator_test.TestTrim();
+  }
+  bool TestSizeClasses() {
+    size_t class_bytes;
+    assert(PoolingMatAllocator::SizeClassOf(1, &class_bytes) == 0);
+    assert(class_bytes == kMinPooledBlockBytes);
+    assert(PoolingMatAllocator::SizeClassOf(kMinPooledBlockBytes,
+                                            &class_bytes) == 0);
+    assert(PoolingMatAllocator::SizeClassOf(kMinPooledBlockBytes + 1,
+                                            &class_bytes) == 1);
+    assert(class_bytes == kMinPooledBlockBytes * 5 / 4);
+    assert(PoolingMatAllocator::SizeClassOf(kMinPooledBlockBytes * 2,
+                                            &class_bytes) == 4);
+    assert(class_bytes == kMinPooledBlockBytes * 2);
+    // a buffer is never more than a quarter bigger than asked for:
+    for (size_t bytes = 1; bytes < (1 << 22); bytes = bytes * 3 + 1) {
+      PoolingMatAllocator::SizeClassOf(bytes, &class_bytes);
+      assert(class_bytes >= bytes);
+      assert((bytes < kMinPooledBlockBytes) ||
+             (class_bytes <= bytes + bytes / 4));
+    }
+    return true;
+  }
+  // A released buffer goes to the next matrix of its size class:
+  bool TestReuse() {
+    PoolingMatAllocator allocator;
+    int sizes[] = {100, 100};
+    size_t step[2];
+    int *refcount;
+    uchar *datastart, *data;
+    allocator.allocate(2, sizes, CV_8UC3, refcount, datastart, data, step);
+    assert((step[0] == 300) && (step[1] == 3));
+    assert(*refcount == 1);
+    assert(reinterpret_cast<uchar*>(refcount) >= data + 100 * 300);
+    uchar *first_data = data;
+    allocator.deallocate(refcount, datastart, data);
+    assert(allocator.pooled_bytes() > 0);
+    // a bit smaller, the same class:
+    sizes[0] = 99;
+    allocator.allocate(2, sizes, CV_8UC3, refcount, datastart, data, step);
+    assert(data == first_data);
+    assert((allocator.num_of_allocations() == 1) &&
+           (allocator.num_of_reuses() == 1));
+    assert(allocator.pooled_bytes() == 0);
+    // a bigger one, while the first one is in use:
+    int *refcount2;
+    uchar *datastart2, *data2;
+    sizes[0] = 400;
+    allocator.allocate(2, sizes, CV_8UC3, refcount2, datastart2, data2, step);
+    assert(data2 != data);
+    assert(allocator.num_of_allocations() == 2);
+    allocator.deallocate(refcount, datastart, data);
+    allocator.deallocate(refcount2, datastart2, data2);
+    return true;
+  }
+  bool TestMatrices() {
+    PoolingMatAllocator allocator;
+    for (int i = 0; i < 10; i++) {
+      cv::Mat mat;
+      mat.allocator = &allocator;
+      mat.create(240 + i, 320, CV_8UC1);
+      mat.setTo(cv::Scalar(i));
+      cv::Mat copy = mat;  // shares the buffer
+      assert(copy.data == mat.data);
+    }
+    assert(allocator.num_of_allocations() == 1);
+    assert(allocator.num_of_reuses() == 9);
+    return true;
+  }
+  bool TestTrim() {
+    PoolingMatAllocator allocator;
+    cv::Mat mat;
+    mat.allocator = &allocator;
+    mat.create(100, 100, CV_32FC1);
+    mat.release();
+    assert(allocator.pooled_bytes() > 0);
+    allocator.Trim();
+    assert(allocator.pooled_bytes() == 0);
+    mat.create(100, 100, CV_32FC1);
+    assert(allocator.num_of_allocations() == 2);
+    return true;
+  }
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_POOLING_MAT_ALLOCATOR_TEST_H_
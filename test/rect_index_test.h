@@ -0,0 +1,91 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// rect_index_test.h
+// Object clustering
+// A test class for RectIndex and SuppressNestedRects(..).
+#ifndef OBJECT_CLUSTERING_RECT_INDEX_TEST_H_
+#define OBJECT_CLUSTERING_RECT_INDEX_TEST_H_
+
+#include <cassert>
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "rect_index.h"
+
+namespace object_clustering {
+class RectIndexTest {
+ public:
+  static bool TestRectIndex() {
+    RectIndexTest index_test;
+    return index_test.TestFindContaining() &&
+           index_test.TestSuppressNestedRects() &&
+           index_test.TestSameAsPairwise();
+  }
+  bool TestFindContaining() {
+    RectIndex index({cv::Rect(0, 0, 100, 100), cv::Rect(50, 50, 10, 10),
+                     cv::Rect(-30, -30, 40, 40), cv::Rect(5, 5, 0, 0)});
+    std::vector<int> containing;
+    index.FindContaining(cv::Point(55, 55), &containing);
+    assert((containing == std::vector<int>{0, 1}));
+    index.FindContaining(cv::Point(5, 5), &containing);
+    assert((containing == std::vector<int>{0, 2}));
+    // the right and the bottom edges are outside:
+    index.FindContaining(cv::Point(100, 0), &containing);
+    assert(containing.empty());
+    index.FindContaining(cv::Point(-100, 0), &containing);
+    assert(containing.empty());
+    RectIndex empty_index((std::vector<cv::Rect>()));
+    empty_index.FindContaining(cv::Point(0, 0), &containing);
+    assert(containing.empty());
+    return true;
+  }
+  // A rect whose center is inside a bigger one is suppressed, whatever their
+  // order; overlapping rects are kept:
+  bool TestSuppressNestedRects() {
+    cv::Rect r(0, 0, 1000, 1000);
+    cv::Rect r2(100, 100, 500, 500);
+    assert((SuppressNestedRects({r, r2}) == std::vector<int>{0}));
+    cv::Rect r3(0, 0, 200, 400);
+    cv::Rect r4(600, 0 , 30, 40);
+    assert((SuppressNestedRects({r3, r4}) == std::vector<int>{0, 1}));
+    cv::Rect r5(10, 10, 100, 100);
+    cv::Rect r6(90, 90, 200, 200);
+    assert((SuppressNestedRects({r5, r6}) == std::vector<int>{0, 1}));
+    cv::Rect r7(-50, -50, 100, 100);
+    cv::Rect r8(-1, -1, 80, 80);
+    cv::Rect r9(-100, -100, 300, 300);
+    assert((SuppressNestedRects({r7, r8, r9}) == std::vector<int>{2}));
+    assert(SuppressNestedRects({}).empty());
+    return true;
+  }
+  // Many rects of very different sizes, nested and overlapping:
+  bool TestSameAsPairwise() {
+    cv::RNG rng(7);
+    std::vector<cv::Rect> rectangles;
+    for (int i = 0; i < 2000; i++) {
+      int side = i % 10 == 0 ? rng.uniform(100, 600) : rng.uniform(1, 40);
+      rectangles.push_back(cv::Rect(rng.uniform(-50, 1280),
+                                    rng.uniform(-50, 960),
+                                    side, rng.uniform(1, 2 * side)));
+    }
+    std::vector<int> expected;
+    for (int i = 0; i < static_cast<int>(rectangles.size()); i++) {
+      const cv::Rect &rect = rectangles[i];
+      cv::Point center(rect.x + rect.width/2, rect.y + rect.height/2);
+      bool nested = false;
+      for (int j = 0; j < static_cast<int>(rectangles.size()); j++) {
+        if ((j != i) && rectangles[j].contains(center) &&
+            (rect.area() < rectangles[j].area())) {
+          nested = true;
+        }
+      }
+      if (!nested) expected.push_back(i);
+    }
+    assert(SuppressNestedRects(rectangles) == expected);
+    return true;
+  }
+};
+}  // namespace object_clustering
+
+#endif  // OBJECT_CLUSTERING_RECT_INDEX_TEST_H_
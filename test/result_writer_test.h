@@ -0,0 +1,120 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// result_writer_test.h
+// Object clustering
+// A test class for ResultWriter class: the records it writes are read back.
+#ifndef OBJECT_CLUSTERING_RESULT_WRITER_TEST_H_
+#define OBJECT_CLUSTERING_RESULT_WRITER_TEST_H_
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "image.h"
+#include "object.h"
+#include "result_writer.h"
+
+namespace object_clustering {
+class ResultWriterTest {
+ public:
+  static bool TestResultWriter() {
+    ResultWriterTest writer_test;
+    return writer_test.TestJsonRecords() &&
+           writer_test.TestBinaryRecords();
+  }
+  // Two objects of a frame, in groups 1 and -1 (none):
+  std::vector<Object> SampleObjects(const cv::Mat &frame) {
+    std::vector<Object> objects;
+    cv::Rect first(1, 2, 3, 4);
+    cv::Rect second(10, 20, 5, 6);
+    objects.push_back(Object(Image(frame(first), first)));
+    objects.push_back(Object(Image(frame(second), second)));
+    objects[0].set_group(1);
+    return objects;
+  }
+  // Writes a frame with objects, one without any and one whose name needs
+  // escaping, in format, into the current directory:
+  void WriteSampleResults(const RecordFormat &format) {
+    cv::Mat frame(40, 40, CV_8UC3, cv::Scalar(0, 0, 0));
+    ResultWriter writer(".", false, format);
+    assert(writer.IsOpened());
+    writer.Write("frame_0", frame, SampleObjects(frame), 2);
+    writer.Write("frame_1", frame, std::vector<Object>(), 0);
+    writer.Write("a \"b\"", frame, SampleObjects(frame), 2);
+    writer.Close();
+    assert(writer.num_of_errors() == 0);
+    writer.Write("after_close", frame, SampleObjects(frame), 2);  // ignored
+  }
+  bool TestJsonRecords() {
+    const std::string filename = "./results.json";
+    std::remove(filename.c_str());
+    WriteSampleResults(kJsonRecords);
+    const std::string objects =
+        "[{\"x\": 1, \"y\": 2, \"width\": 3, \"height\": 4, \"group\": 1}, "
+        "{\"x\": 10, \"y\": 20, \"width\": 5, \"height\": 6, \"group\": -1}]";
+    std::vector<std::string> expected = {
+      "{\"name\": \"frame_0\", \"num_of_groups\": 2, \"objects\": " +
+          objects + "}\n",
+      "{\"name\": \"frame_1\", \"num_of_groups\": 0, \"objects\": []}\n",
+      "{\"name\": \"a \\\"b\\\"\", \"num_of_groups\": 2, \"objects\": " +
+          objects + "}\n"
+    };
+    FILE *file = fopen(filename.c_str(), "r");
+    assert(file != nullptr);
+    std::vector<std::string> lines;
+    char line[1024];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+      lines.push_back(line);
+    }
+    fclose(file);
+    assert(lines == expected);
+    std::remove(filename.c_str());
+    return true;
+  }
+  bool TestBinaryRecords() {
+    const std::string filename = "./results.bin";
+    std::remove(filename.c_str());
+    WriteSampleResults(kBinaryRecords);
+    FILE *file = fopen(filename.c_str(), "rb");
+    assert(file != nullptr);
+    auto read_int = [&]() {
+      int32_t value = 0;
+      size_t num_of_read = fread(&value, sizeof(value), 1, file);
+      assert(num_of_read == 1);
+      return value;
+    };
+    auto read_name = [&]() {
+      std::string name(read_int(), ' ');
+      size_t num_of_read = fread(&name[0], 1, name.size(), file);
+      assert(num_of_read == name.size());
+      return name;
+    };
+    for (std::string name : {"frame_0", "frame_1", "a \"b\""}) {
+      std::string read = read_name();
+      int num_of_groups = read_int();
+      int num_of_objects = read_int();
+      bool empty = name == "frame_1";
+      assert(read == name);
+      assert(num_of_groups == (empty ? 0 : 2));
+      assert(num_of_objects == (empty ? 0 : 2));
+      if (empty) continue;
+      std::vector<int32_t> values;
+      for (int i = 0; i < 10; i++) {
+        values.push_back(read_int());
+      }
+      assert(values == std::vector<int32_t>({1, 2, 3, 4, 1,
+                                             10, 20, 5, 6, -1}));
+    }
+    int end = fgetc(file);
+    assert(end == EOF);
+    fclose(file);
+    std::remove(filename.c_str());
+    return true;
+  }
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_RESULT_WRITER_TEST_H_
@@ -4,17 +4,82 @@
 // Tests for created classes and functions
 
 #include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <new>
 #include "image_test.h"
 #include "object_test.h"
 #include "object_detector_test.h"
 #include "k_means_clustering_algorithm_test.h"
+#include "connected_component_labeler_test.h"
+#include "background_model_test.h"
+#include "batch_processor_test.h"
+#include "feature_matrix_test.h"
+#include "native_k_means_clustering_algorithm_test.h"
+#include "mini_batch_k_means_clustering_algorithm_test.h"
+#include "cluster_metrics_test.h"
+#include "feature_descriptor_test.h"
+#include "rect_index_test.h"
+#include "image_source_test.h"
+#include "frame_container_test.h"
+#include "feature_store_test.h"
+#include "cluster_model_test.h"
+#include "incremental_cluster_algorithm_test.h"
+#include "object_tracker_test.h"
+#include "pooling_mat_allocator_test.h"
+#include "bounded_queue_test.h"
+#include "frame_stream_test.h"
+#include "thread_pool_test.h"
+#include "result_writer_test.h"
+
+// Every operator new of the tests is counted, see
+// ObjectDetectorTest::TestWorkspace(); the matrices allocate with
+// cv::fastMalloc(..), which is not:
+std::atomic<int64_t> object_clustering::num_of_heap_allocations(0);
+
+void* operator new(std::size_t size) {
+  object_clustering::num_of_heap_allocations++;
+  void *pointer = std::malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) throw std::bad_alloc();
+  return pointer;
+}
+
+void operator delete(void *pointer) noexcept {
+  std::free(pointer);
+}
 
 int main() {
   //object_clustering::ImageTest::TestImage();
+  object_clustering::ImageTest::TestImageWithoutDisplay();
   //object_clustering::ObjectTest::TestObject();
   //object_clustering::ObjectDetectorTest::TestObjectDetector();
+  object_clustering::ObjectDetectorTest::TestObjectDetectorWithoutDisplay();
   object_clustering::KMeansClusteringAlgorithmTest::
                      TestKMeansClusteringAlgorithm();
+  object_clustering::ConnectedComponentLabelerTest::
+                     TestConnectedComponentLabeler();
+  object_clustering::BackgroundModelTest::TestBackgroundModel();
+  object_clustering::BatchProcessorTest::TestBatchProcessor();
+  object_clustering::FeatureMatrixTest::TestFeatureMatrix();
+  object_clustering::NativeKMeansClusteringAlgorithmTest::
+                     TestNativeKMeansClusteringAlgorithm();
+  object_clustering::MiniBatchKMeansClusteringAlgorithmTest::
+                     TestMiniBatchKMeansClusteringAlgorithm();
+  object_clustering::ClusterMetricsTest::TestClusterMetrics();
+  object_clustering::FeatureDescriptorTest::TestFeatureDescriptor();
+  object_clustering::RectIndexTest::TestRectIndex();
+  object_clustering::ImageSourceTest::TestImageSource();
+  object_clustering::FrameContainerTest::TestFrameContainer();
+  object_clustering::FeatureStoreTest::TestFeatureStore();
+  object_clustering::ClusterModelTest::TestClusterModel();
+  object_clustering::IncrementalClusterAlgorithmTest::
+                     TestIncrementalClusterAlgorithm();
+  object_clustering::ObjectTrackerTest::TestObjectTracker();
+  object_clustering::PoolingMatAllocatorTest::TestPoolingMatAllocator();
+  object_clustering::BoundedQueueTest::TestBoundedQueue();
+  object_clustering::FrameStreamTest::TestFrameStream();
+  object_clustering::ThreadPoolTest::TestThreadPool();
+  object_clustering::ResultWriterTest::TestResultWriter();
   printf("All tests passed. \n");
   return 0;
 }
@@ -0,0 +1,105 @@
+// Copyright Max Chetrusca, Oct 17 2026
+// thread_pool_test.h
+// Object clustering
+// A test class for ThreadPool class.
+#ifndef OBJECT_CLUSTERING_THREAD_POOL_TEST_H_
+#define OBJECT_CLUSTERING_THREAD_POOL_TEST_H_
+
+#include <cassert>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace object_clustering {
+class ThreadPoolTest {
+ public:
+  static bool TestThreadPool() {
+    ThreadPoolTest pool_test;
+    return pool_test.TestSubmitAndWait() &&
+           pool_test.TestParallelFor() &&
+           pool_test.TestConcurrentCallers() &&
+           pool_test.TestExceptions();
+  }
+  bool TestSubmitAndWait() {
+    ThreadPool pool(3);
+    assert(pool.num_of_threads() == 3);
+    assert(ThreadPool(0).num_of_threads() > 0);
+    std::atomic<int> sum(0);
+    for (int i = 1; i <= 100; i++) {
+      pool.Submit([&sum, i]() { sum += i; });
+    }
+    pool.Wait();
+    assert(sum == 5050);
+    return true;
+  }
+  // Every index of the range is run exactly once, and none outside it:
+  bool TestParallelFor() {
+    ThreadPool pool(4);
+    for (int n : {0, 1, 3, 1000}) {
+      std::vector<std::atomic<int>> times_run(n + 2);
+      for (auto &times : times_run) times = 0;
+      pool.ParallelFor(1, n + 1, [&](int i) { times_run[i]++; });
+      assert(times_run[0] == 0);
+      for (int i = 1; i <= n; i++) {
+        assert(times_run[i] == 1);
+      }
+      assert(times_run[n + 1] == 0);
+    }
+    pool.ParallelFor(5, 2, [&](int) { assert(false); });  // an empty range
+    return true;
+  }
+  // Each caller waits for its own indices only, whatever the others submit:
+  bool TestConcurrentCallers() {
+    const int kNumOfCallers = 4;
+    const int kNumOfIndices = 500;
+    ThreadPool pool(3);
+    std::vector<std::vector<int>> results(kNumOfCallers,
+                                          std::vector<int>(kNumOfIndices, 0));
+    std::vector<std::thread> callers;
+    for (int c = 0; c < kNumOfCallers; c++) {
+      callers.push_back(std::thread([&, c]() {
+        for (int round = 1; round <= 5; round++) {
+          pool.ParallelFor(0, kNumOfIndices, [&, c, round](int i) {
+            results[c][i] = round * (c + i);
+          });
+          // the call has returned, so every index of this round is written:
+          for (int i = 0; i < kNumOfIndices; i++) {
+            assert(results[c][i] == round * (c + i));
+          }
+        }
+      }));
+    }
+    for (auto &caller : callers) {
+      caller.join();
+    }
+    return true;
+  }
+  // A throwing index does not stop the others, the exception reaches the
+  // caller, and the pool is still usable afterwards:
+  bool TestExceptions() {
+    ThreadPool pool(2);
+    std::atomic<int> num_of_runs(0);
+    bool thrown = false;
+    try {
+      pool.ParallelFor(0, 100, [&](int i) {
+        num_of_runs++;
+        if (i % 10 == 3) throw std::runtime_error("index " + std::to_string(i));
+      });
+    } catch (const std::runtime_error &error) {
+      thrown = true;
+    }
+    assert(thrown);
+    assert(num_of_runs == 100);
+    std::atomic<int> sum(0);
+    pool.ParallelFor(0, 10, [&](int i) { sum += i; });
+    assert(sum == 45);
+    return true;
+  }
+};
+}  // namespace object_clustering
+#endif  // OBJECT_CLUSTERING_THREAD_POOL_TEST_H_